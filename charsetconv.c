@@ -0,0 +1,136 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <map>
+#include <unordered_map>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <vdr/tools.h>
+
+#include "charsetconv.h"
+#include "stats.h"
+
+typedef std::shared_ptr<const std::string> Converted;
+
+class CharsetConvTable
+{
+  public:
+    CharsetConvTable() { pthread_mutex_init(&lock, NULL); }
+
+    pthread_mutex_t lock;
+    std::unordered_map<std::string, Converted> entries;
+};
+
+// One table per charset pair, never freed
+static pthread_mutex_t tablesLock = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, CharsetConvTable*>* tables = NULL;
+
+CharsetConv::CharsetConv(const char* fromCode, const char* toCode)
+{
+  conv = new cCharSetConv(fromCode, toCode);
+
+  std::string name(fromCode ? fromCode : cCharSetConv::SystemCharacterTable() ? cCharSetConv::SystemCharacterTable() : "");
+  name += '>';
+  name += toCode ? toCode : "";
+
+  pthread_mutex_lock(&tablesLock);
+  if (!tables) tables = new std::map<std::string, CharsetConvTable*>;
+  CharsetConvTable*& t = (*tables)[name];
+  if (!t) t = new CharsetConvTable;
+  table = t;
+  pthread_mutex_unlock(&tablesLock);
+}
+
+CharsetConv::~CharsetConv()
+{
+  delete conv;
+}
+
+const char* CharsetConv::convert(const char* from)
+{
+  if (!from || isAscii(from)) return from;
+  return conv->Convert(from);
+}
+
+const char* CharsetConv::convertStable(const char* from)
+{
+  if (!from || isAscii(from)) return from;
+
+  Stats* stats = Stats::getInstance();
+  std::string key(from);
+
+  pthread_mutex_lock(&table->lock);
+  std::unordered_map<std::string, Converted>::const_iterator i = table->entries.find(key);
+  if (i != table->entries.end())
+  {
+    held = i->second;
+    pthread_mutex_unlock(&table->lock);
+    if (stats) stats->cacheHit(Stats::CACHE_CHARSETCONV);
+    return held->c_str();
+  }
+  pthread_mutex_unlock(&table->lock);
+
+  if (stats) stats->cacheMiss(Stats::CACHE_CHARSETCONV);
+  held.reset(new std::string(conv->Convert(from)));
+
+  pthread_mutex_lock(&table->lock);
+  if (table->entries.size() >= STABLE_ENTRIES) table->entries.clear(); // results handed out stay alive through held
+  table->entries[key] = held;
+  pthread_mutex_unlock(&table->lock);
+  return held->c_str();
+}
+
+#ifdef __SSE2__
+// Reads whole aligned 16 byte blocks, which can go past the terminator
+// but never into another page
+__attribute__((no_sanitize_address))
+#endif
+bool CharsetConv::isAscii(const char* s)
+{
+#ifdef __SSE2__
+  while ((uintptr_t)s & 15)
+  {
+    if (!*s) return true;
+    if (*s & 0x80) return false;
+    s++;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  for (;;)
+  {
+    __m128i block = _mm_load_si128((const __m128i*)s);
+    unsigned int high = _mm_movemask_epi8(block);
+    unsigned int end = _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+    if (end) return !(high & ((end & -end) - 1)); // only the bytes before the terminator count
+    if (high) return false;
+    s += 16;
+  }
+#else
+  for (; *s; s++)
+  {
+    if (*s & 0x80) return false;
+  }
+  return true;
+#endif
+}
@@ -0,0 +1,64 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef CHARSETCONV_H
+#define CHARSETCONV_H
+
+#include <string>
+#include <memory>
+
+#include "defines.h"
+
+class cCharSetConv;
+class CharsetConvTable;
+
+/*
+  Charset conversion for strings sent to clients. Plain ASCII is the same
+  in every charset a client can ask for, so it is handed back as it is
+  without going through iconv. convertStable() also remembers what it
+  converted, in a table shared by all converters between the same
+  charsets; use it for texts that are sent again and again, such as
+  channel names, EPG texts and recording names.
+
+  Like cCharSetConv, a converter is for one thread only, and a converted
+  string is valid until the next call.
+*/
+
+class CharsetConv
+{
+  public:
+    CharsetConv(const char* fromCode, const char* toCode); // NULL: the system charset
+    ~CharsetConv();
+
+    const char* convert(const char* from);
+    const char* convertStable(const char* from);
+    cCharSetConv* getConv() { return conv; }
+
+    static bool isAscii(const char* s);
+
+    const static ULONG STABLE_ENTRIES = 16384; // per charset pair, then it starts over
+
+  private:
+    cCharSetConv* conv;
+    CharsetConvTable* table;
+    std::shared_ptr<const std::string> held; // keeps the last result of convertStable alive
+};
+
+#endif
@@ -19,21 +19,327 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
+#include <unistd.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/inotify.h>
+#include <map>
+
 #include "config.h"
+#include "thread.h"
+
+/*
+  One thread writes back the changed files of all Config objects, each
+  WRITE_DELAY ms after its last change, so a client saving its settings
+  key by key costs one write. Started on the first change.
+*/
+
+class ConfigWriter : public Thread
+{
+  public:
+    ConfigWriter();
+    ~ConfigWriter();
+    void schedule(Config* config);
+    void cancel(Config* config);
+
+  private:
+    void threadMethod();
+    static ULLONG nowMs();
+
+    pthread_mutex_t startLock;
+    int started;
+    std::map<Config*, ULLONG> pending; // -> when to write, under threadLock
+};
+
+static ConfigWriter configWriter;
+
+ConfigWriter::ConfigWriter()
+{
+  pthread_mutex_init(&startLock, NULL);
+  started = 0;
+}
+
+ConfigWriter::~ConfigWriter()
+{
+  if (started) threadStop();
+  pthread_mutex_destroy(&startLock);
+}
+
+ULLONG ConfigWriter::nowMs()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (ULLONG)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void ConfigWriter::schedule(Config* config)
+{
+  pthread_mutex_lock(&startLock);
+  if (!started)
+  {
+    if (!threadStart())
+    {
+      pthread_mutex_unlock(&startLock);
+      config->flush();
+      return;
+    }
+    started = 1;
+  }
+  pthread_mutex_unlock(&startLock);
+
+  threadLock();
+  pending[config] = nowMs() + Config::WRITE_DELAY;
+  threadSignalNoLock();
+  threadUnlock();
+}
+
+void ConfigWriter::cancel(Config* config)
+{
+  if (!started) return;
+  threadLock();
+  pending.erase(config); // and if it is being written, that has finished now
+  threadUnlock();
+}
+
+void ConfigWriter::threadMethod()
+{
+  threadLock();
+  while (threadIsActive())
+  {
+    if (pending.empty())
+    {
+      threadWaitForSignal();
+      continue;
+    }
+
+    std::map<Config*, ULLONG>::iterator next = pending.begin();
+    for (std::map<Config*, ULLONG>::iterator i = pending.begin(); i != pending.end(); i++)
+    {
+      if (i->second < next->second) next = i;
+    }
+
+    ULLONG due = next->second;
+    if (due <= nowMs())
+    {
+      // Written with the lock held, cancel() waits for it
+      Config* config = next->first;
+      pending.erase(next);
+      config->flush();
+      continue;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = due / 1000;
+    ts.tv_nsec = (due % 1000) * 1000000;
+    threadWaitForSignalTimed(&ts);
+  }
+
+  for (std::map<Config*, ULLONG>::iterator i = pending.begin(); i != pending.end(); i++) i->first->flush();
+  pending.clear();
+  threadUnlock();
+}
+
+/*
+  Reloads configs that are changed on disk, by an editor or anything
+  else. One inotify instance watches the directories of all open
+  configs; an event for a file reloads the Config objects open on it.
+  Started with the first config.
+*/
+
+class ConfigWatcher : public Thread
+{
+  public:
+    ConfigWatcher();
+    ~ConfigWatcher();
+    void add(Config* config, const char* fileName);
+    void remove(Config* config);
+
+  private:
+    void threadMethod();
+    void handleEvents();
+
+    struct Watched
+    {
+      Config* config;
+      int wd;
+      std::string name; // file name in the watched directory
+    };
+
+    pthread_mutex_t mutex;
+    int started;
+    int inotifyFD;
+    int stopPipe[2];
+    std::vector<Watched> watched;
+};
+
+static ConfigWatcher configWatcher;
+
+ConfigWatcher::ConfigWatcher()
+{
+  pthread_mutex_init(&mutex, NULL);
+  started = 0;
+  inotifyFD = -1;
+  stopPipe[0] = stopPipe[1] = -1;
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+  if (started)
+  {
+    if (write(stopPipe[1], "", 1) == 1) threadStop();
+    else threadCancel();
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    close(inotifyFD);
+  }
+  pthread_mutex_destroy(&mutex);
+}
+
+void ConfigWatcher::add(Config* config, const char* fileName)
+{
+  pthread_mutex_lock(&mutex);
+
+  if (!started)
+  {
+    inotifyFD = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if ((inotifyFD == -1) || pipe(stopPipe) || !threadStart())
+    {
+      Log::getInstance()->log("Config", Log::ERR, "Could not start watching config files, changes on disk need a restart");
+      if (inotifyFD != -1) close(inotifyFD);
+      inotifyFD = -1;
+      pthread_mutex_unlock(&mutex);
+      return;
+    }
+    started = 1;
+  }
+  if (inotifyFD == -1)
+  {
+    pthread_mutex_unlock(&mutex);
+    return;
+  }
+
+  std::string dir(fileName);
+  std::string name;
+  size_t slash = dir.rfind('/');
+  if (slash == std::string::npos)
+  {
+    name = dir;
+    dir = ".";
+  }
+  else
+  {
+    name = dir.substr(slash + 1);
+    dir.erase(slash ? slash : 1);
+  }
+
+  // Written in place or renamed over, as Config's own write back does.
+  // The same directory gives the same wd again
+  int wd = inotify_add_watch(inotifyFD, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd == -1)
+  {
+    Log::getInstance()->log("Config", Log::WARN, "Could not watch %s for changes", dir.c_str());
+  }
+  else
+  {
+    Watched w;
+    w.config = config;
+    w.wd = wd;
+    w.name = name;
+    watched.push_back(w);
+  }
+
+  pthread_mutex_unlock(&mutex);
+}
+
+void ConfigWatcher::remove(Config* config)
+{
+  pthread_mutex_lock(&mutex); // and if it is being reloaded, that has finished now
+
+  for (UINT i = 0; i < watched.size(); i++)
+  {
+    if (watched[i].config != config) continue;
+
+    int wd = watched[i].wd;
+    watched.erase(watched.begin() + i);
+
+    bool stillUsed = false;
+    for (UINT j = 0; j < watched.size(); j++)
+    {
+      if (watched[j].wd == wd) stillUsed = true;
+    }
+    if (!stillUsed) inotify_rm_watch(inotifyFD, wd);
+    break;
+  }
+
+  pthread_mutex_unlock(&mutex);
+}
+
+void ConfigWatcher::handleEvents()
+{
+  char events[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+  for (;;)
+  {
+    ssize_t length = read(inotifyFD, events, sizeof(events));
+    if (length <= 0) return;
+
+    pthread_mutex_lock(&mutex);
+    for (char* p = events; p < events + length; )
+    {
+      struct inotify_event* event = (struct inotify_event*)p;
+      p += sizeof(struct inotify_event) + event->len;
+      if (!event->len) continue;
+
+      // Reloaded with the lock held, remove() waits for it
+      for (UINT i = 0; i < watched.size(); i++)
+      {
+        if ((watched[i].wd == event->wd) && (watched[i].name == event->name)) watched[i].config->reload();
+      }
+    }
+    pthread_mutex_unlock(&mutex);
+  }
+}
+
+void ConfigWatcher::threadMethod()
+{
+  struct pollfd fds[2];
+  fds[0].fd = inotifyFD;
+  fds[0].events = POLLIN;
+  fds[1].fd = stopPipe[0];
+  fds[1].events = POLLIN;
+
+  while (threadIsActive())
+  {
+    if (poll(fds, 2, -1) <= 0) continue;
+    if (fds[1].revents) break;
+    if (fds[0].revents) handleEvents();
+  }
+}
+
+// Config
 
 Config::Config()
 {
   initted = 0;
-  lastLineLength = 0;
+  dirty = 0;
+  version = 0;
+  lastLineHasNewline = true;
   log = Log::getInstance();
+  pthread_rwlock_init(&lock, NULL);
+  pthread_mutex_init(&flushLock, NULL);
+}
+
+Config::~Config()
+{
+  shutdown();
+  pthread_rwlock_destroy(&lock);
+  pthread_mutex_destroy(&flushLock);
 }
 
 int Config::init(char* takeFileName)
 {
   if (initted) return 1;
 
-  pthread_mutex_init(&fileLock, NULL);
-
   if (strlen(takeFileName) > (MAX_FILENAME_LENGTH - 1))
   {
     log->log("Config", Log::DEBUG, "Config error: Config filename too long");
@@ -44,19 +350,10 @@ int Config::init(char* takeFileName)
   strcpy(fileNameTemp, takeFileName);
   strcat(fileNameTemp, ".tmp");
 
-  file = fopen(fileName, "r");
-  if (!file)
-  {
-    file = fopen(fileName, "w");
-    if (!file)
-    {
-      log->log("Config", Log::DEBUG, "Config error: Could not access config file");
-      return 0;
-    }
-  }
-  fclose(file);
+  if (!load()) return 0;
 
   initted = 1;
+  configWatcher.add(this, fileName);
   log->log("Config", Log::DEBUG, "Opened config file: %s", fileName);
 
   return 1;
@@ -71,122 +368,267 @@ int Config::shutdown()
 {
   if (!initted) return 1;
 
-  pthread_mutex_lock(&fileLock);
+  configWatcher.remove(this);
+  configWriter.cancel(this);
+  flush();
+
+  pthread_rwlock_wrlock(&lock);
   initted = 0;
-  pthread_mutex_unlock(&fileLock);
-  pthread_mutex_destroy(&fileLock);
+  lines.clear();
+  sections.clear();
+  values.clear();
+  pthread_rwlock_unlock(&lock);
 
   return 1;
 }
 
-int Config::openFile()
+int Config::readFile(std::vector<std::string>& fileLines, bool& lastNewline)
 {
-  if (!initted) return 0;
-  if (pthread_mutex_lock(&fileLock))
+  FILE* file = fopen(fileName, "r");
+  if (!file)
   {
-    log->log("Config", Log::DEBUG, "Config error: Could not get lock");
-    return 0;
+    file = fopen(fileName, "w");
+    if (!file)
+    {
+      log->log("Config", Log::DEBUG, "Config error: Could not access config file");
+      return 0;
+    }
   }
-  if (!initted)
+
+  fileLines.clear();
+  lastNewline = true;
+
+  char buffer[BUFFER_LENGTH];
+  std::string line;
+  while (fgets(buffer, BUFFER_LENGTH, file))
   {
-    log->log("Config", Log::DEBUG, "Config error: Initted 0 after lock");
-    pthread_mutex_unlock(&fileLock);
-    return 0;
+    int length = strlen(buffer);
+    if (length && (buffer[length - 1] == '\n'))
+    {
+      line.append(buffer, length - 1);
+      fileLines.push_back(line);
+      line.clear();
+    }
+    else
+    {
+      line.append(buffer, length);
+    }
+  }
+  if (line.length())
+  {
+    fileLines.push_back(line);
+    lastNewline = false;
   }
+  fclose(file);
+  return 1;
+}
 
-  file = fopen(fileName, "r");
-  if (!file)
+int Config::load()
+{
+  std::vector<std::string> fileLines;
+  bool lastNewline;
+  if (!readFile(fileLines, lastNewline)) return 0;
+
+  pthread_rwlock_wrlock(&lock);
+  lines.swap(fileLines);
+  lastLineHasNewline = lastNewline;
+  buildIndex();
+  dirty = 0;
+  version++;
+  pthread_rwlock_unlock(&lock);
+  return 1;
+}
+
+int Config::reload()
+{
+  if (!initted) return 0;
+
+  std::vector<std::string> fileLines;
+  bool lastNewline;
+  if (!readFile(fileLines, lastNewline)) return 0;
+
+  pthread_rwlock_wrlock(&lock);
+
+  // Our own write back comes through here too, and changes nothing
+  if ((fileLines == lines) && (lastNewline == lastLineHasNewline))
+  {
+    pthread_rwlock_unlock(&lock);
+    return 1;
+  }
+
+  if (dirty)
   {
-    log->log("Config", Log::DEBUG, "Config error: Could not open config file");
-    pthread_mutex_unlock(&fileLock);
+    // Changes of ours are waiting to be written, they will overwrite the edit
+    pthread_rwlock_unlock(&lock);
+    log->log("Config", Log::WARN, "%s changed on disk while changes to it are pending, ignored", fileName);
     return 0;
   }
+
+  lines.swap(fileLines);
+  lastLineHasNewline = lastNewline;
+  buildIndex();
+  version++;
+  pthread_rwlock_unlock(&lock);
+
+  log->log("Config", Log::INFO, "Reloaded %s", fileName);
   return 1;
 }
 
-void Config::closeFile()
+ULONG Config::getVersion()
 {
-  if (!initted) return;
+  return __atomic_load_n(&version, __ATOMIC_ACQUIRE);
+}
 
-  fclose(file);
-  file = NULL;
-  pthread_mutex_unlock(&fileLock);
+std::string Config::valueKey(const char* section, const char* key)
+{
+  std::string k(section);
+  k += '\0';
+  k += key;
+  return k;
 }
 
-int Config::readLine()
+// line has been through trim(). Returns 0 if it is not a key = value line
+int Config::parseKey(const char* line, std::string& key, std::string& value)
 {
-  if (!initted || !file) { log->log("Config", Log::DEBUG, "1"); return 0; }
-  if (!fgets(buffer, BUFFER_LENGTH-1, file)) { /*log->log("Config", Log::DEBUG, "2");*/ return 0; }
-  lastLineLength = strlen(buffer);
-//  log->log("Config", Log::DEBUG, "buffer before trim: '%s'", buffer);
-  trim(buffer);
-//  log->log("Config", Log::DEBUG, "buffer after trim: '%s'", buffer);
+  const char* equalspos = strchr(line, '=');
+  if (!equalspos) return 0;
+
+  std::vector<char> part(line, equalspos);
+  part.push_back('\0');
+  trim(&part[0]);
+  key = &part[0];
+
+  part.assign(equalspos + 1, line + strlen(line) + 1);
+  trim(&part[0]);
+  value = &part[0];
   return 1;
 }
 
-// START HERE
+/*
+  Index the lines the way the file used to be searched: the first
+  [section] header of a name counts, a key belongs to the header above
+  it, and the first of two equal keys in a section wins.
+*/
 
-FILE* Config::copyToHere(long position)
+void Config::buildIndex()
 {
-  FILE* newFile = fopen(fileNameTemp, "w");
+  sections.clear();
+  values.clear();
 
-  if (!newFile) return NULL;
+  std::string section;
+  bool inSection = false;
+  std::vector<char> buffer;
+  std::string key, value;
 
-  long newPos = 0;
-  rewind(file);
-
-  while (newPos < position)
+  for (UINT i = 0; i < lines.size(); i++)
   {
-    if (!fgets(buffer, BUFFER_LENGTH-1, file)) break;
-    fputs(buffer, newFile);
-    newPos += strlen(buffer);
+    buffer.assign(lines[i].begin(), lines[i].end());
+    buffer.push_back('\0');
+    char* trimmed = &buffer[0];
+    trim(trimmed);
+    int length = strlen(trimmed);
+    if (!length) continue;
+
+    if ((trimmed[0] == '[') && (trimmed[length - 1] == ']'))
+    {
+      section.assign(trimmed + 1, length - 2);
+      inSection = sections.insert(std::make_pair(section, (int)i)).second;
+      continue;
+    }
+
+    if (!inSection || !parseKey(trimmed, key, value)) continue;
+
+    Value v;
+    v.line = i;
+    v.value = value;
+    values.insert(std::make_pair(valueKey(section.c_str(), key.c_str()), v));
   }
-  return newFile;
 }
 
-int Config::copyRest(FILE* newFile)
+// With lock held
+const std::string* Config::findValue(const char* section, const char* key)
 {
-  if (newFile)
+  std::unordered_map<std::string, Value>::iterator i = values.find(valueKey(section, key));
+  if (i != values.end()) return &i->second.value;
+
+  if (sections.find(section) == sections.end())
+    LOG("Config", Log::DEBUG, "Config error: Section %s not found", section);
+  else
+    LOG("Config", Log::DEBUG, "Config error: Key %s not found", key);
+  return NULL;
+}
+
+// With the write lock held. The caller schedules the write back after unlocking
+void Config::changed()
+{
+  dirty = 1;
+  version++;
+}
+
+int Config::flush()
+{
+  pthread_mutex_lock(&flushLock);
+
+  pthread_rwlock_wrlock(&lock);
+  if (!dirty)
   {
-    while(fgets(buffer, BUFFER_LENGTH-1, file))
-    {
-      fputs(buffer, newFile);
-    }
+    pthread_rwlock_unlock(&lock);
+    pthread_mutex_unlock(&flushLock);
+    return 1;
+  }
 
-    fclose(newFile);
+  std::string content;
+  for (UINT i = 0; i < lines.size(); i++)
+  {
+    content += lines[i];
+    if (((i + 1) < lines.size()) || lastLineHasNewline) content += '\n';
   }
-  fclose(file);
-  file = NULL;
+  dirty = 0;
+  pthread_rwlock_unlock(&lock);
 
-  if (newFile) rename(fileNameTemp, fileName);
+  int success = 0;
+  FILE* newFile = fopen(fileNameTemp, "w");
+  if (newFile)
+  {
+    success = (fwrite(content.data(), 1, content.length(), newFile) == content.length());
+    if (fflush(newFile) || fsync(fileno(newFile))) success = 0;
+    if (fclose(newFile)) success = 0;
+    if (success && rename(fileNameTemp, fileName)) success = 0;
+  }
 
-  pthread_mutex_unlock(&fileLock);
-  return 1;
+  if (!success)
+  {
+    log->log("Config", Log::ERR, "Config error: Could not write config file %s", fileName);
+    pthread_rwlock_wrlock(&lock);
+    dirty = 1; // try again at the next change or shutdown
+    pthread_rwlock_unlock(&lock);
+  }
+
+  pthread_mutex_unlock(&flushLock);
+  return success;
 }
 
 int Config::deleteValue(const char* section, char* key)
 {
   if (!initted) return 0;
-  if (!openFile()) return 0;
 
-  if (!findSection(section))
-  {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Section %s not found", section);
-    return 0;
-  }
-  if (!findKey(key))
+  pthread_rwlock_wrlock(&lock);
+
+  std::unordered_map<std::string, Value>::iterator i = values.find(valueKey(section, key));
+  if (i == values.end())
   {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Key %s not found", key);
+    findValue(section, key); // for the log
+    pthread_rwlock_unlock(&lock);
     return 0;
   }
 
-  FILE* newFile = copyToHere(ftell(file) - lastLineLength);
-
-  if (  fgets(buffer, BUFFER_LENGTH-1, file)  );
+  lines.erase(lines.begin() + i->second.line);
+  buildIndex();
+  changed();
 
-  return copyRest(newFile);
+  pthread_rwlock_unlock(&lock);
+  configWriter.schedule(this);
+  return 1;
 }
 
 int Config::setValueLong(const char* section, char* key, long newValue)
@@ -213,186 +655,171 @@ int Config::setValueDouble(char* section, char* key, double newValue)
 int Config::setValueString(const char* section, const char* key, const char* newValue)
 {
   if (!initted) return 0;
-  if (!openFile()) return 0;
 
-  if (findSection(section))
-  {
-    if (findKey(key))
-    {
-      FILE* newFile = copyToHere(ftell(file) - lastLineLength);
-      if (!newFile)
-      {
-        closeFile();
-        log->log("Config", Log::DEBUG, "Config error: Could not write temp config file");
-        return 0;
-      }
+  pthread_rwlock_wrlock(&lock);
+  if (setLocked(section, key, newValue)) buildIndex();
+  changed();
+  pthread_rwlock_unlock(&lock);
 
-      if (  fgets(buffer, BUFFER_LENGTH-1, file)  );
-      fprintf(newFile, "%s = %s\n", key, newValue);
-      return copyRest(newFile);
-    }
-    else
-    {
-      rewind(file);
-      findSection(section);
-      FILE* newFile = copyToHere(ftell(file));
-      if (!newFile)
-      {
-        closeFile();
-        log->log("Config", Log::DEBUG, "Config error: Could not write temp config file");
-        return 0;
-      }
+  configWriter.schedule(this);
+  return 1;
+}
 
-      fprintf(newFile, "%s = %s\n", key, newValue);
-      return copyRest(newFile);
-    }
-  }
-  else
-  {
-    // section not found
-    fseek(file, 0, SEEK_END);
-    FILE* newFile = copyToHere(ftell(file));
-    if (!newFile)
-    {
-      closeFile();
-      log->log("Config", Log::DEBUG, "Config error: Could not write temp config file");
-      return 0;
-    }
+int Config::setValueStrings(const char* section, const KeyValues& newValues)
+{
+  if (!initted) return 0;
+  if (newValues.empty()) return 1;
 
-    fprintf(newFile, "[%s]\n%s = %s\n", section, key, newValue);
-    return copyRest(newFile);
+  pthread_rwlock_wrlock(&lock);
+  for (UINT i = 0; i < newValues.size(); i++)
+  {
+    // A new key moves the lines, index it before the next one is looked up
+    if (setLocked(section, newValues[i].first.c_str(), newValues[i].second.c_str())) buildIndex();
   }
+  changed();
+  pthread_rwlock_unlock(&lock);
+
+  configWriter.schedule(this);
+  return 1;
 }
 
-char* Config::getSectionKeyNames(const char* section, int& numberOfReturns, int& allKeysSize)
+// With the write lock held. Returns true if lines were added, then the index needs rebuilding
+bool Config::setLocked(const char* section, const char* key, const char* newValue)
 {
-  numberOfReturns = 0;
-  allKeysSize = 0;
-  char* allKeys = NULL;
-  int allKeysIndex = 0;
-  int keyLength;
-  char* equalspos;
-
-  if (!initted) return NULL;
-  if (!openFile()) return NULL;
-  if (!findSection(section)) return NULL;
-
-  char foundKey[BUFFER_LENGTH];
+  std::string line(key);
+  line += " = ";
+  line += newValue;
 
-  while(readLine())
+  std::unordered_map<std::string, Value>::iterator i = values.find(valueKey(section, key));
+  if (i != values.end())
   {
-    // Is this line a section header? if so, exit
-    if ((buffer[0] == '[') && (buffer[strlen(buffer)-1] == ']')) break;
-
-    equalspos = strstr(buffer, "=");
-    if (!equalspos) continue;  // if there is no = then it's not a key
-    memcpy(foundKey, buffer, equalspos-buffer);
-    foundKey[equalspos-buffer] = '\0';
-    trim(foundKey);
-    keyLength = strlen(foundKey);
-    allKeysSize += keyLength + 1;
-    allKeys = (char*)realloc(allKeys, allKeysSize);
-    memcpy(&allKeys[allKeysIndex], foundKey, keyLength);
-    allKeysIndex += keyLength;
-    allKeys[allKeysIndex] = '\0';
-    allKeysIndex++;
-    numberOfReturns++;
+    // Replace the line, the index stays valid
+    lines[i->second.line] = line;
+    std::vector<char> buffer(line.begin(), line.end());
+    buffer.push_back('\0');
+    trim(&buffer[0]);
+    std::string parsedKey;
+    parseKey(&buffer[0], parsedKey, i->second.value);
+    return false;
   }
 
-  closeFile();
-  return allKeys;
+  std::unordered_map<std::string, int>::iterator s = sections.find(section);
+  if (s != sections.end())
+  {
+    // New keys go straight under the section header
+    lines.insert(lines.begin() + s->second + 1, line);
+  }
+  else
+  {
+    std::string header("[");
+    header += section;
+    header += "]";
+    lines.push_back(header);
+    lines.push_back(line);
+    lastLineHasNewline = true;
+  }
+  return true;
 }
 
+int Config::getSectionValues(const char* section, KeyValues& sectionValues)
+{
+  sectionValues.clear();
+  if (!initted) return 0;
 
-// END HERE
+  pthread_rwlock_rdlock(&lock);
 
-int Config::findSection(const char* section)
-{
-  if (!initted || !file) return 0;
-  if (strlen(section) > (BUFFER_LENGTH-2))
+  std::unordered_map<std::string, int>::iterator s = sections.find(section);
+  if (s == sections.end())
   {
-    log->log("Config", Log::DEBUG, "Config error: Section given exceeds max length");
+    pthread_rwlock_unlock(&lock);
     return 0;
   }
 
-  char toFind[BUFFER_LENGTH];
-  toFind[0] = '[';
-  toFind[1] = '\0';
-  strcat(toFind, section);
-  strcat(toFind, "]");
+  std::vector<char> buffer;
+  std::string key, value;
 
-  while(readLine())
+  for (UINT i = s->second + 1; i < lines.size(); i++)
   {
-//    log->log("Config", Log::DEBUG, "to find '%s' this line '%s'", toFind, buffer);
-    if (!strcmp(toFind, buffer)) return 1;
+    buffer.assign(lines[i].begin(), lines[i].end());
+    buffer.push_back('\0');
+    char* trimmed = &buffer[0];
+    trim(trimmed);
+    int length = strlen(trimmed);
+    if (length && (trimmed[0] == '[') && (trimmed[length - 1] == ']')) break;
+    if (!parseKey(trimmed, key, value)) continue;
+
+    // Only the line that lookups find, not a later duplicate
+    std::unordered_map<std::string, Value>::iterator v = values.find(valueKey(section, key.c_str()));
+    if ((v != values.end()) && (v->second.line == (int)i)) sectionValues.push_back(std::make_pair(key, value));
   }
-  return 0;
+
+  pthread_rwlock_unlock(&lock);
+  return 1;
 }
 
-int Config::findKey(const char* key)
+char* Config::getSectionKeyNames(const char* section, int& numberOfReturns, int& allKeysSize)
 {
-  if (!initted || !file) return 0;
+  numberOfReturns = 0;
+  allKeysSize = 0;
+  char* allKeys = NULL;
+  int allKeysIndex = 0;
+  int keyLength;
+
+  if (!initted) return NULL;
 
-  if (strlen(key) > (BUFFER_LENGTH-1))
+  pthread_rwlock_rdlock(&lock);
+
+  std::unordered_map<std::string, int>::iterator s = sections.find(section);
+  if (s == sections.end())
   {
-    log->log("Config", Log::DEBUG, "Config error: Key given exceeds max length");
-    return 0;
+    pthread_rwlock_unlock(&lock);
+    return NULL;
   }
 
-  char prepForTest[BUFFER_LENGTH];
+  std::vector<char> buffer;
+  std::string key, value;
 
-  // do a rough search first, this could match substrings that we don't want
-  while(readLine())
+  for (UINT i = s->second + 1; i < lines.size(); i++)
   {
+    buffer.assign(lines[i].begin(), lines[i].end());
+    buffer.push_back('\0');
+    char* trimmed = &buffer[0];
+    trim(trimmed);
+    int length = strlen(trimmed);
+
     // Is this line a section header? if so, exit
-    if ((buffer[0] == '[') && (buffer[strlen(buffer)-1] == ']')) return 0;
-    if (strstr(buffer, key))
-    {
-      // rough search found match
-      char* equalspos = strstr(buffer, "=");
-      if (!equalspos) continue;
-      memcpy(prepForTest, buffer, equalspos-buffer);
-      prepForTest[equalspos-buffer] = '\0';
-      trim(prepForTest);
-
-      if (!strcmp(key, prepForTest))
-      {
-        // in buffer, set all up to equals to space, then trim!
-        for(char* curPos = buffer; curPos <= equalspos; curPos++)
-        {
-          *curPos = ' ';
-        }
-        trim(buffer);
-        return 1;
-      }
-    }
+    if (length && (trimmed[0] == '[') && (trimmed[length - 1] == ']')) break;
+
+    if (!parseKey(trimmed, key, value)) continue;  // if there is no = then it's not a key
+    keyLength = key.length();
+    allKeysSize += keyLength + 1;
+    allKeys = (char*)realloc(allKeys, allKeysSize);
+    memcpy(&allKeys[allKeysIndex], key.c_str(), keyLength);
+    allKeysIndex += keyLength;
+    allKeys[allKeysIndex] = '\0';
+    allKeysIndex++;
+    numberOfReturns++;
   }
-  return 0;
+
+  pthread_rwlock_unlock(&lock);
+  return allKeys;
 }
 
 char* Config::getValueString(const char* section, const char* key)
 {
   if (!initted) return NULL;
-  if (!openFile()) return NULL;
 
-  if (!findSection(section))
-  {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Section %s not found", section);
-    return 0;
-  }
-  if (!findKey(key))
+  pthread_rwlock_rdlock(&lock);
+
+  char* returnString = NULL;
+  const std::string* value = findValue(section, key);
+  if (value)
   {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Key %s not found", key);
-    return 0;
+    returnString = new char[value->length() + 1];
+    strcpy(returnString, value->c_str());
   }
 
-  char* returnString = new char[strlen(buffer)+1];
-  strcpy(returnString, buffer);
-
-  closeFile();
-
+  pthread_rwlock_unlock(&lock);
   return returnString;
 }
 
@@ -400,27 +827,20 @@ long Config::getValueLong(const char* section, const char* key, int* failure)
 {
   *failure = 1;
   if (!initted) return 0;
-  if (!openFile()) return 0;
 
-  if (!findSection(section))
-  {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Section %s not found", section);
-    return 0;
-  }
-  if (!findKey(key))
+  pthread_rwlock_rdlock(&lock);
+
+  long retVal = 0;
+  const std::string* value = findValue(section, key);
+  if (value)
   {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Key %s not found", key);
-    return 0;
+    *failure = 0;
+    char* check;
+    retVal = strtol(value->c_str(), &check, 10);
+    if ((retVal == 0) && (check == value->c_str())) *failure = 1;
   }
-  *failure = 0;
-
-  char* check;
-  long retVal = strtol(buffer, &check, 10);
-  if ((retVal == 0) && (check == buffer)) *failure = 1;
-  closeFile();
 
+  pthread_rwlock_unlock(&lock);
   return retVal;
 }
 
@@ -428,27 +848,20 @@ long long Config::getValueLongLong(char* section, char* key, int* failure)
 {
   *failure = 1;
   if (!initted) return 0;
-  if (!openFile()) return 0;
 
-  if (!findSection(section))
-  {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Section %s not found", section);
-    return 0;
-  }
-  if (!findKey(key))
+  pthread_rwlock_rdlock(&lock);
+
+  long long retVal = 0;
+  const std::string* value = findValue(section, key);
+  if (value)
   {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Key %s not found", key);
-    return 0;
+    *failure = 0;
+    char* check;
+    retVal = strtoll(value->c_str(), &check, 10);
+    if ((retVal == 0) && (check == value->c_str())) *failure = 1;
   }
-  *failure = 0;
-
-  char* check;
-  long long retVal = strtoll(buffer, &check, 10);
-  if ((retVal == 0) && (check == buffer)) *failure = 1;
-  closeFile();
 
+  pthread_rwlock_unlock(&lock);
   return retVal;
 }
 
@@ -456,34 +869,23 @@ double Config::getValueDouble(char* section, char* key, int* failure)
 {
   *failure = 1;
   if (!initted) return 0;
-  if (!openFile()) return 0;
 
-  if (!findSection(section))
-  {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Section %s not found", section);
-    return 0;
-  }
-  if (!findKey(key))
+  pthread_rwlock_rdlock(&lock);
+
+  double retVal = 0;
+  const std::string* value = findValue(section, key);
+  if (value)
   {
-    closeFile();
-    log->log("Config", Log::DEBUG, "Config error: Key %s not found", key);
-    return 0;
+    *failure = 0;
+    char* check;
+    retVal = strtod(value->c_str(), &check);
+    if ((retVal == 0) && (check == value->c_str())) *failure = 1;
   }
 
-  *failure = 0;
-
-  char* check;
-  double retVal = strtod(buffer, &check);
-  if ((retVal == 0) && (check == buffer)) *failure = 1;
-
-  closeFile();
-
+  pthread_rwlock_unlock(&lock);
   return retVal;
 }
 
-
-
 void Config::trim(char* str)
 {
   int pos, len, start, end;
@@ -27,20 +27,41 @@
 #include <string.h>
 #include <pthread.h>
 #include <ctype.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 #include "log.h"
 
 #define MAX_FILENAME_LENGTH 500
 #define BUFFER_LENGTH 1500
 
+/*
+  The file is read once by init() and kept as its lines plus a hash of
+  the sections and keys in it, behind a reader-writer lock. Lookups do
+  not touch the disk. Changes edit the lines in place and mark the
+  config dirty, the whole file is written back (temp file, then rename)
+  once no change has come in for WRITE_DELAY ms, by flush() or at
+  shutdown. Lines that are not changed are written back as they were
+  read, comments and all.
+
+  Changes made to the file on disk by anything else are picked up
+  through inotify and reloaded. getVersion() goes up with every change
+  either way, so state derived from the config can tell it is stale.
+*/
+
 class Config
 {
   public:
     Config();
+    ~Config();
 
     int init(char* fileName);
     int shutdown();
     int status();
+    int flush(); // write pending changes now
+    int reload(); // read the file again if it has changed
+    ULONG getVersion();
 
     char* getValueString(const char* section, const char* key);
     long getValueLong(const char* section, const char* key, int* failure);
@@ -55,26 +76,46 @@ class Config
     int deleteValue(const char* section, char* key); // err.. delete "key".
     char* getSectionKeyNames(const char* section, int& numberOfReturns, int& length);
 
+    typedef std::vector<std::pair<std::string, std::string> > KeyValues;
+
+    // All keys of a section with their values, in file order. 0 if there is no such section
+    int getSectionValues(const char* section, KeyValues& values);
+    // Sets all of them at once: readers see none or all of the changes
+    int setValueStrings(const char* section, const KeyValues& values);
+
+    const static int WRITE_DELAY = 1000; // ms
+
   private:
-    pthread_mutex_t fileLock;
+    pthread_rwlock_t lock;
+    pthread_mutex_t flushLock;
     int initted;
-    int lastLineLength;
+    int dirty;
+    ULONG version;
     Log* log;
 
     char fileName[MAX_FILENAME_LENGTH];
     char fileNameTemp[MAX_FILENAME_LENGTH];
 
-    FILE* file;
-    char buffer[BUFFER_LENGTH];
-
-    int openFile();
-    void closeFile();
-    int readLine();
-    int findSection(const char* section);
-    int findKey(const char* key);
-    void trim(char* sting);
-    FILE* copyToHere(long position);
-    int copyRest(FILE* newFile);
+    struct Value
+    {
+      int line;
+      std::string value;
+    };
+
+    std::vector<std::string> lines; // without the newlines
+    bool lastLineHasNewline;
+    std::unordered_map<std::string, int> sections;  // name -> line of the [header]
+    std::unordered_map<std::string, Value> values;  // section '\0' key -> value
+
+    int load();
+    int readFile(std::vector<std::string>& fileLines, bool& lastNewline);
+    void buildIndex();
+    const std::string* findValue(const char* section, const char* key);
+    void changed();
+    bool setLocked(const char* section, const char* key, const char* newValue);
+    static std::string valueKey(const char* section, const char* key);
+    static int parseKey(const char* line, std::string& key, std::string& value);
+    static void trim(char* sting);
 };
 
 #endif
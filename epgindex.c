@@ -0,0 +1,295 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <string.h>
+#include <algorithm>
+#include <vdr/config.h>
+
+#include "epgindex.h"
+#include "log.h"
+#include "stats.h"
+
+EpgIndex* EpgIndex::instance = NULL;
+
+EpgIndex::EpgIndex()
+{
+  if (instance) return;
+  instance = this;
+  pthread_mutex_init(&mutex, NULL);
+  lastVersion = time(NULL);
+}
+
+EpgIndex::~EpgIndex()
+{
+  if (instance != this) return;
+  instance = NULL;
+  pthread_mutex_destroy(&mutex);
+}
+
+EpgIndex* EpgIndex::getInstance()
+{
+  return instance;
+}
+
+// FNV-1a, over what the clients are sent of an event
+static ULONG hashBytes(ULONG hash, const void* data, size_t length)
+{
+  const UCHAR* p = (const UCHAR*)data;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= p[i];
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+static ULONG hashString(ULONG hash, const char* text)
+{
+  if (!text) text = "";
+  return hashBytes(hash, text, strlen(text) + 1);
+}
+
+static ULONG eventHash(ULONG hash, const cEvent* event)
+{
+  ULONG fields[3] = { (ULONG)event->EventID(), (ULONG)event->StartTime(), (ULONG)event->Duration() };
+  hash = hashBytes(hash, fields, sizeof(fields));
+  hash = hashString(hash, event->Title());
+  hash = hashString(hash, event->ShortText());
+  return hashString(hash, event->Description());
+}
+
+static bool inWindow(ULONG start, ULONG duration, ULONG windowStart, ULONG windowEnd, ULONG now)
+{
+  if (start >= windowEnd) return false;                   // duration filter
+  if ((start + duration) < now) return false;             // in the past filter
+  if ((start + duration) <= windowStart) return false;    // start time filter
+  return true;
+}
+
+#if VDRVERSNUM >= 20301
+
+// With the mutex held
+EpgIndex::Entry& EpgIndex::getEntry(const cSchedule* schedule)
+{
+  std::string channelID(*schedule->ChannelID().ToString());
+  std::unordered_map<std::string, Entry>::iterator i = entries.find(channelID);
+  if (i == entries.end())
+  {
+    Entry& entry = entries[channelID];
+    entry.schedule = schedule;
+    entry.state = -1;
+    entry.version = 0;
+    entry.removedSince = 0;
+    schedule->Modified(entry.state);
+    rebuild(entry);
+    return entry;
+  }
+
+  Entry& entry = i->second;
+  // Modified() also moves our state on. A schedule that was replaced by
+  // another one at the same address has its own counter, so the count
+  // is checked as well
+  bool modified = schedule->Modified(entry.state);
+  if (modified || (entry.schedule != schedule) || (entry.count != schedule->Events()->Count()))
+  {
+    entry.schedule = schedule;
+    rebuild(entry);
+  }
+  else
+  {
+    Stats* stats = Stats::getInstance();
+    if (stats) stats->cacheHit(Stats::CACHE_EPGINDEX);
+  }
+  return entry;
+}
+
+void EpgIndex::rebuild(Entry& entry)
+{
+  Stats* stats = Stats::getInstance();
+  if (stats) stats->cacheMiss(Stats::CACHE_EPGINDEX);
+
+  std::vector<Item> oldItems;
+  oldItems.swap(entry.items);
+  std::unordered_map<ULONG, UINT> oldByID;
+  for (UINT i = 0; i < oldItems.size(); i++) oldByID[oldItems[i].eventID] = i;
+  std::vector<bool> kept(oldItems.size(), false);
+
+  ULONG version = lastVersion + 1;
+  bool changed = (entry.version == 0);
+
+  const cList<cEvent>* events = entry.schedule->Events();
+  entry.items.reserve(events->Count());
+  entry.count = events->Count();
+  entry.maxDuration = 0;
+
+  bool sorted = true;
+  for (const cEvent* event = events->First(); event; event = events->Next(event))
+  {
+    Item item;
+    item.start = event->StartTime();
+    item.duration = event->Duration();
+    item.event = event;
+    item.eventID = event->EventID();
+    item.hash = eventHash(2166136261U, event);
+    item.changed = version;
+
+    std::unordered_map<ULONG, UINT>::const_iterator old = oldByID.find(item.eventID);
+    if (old != oldByID.end())
+    {
+      kept[old->second] = true;
+      if (oldItems[old->second].hash == item.hash) item.changed = oldItems[old->second].changed;
+    }
+    if (item.changed == version) changed = true;
+
+    if (!entry.items.empty() && (item.start < entry.items.back().start)) sorted = false;
+    if (item.duration > entry.maxDuration) entry.maxDuration = item.duration;
+    entry.items.push_back(item);
+  }
+
+  for (UINT i = 0; i < oldItems.size(); i++)
+  {
+    if (kept[i]) continue;
+    Removed removed;
+    removed.eventID = oldItems[i].eventID;
+    removed.version = version;
+    entry.removed.push_back(removed);
+    changed = true;
+  }
+  while (entry.removed.size() > MAX_REMOVED)
+  {
+    entry.removedSince = entry.removed.front().version;
+    entry.removed.pop_front();
+  }
+
+  // VDR keeps schedules sorted, this keeps its order for equal start times if not
+  if (!sorted)
+  {
+    std::stable_sort(entry.items.begin(), entry.items.end(),
+                     [](const Item& a, const Item& b) { return a.start < b.start; });
+  }
+
+  // VDR marks schedules modified on many EIT updates that change nothing
+  if (changed)
+  {
+    if (!entry.version) entry.removedSince = version;
+    entry.version = version;
+    lastVersion = version;
+  }
+
+  LOG("EpgIndex", Log::DEBUG, "Indexed %lu events of %s, version %lu", (ULONG)entry.items.size(), *entry.schedule->ChannelID().ToString(), entry.version);
+}
+
+std::vector<EpgIndex::Item>::const_iterator EpgIndex::windowStart(const Entry& entry, ULONG windowStart, ULONG now)
+{
+  // Nothing that starts earlier than this can still be running
+  ULONG earliest = std::max(windowStart, now);
+  earliest = (earliest > entry.maxDuration) ? earliest - entry.maxDuration : 0;
+
+  return std::lower_bound(entry.items.begin(), entry.items.end(), earliest,
+    [](const Item& item, ULONG time) { return item.start < time; });
+}
+
+#endif
+
+ULONG EpgIndex::getEvents(const cSchedule* schedule, ULONG windowStart, ULONG duration, std::vector<const cEvent*>& events)
+{
+  ULONG now = time(NULL);
+  ULONG windowEnd = windowStart + duration;
+
+#if VDRVERSNUM < 20301
+  // Nothing tells when to rebuild an index, walk the schedule
+  ULONG hash = 2166136261U;
+  const cList<cEvent>* list = schedule->Events();
+  for (const cEvent* event = list->First(); event; event = list->Next(event))
+  {
+    if (!inWindow(event->StartTime(), event->Duration(), windowStart, windowEnd, now)) continue;
+    events.push_back(event);
+    hash = eventHash(hash, event);
+  }
+  return hash ? hash : 1;
+#else
+  pthread_mutex_lock(&mutex);
+  Entry& entry = getEntry(schedule);
+
+  std::vector<Item>::const_iterator i = this->windowStart(entry, windowStart, now);
+  for (; (i != entry.items.end()) && (i->start < windowEnd); ++i)
+  {
+    if (inWindow(i->start, i->duration, windowStart, windowEnd, now)) events.push_back(i->event);
+  }
+
+  ULONG version = entry.version;
+  pthread_mutex_unlock(&mutex);
+  return version;
+#endif
+}
+
+int EpgIndex::getChanges(const cSchedule* schedule, ULONG windowStart, ULONG duration, ULONG since,
+                         ULONG& version, std::vector<const cEvent*>& events, std::vector<ULONG>& removed)
+{
+#if VDRVERSNUM < 20301
+  version = getEvents(schedule, windowStart, duration, events);
+  if (version != since) return SYNC_FULL;
+  events.clear();
+  return SYNC_UNCHANGED;
+#else
+  ULONG now = time(NULL);
+  ULONG windowEnd = windowStart + duration;
+
+  pthread_mutex_lock(&mutex);
+  Entry& entry = getEntry(schedule);
+  version = entry.version;
+
+  int result;
+  if (since == entry.version)
+  {
+    result = SYNC_UNCHANGED;
+  }
+  else if (!since || (since > entry.version) || (since < entry.removedSince))
+  {
+    // Nothing, from another run, or too far behind
+    std::vector<Item>::const_iterator i = this->windowStart(entry, windowStart, now);
+    for (; (i != entry.items.end()) && (i->start < windowEnd); ++i)
+    {
+      if (inWindow(i->start, i->duration, windowStart, windowEnd, now)) events.push_back(i->event);
+    }
+    result = SYNC_FULL;
+  }
+  else
+  {
+    // Changed events that are in the window are sent, the ones that moved
+    // out of it (or are over) are dropped like removed ones
+    for (std::vector<Item>::const_iterator i = entry.items.begin(); i != entry.items.end(); ++i)
+    {
+      if (i->changed <= since) continue;
+      if (inWindow(i->start, i->duration, windowStart, windowEnd, now)) events.push_back(i->event);
+      else removed.push_back(i->eventID);
+    }
+    for (std::deque<Removed>::const_reverse_iterator r = entry.removed.rbegin(); r != entry.removed.rend(); ++r)
+    {
+      if (r->version <= since) break;
+      removed.push_back(r->eventID);
+    }
+    result = SYNC_CHANGES;
+  }
+
+  pthread_mutex_unlock(&mutex);
+  return result;
+#endif
+}
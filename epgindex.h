@@ -0,0 +1,122 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef EPGINDEX_H
+#define EPGINDEX_H
+
+#include <time.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <vdr/epg.h>
+
+#include "defines.h"
+
+/*
+  Start time ordered index of the events of each schedule, shared by all
+  clients, so that a time window is found with a binary search instead
+  of walking the whole schedule. A channel's index is rebuilt only when
+  VDR reports its schedule as modified.
+
+  Each channel also has a version, which goes up when an event of it
+  is added, changed or dropped, and each event remembers the version it
+  last changed in. Versions come from one counter that starts at the
+  time the server started, so a version left over from an earlier run
+  is not taken for a current one. With that getChanges() can tell a
+  client what changed since the version it has.
+
+  VDR before 2.3.1 has no cSchedule::Modified(State); there the schedule
+  is walked each time instead, the version is a hash of the window, and
+  a changed window is always sent whole.
+
+  Call with the schedules lock held for reading. The events handed out
+  are only valid for as long as it is held.
+*/
+
+class EpgIndex
+{
+  public:
+    EpgIndex();
+    ~EpgIndex();
+    static EpgIndex* getInstance();
+
+    // Events of the schedule in the window the schedule opcodes use:
+    // not over before now or before windowStart, and starting before
+    // windowStart + duration (in ULONG arithmetic, as the clients expect).
+    // Returns the channel's version
+    ULONG getEvents(const cSchedule* schedule, ULONG windowStart, ULONG duration, std::vector<const cEvent*>& events);
+
+    // For a client that has the same window at version since; a version
+    // got for another window must not be passed, pass 0. Returns one of
+    // SYNC_UNCHANGED: nothing to do
+    // SYNC_FULL: events is the whole window, to replace what it has
+    // SYNC_CHANGES: events are new or changed since, and the events in
+    //               removed are gone or have left the window
+    const static int SYNC_UNCHANGED = 0;
+    const static int SYNC_FULL = 1;
+    const static int SYNC_CHANGES = 2;
+    int getChanges(const cSchedule* schedule, ULONG windowStart, ULONG duration, ULONG since,
+                   ULONG& version, std::vector<const cEvent*>& events, std::vector<ULONG>& removed);
+
+    const static UINT MAX_REMOVED = 4096; // per channel, a client further behind gets the whole window
+
+  private:
+    static EpgIndex* instance;
+
+    struct Item
+    {
+      ULONG start;
+      ULONG duration;
+      const cEvent* event;
+      ULONG eventID;
+      ULONG hash;
+      ULONG changed; // version
+    };
+
+    struct Removed
+    {
+      ULONG eventID;
+      ULONG version;
+    };
+
+    struct Entry
+    {
+      const cSchedule* schedule;
+      int state;
+      int count;
+      ULONG maxDuration;
+      std::vector<Item> items;
+      ULONG version;
+      std::deque<Removed> removed;
+      ULONG removedSince; // removed has everything dropped after this version
+    };
+
+    Entry& getEntry(const cSchedule* schedule);
+    void rebuild(Entry& entry);
+    std::vector<Item>::const_iterator windowStart(const Entry& entry, ULONG windowStart, ULONG now);
+
+    pthread_mutex_t mutex;
+    std::unordered_map<std::string, Entry> entries; // by channel ID
+    ULONG lastVersion;
+};
+
+#endif
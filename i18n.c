@@ -23,28 +23,111 @@
 #include <stdio.h>
 #include <string.h>
 #include <glob.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "charsetconv.h"
+#include "log.h"
+#include "stats.h"
 
 using namespace std;
 
-I18n::I18n(char* tconfigDir)
+/*
+  What has been read from the l10n files of one config directory, and
+  the payloads made from it. All under lock.
+*/
+
+class I18nCache
 {
-  configDir = tconfigDir;
+  public:
+    I18nCache();
+    void refresh(const char* configDir);
+    const I18n::trans_table& getTable(const string& code);
+    I18n::Payload& listPayload(int charset) { return listPayloads[charset]; }
+    I18n::Payload& contentPayload(const string& code, int charset) { return contentPayloads[make_pair(code, charset)]; }
+
+    pthread_mutex_t lock;
+    I18n::lang_code_list codes;
+
+  private:
+    struct L10nFile
+    {
+      string path;
+      time_t mtime;
+      off_t size;
+      bool operator==(const L10nFile& o) const { return (path == o.path) && (mtime == o.mtime) && (size == o.size); }
+    };
+
+    void scan();
+    I18n::trans_table readContent(const string& code);
+
+    typedef multimap<string,string> lang_file_list;
+    typedef pair<string,string> lang_file;
+
+    string dir;
+    time_t lastCheck;
+    vector<L10nFile> files;
+    lang_file_list fileList;
+    map<string, I18n::trans_table> tables;
+    map<int, I18n::Payload> listPayloads;
+    map<pair<string,int>, I18n::Payload> contentPayloads;
+};
+
+static I18nCache cache;
+
+I18nCache::I18nCache()
+{
+  pthread_mutex_init(&lock, NULL);
+  lastCheck = 0;
 }
 
-void I18n::findLanguages(void)
+// With the lock held
+void I18nCache::refresh(const char* configDir)
 {
-  glob_t globbuf;
-  char line[1000];
+  time_t now = time(NULL);
+  if ((dir == configDir) && (now >= lastCheck) && (now - lastCheck < I18n::CHECK_INTERVAL)) return;
+  lastCheck = now;
 
-  CodeList.clear();
-  FileList.clear();
-  
+  vector<L10nFile> found;
+  glob_t globbuf;
   string l10nGlob = configDir;
   l10nGlob += "/l10n/*";
   glob(l10nGlob.c_str(), 0, NULL, &globbuf);
   for (unsigned int i=0; i < globbuf.gl_pathc; i++)
   {
-    FILE *f = fopen(globbuf.gl_pathv[i], "r");
+    struct stat st;
+    if (stat(globbuf.gl_pathv[i], &st)) continue;
+    L10nFile file;
+    file.path = globbuf.gl_pathv[i];
+    file.mtime = st.st_mtime;
+    file.size = st.st_size;
+    found.push_back(file);
+  }
+  globfree(&globbuf);
+
+  if ((dir == configDir) && (found == files)) return;
+
+  dir = configDir;
+  files.swap(found);
+  scan();
+  tables.clear();
+  listPayloads.clear();
+  contentPayloads.clear();
+  Log::getInstance()->log("I18n", Log::INFO, "Read %lu languages from %lu files", (ULONG)codes.size(), (ULONG)files.size());
+}
+
+void I18nCache::scan()
+{
+  char line[1000];
+
+  codes.clear();
+  fileList.clear();
+
+  for (unsigned int i=0; i < files.size(); i++)
+  {
+    FILE *f = fopen(files[i].path.c_str(), "r");
     if (f)
     {
       while (fgets(line, 1000, f) && strncmp(line, "l10n-vomp:", 10) == 0)
@@ -62,23 +145,28 @@ void I18n::findLanguages(void)
         if (pos_start == string::npos) break;
         pos_end = langline.find_last_not_of(" \t\r\n");
         name = langline.substr(pos_start, pos_end + 1 - pos_start);
-        CodeList[code] = name;
-        FileList.insert(lang_file(code, globbuf.gl_pathv[i]));
+        codes[code] = name;
+        fileList.insert(lang_file(code, files[i].path));
       }
       fclose(f);
     }
   }
-  globfree(&globbuf);
 }
 
-I18n::trans_table I18n::getLanguageContent(const string code)
+const I18n::trans_table& I18nCache::getTable(const string& code)
+{
+  map<string, I18n::trans_table>::iterator i = tables.find(code);
+  if (i == tables.end()) i = tables.insert(make_pair(code, readContent(code))).first;
+  return i->second;
+}
+
+I18n::trans_table I18nCache::readContent(const string& code)
 {
-  trans_table Translations;
-  if (CodeList.count(code) == 0) return Translations;
-  LanguageCode = code;
+  I18n::trans_table Translations;
+  if (codes.count(code) == 0) return Translations;
 
   pair<lang_file_list::const_iterator, lang_file_list::const_iterator> range;
-  range = FileList.equal_range(code);
+  range = fileList.equal_range(code);
   lang_file_list::const_iterator iter;
   for (iter = range.first; iter != range.second; ++iter)
   {
@@ -128,7 +216,90 @@ I18n::trans_table I18n::getLanguageContent(const string code)
   return Translations;
 }
 
+static void cacheResult(bool hit)
+{
+  Stats* stats = Stats::getInstance();
+  if (!stats) return;
+  if (hit) stats->cacheHit(Stats::CACHE_I18N);
+  else stats->cacheMiss(Stats::CACHE_I18N);
+}
+
+// Appends the string with its terminating 0, as addString does
+static void appendString(string& payload, const char* text)
+{
+  payload.append(text, strlen(text) + 1);
+}
+
+// I18n
+
+I18n::I18n(char* tconfigDir)
+{
+  configDir = tconfigDir;
+}
+
+void I18n::findLanguages(void)
+{
+  pthread_mutex_lock(&cache.lock);
+  cache.refresh(configDir);
+  CodeList = cache.codes;
+  pthread_mutex_unlock(&cache.lock);
+}
+
+I18n::trans_table I18n::getLanguageContent(const string code)
+{
+  pthread_mutex_lock(&cache.lock);
+  cache.refresh(configDir);
+  trans_table Translations = cache.getTable(code);
+  pthread_mutex_unlock(&cache.lock);
+  return Translations;
+}
+
 const I18n::lang_code_list& I18n::getLanguageList(void)
 {
   return CodeList;
 }
+
+I18n::Payload I18n::getLanguageListPayload(int charset, CharsetConv* conv)
+{
+  pthread_mutex_lock(&cache.lock);
+  cache.refresh(configDir);
+  Payload& payload = cache.listPayload(charset);
+  cacheResult((bool)payload);
+  if (!payload)
+  {
+    string* built = new string;
+    lang_code_list::const_iterator iter;
+    for (iter = cache.codes.begin(); iter != cache.codes.end(); ++iter)
+    {
+      appendString(*built, iter->first.c_str()); // Source code is acsii
+      appendString(*built, conv->convert(iter->second.c_str())); //translate string can be any utf-8 character
+    }
+    payload.reset(built);
+  }
+  Payload result = payload;
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+I18n::Payload I18n::getLanguageContentPayload(const string& code, int charset, CharsetConv* conv)
+{
+  pthread_mutex_lock(&cache.lock);
+  cache.refresh(configDir);
+  Payload& payload = cache.contentPayload(code, charset);
+  cacheResult((bool)payload);
+  if (!payload)
+  {
+    string* built = new string;
+    const trans_table& texts = cache.getTable(code);
+    trans_table::const_iterator iter;
+    for (iter = texts.begin(); iter != texts.end(); ++iter)
+    {
+      appendString(*built, iter->first.c_str()); // source code is acsii since it is english
+      appendString(*built, conv->convert(iter->second.c_str())); // translate text can be any unicode string, it is stored as UTF-8
+    }
+    payload.reset(built);
+  }
+  Payload result = payload;
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
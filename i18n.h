@@ -23,6 +23,16 @@
 
 #include <string>
 #include <map>
+#include <memory>
+
+class CharsetConv;
+
+/*
+  The l10n files are read once and shared by all clients. They are
+  checked for changes at most every CHECK_INTERVAL seconds and read again
+  when one has changed. The reply payloads for the language opcodes are
+  kept per language and client charset, so a request only copies one.
+*/
 
 class I18n
 {
@@ -33,17 +43,21 @@ class I18n
     typedef std::map<std::string,std::string> trans_table;
     typedef std::pair<std::string,std::string> trans_entry;
 
+    // Strings as ResponsePacket::addString writes them, converted with the
+    // converter of the charset given
+    typedef std::shared_ptr<const std::string> Payload;
+
     void findLanguages(void);
     trans_table getLanguageContent(const std::string code);
     const lang_code_list& getLanguageList(void);
 
+    Payload getLanguageListPayload(int charset, CharsetConv* conv);
+    Payload getLanguageContentPayload(const std::string& code, int charset, CharsetConv* conv);
+
+    const static int CHECK_INTERVAL = 2;
+
   private:
     char* configDir;
-    std::string LanguageCode;
     lang_code_list CodeList;
-
-    typedef std::multimap<std::string,std::string> lang_file_list;
-    typedef std::pair<std::string,std::string> lang_file;
-    lang_file_list FileList; 
 };
 #endif
@@ -19,22 +19,51 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <strings.h>
+#include <ctype.h>
+
 #include "log.h"
 
 Log* Log::instance = NULL;
 
+// Per thread cache of the "HH:MM:SS." part of the timestamp
+static __thread time_t cachedSecond = -1;
+static __thread char cachedTime[16];
+
 Log::Log()
 {
-  if (instance) return;
-  instance = this;
-  logfile = NULL;
+  logfile = -1;
   initted = 0;
   logLevel = 0;
+  ring = NULL;
+  enqueuePos = 0;
+  dequeuePos = 0;
+  writerSleeping = 0;
+  dropped = 0;
+  droppedReported = 0;
+  writeBuffer = NULL;
+  numModules = 0;
+  minLevel = 0;
+  maxLevel = 0;
+  pthread_mutex_init(&levelMutex, NULL);
+
+  if (instance) return;
+  instance = this;
 }
 
 Log::~Log()
 {
-  instance = NULL;
+  shutdown();
+  delete[] ring;
+  delete[] writeBuffer;
+  pthread_mutex_destroy(&levelMutex);
+  if (instance == this) instance = NULL;
 }
 
 Log* Log::getInstance()
@@ -52,7 +81,7 @@ void Log::upLogLevel()
     return;
   }
 
-  logLevel++;
+  setLevel(logLevel + 1);
   log("Log", logLevel, "Log level is now %i", logLevel);
 }
 
@@ -66,88 +95,362 @@ void Log::downLogLevel()
     return;
   }
 
-  logLevel--;
+  setLevel(logLevel - 1);
   log("Log", logLevel, "Log level is now %i", logLevel);
 }
 
-int Log::init(int startLogLevel, char* fileName)
+// Module levels
+
+static const char* levelNames[] = { "crazy", "emerg", "alert", "crit", "err", "warn", "notice", "info", "debug" };
+
+int Log::levelFromName(const char* name)
+{
+  if (!name || !*name) return -1;
+
+  if (isdigit(name[0]))
+  {
+    char* end;
+    long level = strtol(name, &end, 10);
+    if (*end || (level < CRAZY) || (level > DEBUG)) return -1;
+    return level;
+  }
+
+  for (int i = CRAZY; i <= DEBUG; i++)
+  {
+    if (!strcasecmp(name, levelNames[i])) return i;
+  }
+  return -1;
+}
+
+const char* Log::levelName(int level)
+{
+  if ((level < CRAZY) || (level > DEBUG)) return "?";
+  return levelNames[level];
+}
+
+int Log::moduleLevel(const char* fromModule)
+{
+  int count = __atomic_load_n(&numModules, __ATOMIC_ACQUIRE);
+  for (int i = 0; i < count; i++)
+  {
+    if (!strcmp(modules[i].name, fromModule))
+    {
+      int level = __atomic_load_n(&modules[i].level, __ATOMIC_RELAXED);
+      return (level < 0) ? logLevel : level;
+    }
+  }
+  return logLevel;
+}
+
+// Called with levelMutex held
+void Log::updateLimits()
 {
-  logLevel = startLogLevel;
+  int newMin = logLevel;
+  int newMax = logLevel;
+  for (int i = 0; i < numModules; i++)
+  {
+    int level = modules[i].level;
+    if (level < 0) continue;
+    if (level < newMin) newMin = level;
+    if (level > newMax) newMax = level;
+  }
+  __atomic_store_n(&minLevel, newMin, __ATOMIC_RELAXED);
+  __atomic_store_n(&maxLevel, newMax, __ATOMIC_RELAXED);
+}
+
+void Log::setLevel(int level)
+{
+  if ((level < CRAZY) || (level > DEBUG)) return;
+  pthread_mutex_lock(&levelMutex);
+  __atomic_store_n(&logLevel, level, __ATOMIC_RELAXED);
+  updateLimits();
+  pthread_mutex_unlock(&levelMutex);
+}
+
+int Log::setModuleLevel(const char* fromModule, int level)
+{
+  if ((level < -1) || (level > DEBUG)) return 0;
+  if (!fromModule || !*fromModule || (strlen(fromModule) >= (size_t)MODULE_NAME_LENGTH)) return 0;
+
+  pthread_mutex_lock(&levelMutex);
 
-  logfile = fopen(fileName, "a");
-  if (logfile)
+  int i;
+  for (i = 0; i < numModules; i++)
   {
-    initted = 1;
-    return 1;
+    if (!strcmp(modules[i].name, fromModule)) break;
+  }
+
+  if (i == numModules)
+  {
+    if ((level == -1) || (numModules == MAX_MODULES))
+    {
+      pthread_mutex_unlock(&levelMutex);
+      return (level == -1);
+    }
+    strcpy(modules[i].name, fromModule);
+    modules[i].level = level;
+    __atomic_store_n(&numModules, numModules + 1, __ATOMIC_RELEASE);
   }
   else
   {
+    __atomic_store_n(&modules[i].level, level, __ATOMIC_RELAXED);
+  }
+
+  updateLimits();
+  pthread_mutex_unlock(&levelMutex);
+  return 1;
+}
+
+int Log::setModuleLevels(const char* spec)
+{
+  int result = 1;
+  char* copy = strdup(spec);
+  char* savePtr;
+
+  for (char* entry = strtok_r(copy, ", ", &savePtr); entry; entry = strtok_r(NULL, ", ", &savePtr))
+  {
+    char* colon = strchr(entry, ':');
+    if (!colon)
+    {
+      result = 0;
+      continue;
+    }
+    *colon = '\0';
+    int level = levelFromName(colon + 1);
+    if ((level < 0) || !setModuleLevel(entry, level)) result = 0;
+  }
+
+  free(copy);
+  return result;
+}
+
+std::string Log::dumpLevels()
+{
+  std::string out;
+  char line[80];
+
+  pthread_mutex_lock(&levelMutex);
+  snprintf(line, sizeof(line), "default: %s\n", levelName(logLevel));
+  out += line;
+  for (int i = 0; i < numModules; i++)
+  {
+    if (modules[i].level < 0) continue;
+    snprintf(line, sizeof(line), "%s: %s\n", modules[i].name, levelName(modules[i].level));
+    out += line;
+  }
+  pthread_mutex_unlock(&levelMutex);
+
+  out.erase(out.size() - 1); // no newline after the last line
+  return out;
+}
+
+int Log::init(int startLogLevel, char* fileName)
+{
+  if (initted) return 1;
+
+  setLevel(startLogLevel);
+
+  logfile = open(fileName, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (logfile == -1) return 0;
+
+  if (!ring) ring = new Slot[RING_SLOTS];
+  for (ULONG i = 0; i < RING_SLOTS; i++) ring[i].sequence = i;
+  enqueuePos = 0;
+  dequeuePos = 0;
+  if (!writeBuffer) writeBuffer = new char[WRITE_BATCH];
+
+  if (!threadStart())
+  {
+    close(logfile);
+    logfile = -1;
     return 0;
   }
+
+  initted = 1;
+  return 1;
 }
 
 int Log::shutdown()
 {
   if (!initted) return 1;
   initted = 0;
-  if (logfile) fclose(logfile);
+  threadStop(); // the writer drains the ring before it exits
+  close(logfile);
+  logfile = -1;
   return 1;
 }
 
-int Log::log(const char *fromModule, int level, const char* message, ...)
+int Log::formatTime(char* buffer)
 {
-  if (!initted) return 0;
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
 
-  if (level > logLevel) return 1;
+  if (tv.tv_sec != cachedSecond)
+  {
+    struct tm tm;
+    localtime_r(&tv.tv_sec, &tm);
+    strftime(cachedTime, sizeof(cachedTime), "%H:%M:%S.", &tm);
+    cachedSecond = tv.tv_sec;
+  }
 
-  int lineLength = 250;
+  // "HH:MM:SS." is 9 characters, then 6 digits of microseconds and a space
+  memcpy(buffer, cachedTime, 9);
+  unsigned long usec = tv.tv_usec;
+  for (int i = 14; i >= 9; i--)
+  {
+    buffer[i] = '0' + (usec % 10);
+    usec /= 10;
+  }
+  buffer[15] = ' ';
+  return 16;
+}
 
-  char buffer[lineLength + 1];
-  int spaceLeft = lineLength;
+int Log::log(const char *fromModule, int level, const char* message, ...)
+{
+  if (!initted) return 0;
 
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  struct tm* tm = localtime(&tv.tv_sec);
-  spaceLeft -= strftime(buffer, spaceLeft, "%H:%M:%S.", tm);
-  spaceLeft -= snprintf(&buffer[lineLength-spaceLeft], spaceLeft, "%06lu ", (unsigned long)tv.tv_usec);
+  if (!enabled(fromModule, level)) return 1;
 
+  // Claim a slot
+  Slot* slot;
+  int fullRetries = 0;
+  ULONG pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  for (;;)
+  {
+    slot = &ring[pos & (RING_SLOTS - 1)];
+    // Difference in 32 bits so it stays right when the positions wrap
+    int32_t diff = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0)
+    {
+      if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    }
+    else if (diff < 0)
+    {
+      // Full, the writer is a lap behind. Give it the CPU for a moment
+      // (it may be sharing a core with this thread), then give up
+      if (fullRetries++ == FULL_RETRIES)
+      {
+        __sync_fetch_and_add(&dropped, 1);
+        return 0;
+      }
+      if (__atomic_load_n(&writerSleeping, __ATOMIC_SEQ_CST)) threadSignal();
+      sched_yield();
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    }
+    else
+    {
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    }
+  }
 
-  char levelString[10];
-  if (level == CRAZY)   strcpy(levelString, "[CRAZY] ");
-  if (level == EMERG)   strcpy(levelString, "[EMERG] ");
-  if (level == ALERT)   strcpy(levelString, "[ALERT] ");
-  if (level == CRIT)    strcpy(levelString, "[CRIT]  ");
-  if (level == ERR)     strcpy(levelString, "[ERR]   ");
-  if (level == WARN)    strcpy(levelString, "[WARN]  ");
-  if (level == NOTICE)  strcpy(levelString, "[notice]");
-  if (level == INFO)    strcpy(levelString, "[info]  ");
-  if (level == DEBUG)   strcpy(levelString, "[debug] ");
+  char* buffer = slot->line;
+  int lineLength = LINE_LENGTH;
+  int length = formatTime(buffer);
 
-  spaceLeft -= snprintf(&buffer[lineLength-spaceLeft], spaceLeft, "%s %s - ", levelString, fromModule);
+  const char* levelString = "";
+  if (level == CRAZY)   levelString = "[CRAZY] ";
+  if (level == EMERG)   levelString = "[EMERG] ";
+  if (level == ALERT)   levelString = "[ALERT] ";
+  if (level == CRIT)    levelString = "[CRIT]  ";
+  if (level == ERR)     levelString = "[ERR]   ";
+  if (level == WARN)    levelString = "[WARN]  ";
+  if (level == NOTICE)  levelString = "[notice]";
+  if (level == INFO)    levelString = "[info]  ";
+  if (level == DEBUG)   levelString = "[debug] ";
+
+  length += snprintf(&buffer[length], lineLength - length, "%s %s - ", levelString, fromModule);
+  if (length > lineLength - 1) length = lineLength - 1;
 
   va_list ap;
   va_start(ap, message);
-  spaceLeft = vsnprintf(&buffer[lineLength-spaceLeft], spaceLeft, message, ap);
+  length += vsnprintf(&buffer[length], lineLength - length, message, ap);
   va_end(ap);
+  if (length > lineLength - 1) length = lineLength - 1;
+
+  buffer[length++] = '\n';
+  slot->length = length;
+
+  // Publish, and wake the writer if it has gone to sleep on an empty ring
+  __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&writerSleeping, __ATOMIC_SEQ_CST)) threadSignal();
+
+  return 1;
+}
+
+// Writer thread side
 
-  int messageLength = strlen(buffer);
-  if (messageLength < lineLength)
+void Log::writeOut(const char* data, int length)
+{
+  while (length > 0)
   {
-    buffer[messageLength] = '\n';
-    buffer[messageLength+1] = '\0';
+    ssize_t written = write(logfile, data, length);
+    if (written < 0)
+    {
+      if (errno == EINTR) continue;
+      return; // nowhere to report it
+    }
+    data += written;
+    length -= written;
   }
-  else
+}
+
+int Log::drain()
+{
+  int used = 0;
+  int lines = 0;
+
+  for (;;)
   {
-    buffer[lineLength-1] = '\n';
-    buffer[lineLength] = '\0';
+    Slot* slot = &ring[dequeuePos & (RING_SLOTS - 1)];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != dequeuePos + 1) break;
+
+    if (used + slot->length > WRITE_BATCH)
+    {
+      writeOut(writeBuffer, used);
+      used = 0;
+    }
+    memcpy(&writeBuffer[used], slot->line, slot->length);
+    used += slot->length;
+
+    __atomic_store_n(&slot->sequence, dequeuePos + RING_SLOTS, __ATOMIC_RELEASE);
+    dequeuePos++;
+    lines++;
   }
 
-  int success = fputs(buffer, logfile);
-  fflush(NULL);
+  ULLONG droppedNow = dropped;
+  if (droppedNow != droppedReported)
+  {
+    if (used + 16 + 64 > WRITE_BATCH)
+    {
+      writeOut(writeBuffer, used);
+      used = 0;
+    }
+    used += formatTime(&writeBuffer[used]);
+    used += sprintf(&writeBuffer[used], "[WARN]   Log - %llu lines dropped, ring full\n",
+                    (unsigned long long)(droppedNow - droppedReported));
+    droppedReported = droppedNow;
+  }
 
-  if (success != EOF)
-    return 1;
-  else
-    return 0;
+  if (used) writeOut(writeBuffer, used);
+  return lines;
+}
+
+void Log::threadMethod()
+{
+  while (threadIsActive())
+  {
+    if (drain()) continue;
+
+    threadLock();
+    __atomic_store_n(&writerSleeping, 1, __ATOMIC_SEQ_CST);
+    // Look again after announcing the sleep, a producer that published
+    // before it saw the flag has to be picked up here
+    Slot* slot = &ring[dequeuePos & (RING_SLOTS - 1)];
+    if (threadIsActive() && (__atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) != dequeuePos + 1))
+      threadWaitForSignal();
+    __atomic_store_n(&writerSleeping, 0, __ATOMIC_SEQ_CST);
+    threadUnlock();
+  }
 
+  drain();
 }
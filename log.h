@@ -27,8 +27,30 @@
 #include <sys/time.h>
 #include <string.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <string>
 
-class Log
+#include "defines.h"
+#include "thread.h"
+
+/*
+  log() formats the line in the calling thread straight into a slot of a
+  bounded lock free ring (multiple producers, one consumer) and returns.
+  A writer thread drains the ring and writes whatever has collected with
+  one write() call. A thread that logs never waits for the disk, and
+  takes a lock only when the ring is full, to wake the writer (the
+  condition mutex in threadSignal()). If the ring stays full for a few
+  yields the line is dropped and counted, and the writer reports how many
+  it lost.
+
+  Every module (the fromModule string) logs at the default level unless
+  it has a level of its own, see setModuleLevel(). enabled() answers from
+  the lowest and highest level in use without looking at the module in
+  the common cases, LOG() below uses it to skip a disabled call before
+  its arguments are evaluated.
+*/
+
+class Log : public Thread
 {
   public:
     Log();
@@ -37,9 +59,28 @@ class Log
 
     int init(int defaultLevel, char* fileName);
     int shutdown();
+    int status() { return initted; }
     int log(const char *fromModule, int level, const char *message, ...);
     void upLogLevel();
     void downLogLevel();
+    ULLONG getDropped() { return dropped; }
+
+    bool enabled(const char* fromModule, int level)
+    {
+      if (!initted) return false;
+      if (level <= minLevel) return true;  // every module logs this
+      if (level > maxLevel) return false;  // no module logs this
+      return level <= moduleLevel(fromModule);
+    }
+
+    void setLevel(int level);
+    int getLevel() { return logLevel; }
+    int setModuleLevel(const char* fromModule, int level); // level -1 returns the module to the default
+    int setModuleLevels(const char* spec);                 // "RRProc:debug, TCP:warn"
+    std::string dumpLevels();
+
+    static int levelFromName(const char* name); // name or number, -1 if neither
+    static const char* levelName(int level);
 
     const static int CRAZY  = 0; // mad crazy things that should never happen
     const static int EMERG  = 1; // human assist required NOW
@@ -51,15 +92,80 @@ class Log
     const static int INFO   = 7; // verbose good thing
     const static int DEBUG  = 8; // debug-level messages
 
+    const static int LINE_LENGTH = 250;
+    const static ULONG RING_SLOTS = 2048; // power of two
+    const static int WRITE_BATCH = 65536;
+    const static int FULL_RETRIES = 16;  // yields on a full ring before a line is dropped
+    const static int MAX_MODULES = 64;
+    const static int MODULE_NAME_LENGTH = 32;
+
   private:
     static Log* instance;
     int initted;
     int logLevel;
-    int enabled;
 
-    FILE *logfile;
+    int logfile;
+
+    /*
+      Module levels. Entries are only ever added, under levelMutex, and
+      published by bumping numModules, so enabled() reads them without a
+      lock. A level of -1 means the module follows the default.
+    */
+    struct ModuleLevel
+    {
+      char name[MODULE_NAME_LENGTH];
+      int level;
+    };
+
+    ModuleLevel modules[MAX_MODULES];
+    int numModules;
+    int minLevel;
+    int maxLevel;
+    pthread_mutex_t levelMutex;
+
+    int moduleLevel(const char* fromModule);
+    void updateLimits();
+
+    /*
+      A slot is free for the producer that claims position p when its
+      sequence is p, and holds a finished line for the writer when it is
+      p + 1. The writer hands it back for the next lap as p + RING_SLOTS.
+    */
+    struct Slot
+    {
+      ULONG sequence;
+      int length;
+      char line[LINE_LENGTH + 1];
+    };
+
+    Slot* ring;
+    ULONG enqueuePos;
+    ULONG dequeuePos;
+    int writerSleeping;
+    ULLONG dropped;
+    ULLONG droppedReported;
+    char* writeBuffer;
+
+    void threadMethod();
+    int drain();
+    void writeOut(const char* data, int length);
+    static int formatTime(char* buffer);
 };
 
+/*
+  LOG("RRProc", Log::DEBUG, "getblock pos = %llu", position);
+  is log() for calls on hot paths: when the level is disabled for the
+  module the arguments are not evaluated and nothing is formatted.
+*/
+
+#define LOG(fromModule, level, ...) \
+  do \
+  { \
+    Log* logInstance__ = Log::getInstance(); \
+    if (logInstance__ && logInstance__->enabled(fromModule, level)) \
+      logInstance__->log(fromModule, level, __VA_ARGS__); \
+  } while (0)
+
 #endif
 
 /*
@@ -85,4 +191,12 @@ The message parameter in the log function can be used in the same way as printf,
 
 myptr->log("<module-name>", Log::<levelname>, "Success: %s %i", stringpointer, integer);
 
+On paths that run per request or per packet use the LOG() macro, it takes
+the same arguments and costs a couple of compares when the level is off:
+
+LOG("<module-name>", Log::<levelname>, "Success: %s %i", stringpointer, integer);
+
+Levels can be set per module with "Log levels" in vomp.conf and at runtime
+with the LOGL SVDRP command.
+
 */
@@ -30,10 +30,21 @@
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <string>
 
 
 #define MAXCMD 50
 
+// The checked command table, built from this config at this version.
+// validatedEntries holds the command settings it was built from, other
+// config changes do not need the commands checked again
+static pthread_mutex_t validatedMutex = PTHREAD_MUTEX_INITIALIZER;
+static MediaLauncher *validated = NULL;
+static Config *validatedConfig = NULL;
+static ULONG validatedVersion = 0;
+static std::string validatedEntries;
+
 MediaLauncher::MediaLauncher(Config *c) {
   cfg=c;
   numcommands=0;
@@ -43,12 +54,18 @@ MediaLauncher::MediaLauncher(Config *c) {
 }
 
 MediaLauncher::~MediaLauncher(){
+  clearCommands();
+  };
+
+void MediaLauncher::clearCommands() {
   if (commands) {
     for (int i=0;i<numcommands;i++)
       delete commands[i];
-    delete commands;
+    delete[] commands;
   }
-  };
+  commands=NULL;
+  numcommands=0;
+}
 
 MediaLauncher::MCommand::MCommand(const char *n,ULONG t,const char *ext) {
   command=new char[strlen(n)+1];
@@ -58,8 +75,8 @@ MediaLauncher::MCommand::MCommand(const char *n,ULONG t,const char *ext) {
   strcpy(extension,ext);
 }
 MediaLauncher::MCommand::~MCommand() {
-  delete command;
-  delete extension;
+  delete[] command;
+  delete[] extension;
 }
 
 #define NUMTYPES 4
@@ -81,44 +98,83 @@ static ULONG typeIdFromName(const char *name) {
   return MEDIA_TYPE_UNKNOWN;
 }
 
-int MediaLauncher::init() {
-  Log::getInstance()->log("MediaLauncher",Log::DEBUG,"init");
+int MediaLauncher::load() {
+  Log::getInstance()->log("MediaLauncher",Log::DEBUG,"load");
 
+  clearCommands();
   commands=new Pcmd[MAXCMD];
   char buf[100];
   for(int i=1;i<=MAXCMD;i++){
     sprintf(buf,"Command.Name.%d",i);
-    const char *cmname=cfg->getValueString("Media",buf);
-    if (!cmname) continue;
+    char *cmname=cfg->getValueString("Media",buf);
     sprintf(buf,"Command.Extension.%d",i);
-    const char *cmext=cfg->getValueString("Media",buf);
-    if (!cmext) continue;
+    char *cmext=cfg->getValueString("Media",buf);
     sprintf(buf,"Command.Type.%d",i);
-    const char *cmtype=cfg->getValueString("Media",buf);
-    if (! cmtype) continue;
-    ULONG cmtypeid=typeIdFromName(cmtype);
-    if (cmtypeid == MEDIA_TYPE_UNKNOWN) {
-      Log::getInstance()->log("MediaLauncher",Log::ERR,"unknown media type %s",cmtype);
-      continue;
-    }
-    commands[numcommands]=new MCommand(cmname,cmtypeid,cmext);
-    Log::getInstance()->log("MediaLauncher",Log::DEBUG,"found command %s for ext %s, type %s",cmname,cmext,cmtype);
-    //check the command
-    char cbuf[strlen(cmname)+40];
-    sprintf(cbuf,"%s check",cmname);
-    int rt=system(cbuf);
-    if (rt != 0) {
-      Log::getInstance()->log("MediaLauncher",Log::ERR,"testting command %s failed, ignore",cmname);
-      continue;
+    char *cmtype=cfg->getValueString("Media",buf);
+    if (cmname && cmext && cmtype) {
+      ULONG cmtypeid=typeIdFromName(cmtype);
+      if (cmtypeid == MEDIA_TYPE_UNKNOWN) {
+        Log::getInstance()->log("MediaLauncher",Log::ERR,"unknown media type %s",cmtype);
+      }
+      else {
+        Log::getInstance()->log("MediaLauncher",Log::DEBUG,"found command %s for ext %s, type %s",cmname,cmext,cmtype);
+        //check the command
+        char cbuf[strlen(cmname)+40];
+        sprintf(cbuf,"%s check",cmname);
+        int rt=system(cbuf);
+        if (rt != 0) {
+          Log::getInstance()->log("MediaLauncher",Log::ERR,"testting command %s failed, ignore",cmname);
+        }
+        else {
+          commands[numcommands++]=new MCommand(cmname,cmtypeid,cmext);
+        }
+      }
     }
-    numcommands++;
+    delete[] cmname;
+    delete[] cmext;
+    delete[] cmtype;
   }
 
   Log::getInstance()->log("MediaLauncher",Log::DEBUG,"found %d commands",numcommands);
   return 0;
 }
 
+static std::string commandEntries(Config *cfg) {
+  Config::KeyValues values;
+  cfg->getSectionValues("Media",values);
+  std::string rt;
+  for (UINT i=0;i<values.size();i++) {
+    if (strncasecmp(values[i].first.c_str(),"Command.",8) != 0) continue;
+    rt+=values[i].first;
+    rt+='=';
+    rt+=values[i].second;
+    rt+='\n';
+  }
+  return rt;
+}
+
+int MediaLauncher::init() {
+  pthread_mutex_lock(&validatedMutex);
+  ULONG version=cfg->getVersion();
+  if (!validated || validatedConfig != cfg || validatedVersion != version) {
+    std::string entries=commandEntries(cfg);
+    if (!validated || validatedConfig != cfg || entries != validatedEntries) {
+      Log::getInstance()->log("MediaLauncher",Log::DEBUG,"config version %lu, checking commands",version);
+      if (!validated) validated=new MediaLauncher(cfg);
+      validated->cfg=cfg;
+      validated->load();
+      validatedConfig=cfg;
+      validatedEntries=entries;
+    }
+    validatedVersion=version;
+  }
+  init(validated);
+  pthread_mutex_unlock(&validatedMutex);
+  return 0;
+}
+
 int MediaLauncher::init(MediaLauncher *cp) {
+  clearCommands();
   commands=new Pcmd[MAXCMD];
   for (int i=0;i<cp->numcommands;i++) {
     commands[i]=new MCommand(cp->commands[i]->command,cp->commands[i]->mediaType,cp->commands[i]->extension);
@@ -31,6 +31,8 @@ class MediaLauncher
     MediaLauncher(Config *c);
     ~MediaLauncher();
     //let the launcher read it's config
+    //the commands are read and checked once per config version and
+    //shared, later calls copy them
     //return != 0 if nothing handled
     int init();
     //init as a copy of another launcher
@@ -64,6 +66,8 @@ class MediaLauncher
     int pnum;
     pid_t child;
     int findCommand(const char *name); //return -1 if not found
+    int load(); //read and check the commands from the config
+    void clearCommands();
 
 
 };
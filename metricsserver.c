@@ -0,0 +1,364 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <list>
+
+#include "metricsserver.h"
+#include "stats.h"
+#include "vompclient.h"
+
+// Histogram buckets to publish, as LatencyHistogram bucket numbers
+// (16us, 128us, 1ms, 4ms, 16ms, 65ms, 262ms, 1s, 4s, 16s)
+static const int publishedBuckets[] = { 4, 7, 10, 12, 14, 16, 18, 20, 22, 24 };
+static const int numPublishedBuckets = sizeof(publishedBuckets) / sizeof(publishedBuckets[0]);
+
+MetricsServer::MetricsServer()
+{
+  log = Log::getInstance();
+  listeningSocket = -1;
+}
+
+MetricsServer::~MetricsServer()
+{
+  shutdown();
+}
+
+int MetricsServer::shutdown()
+{
+  if (threadIsActive()) threadStop();
+  if (listeningSocket != -1)
+  {
+    close(listeningSocket);
+    listeningSocket = -1;
+  }
+  return 1;
+}
+
+int MetricsServer::run(USHORT port)
+{
+  if (threadIsActive()) return 1;
+
+  log = Log::getInstance();
+
+  listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (listeningSocket == -1) return 0;
+
+  int value = 1;
+  setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local only
+
+  if (bind(listeningSocket, (struct sockaddr*)&address, sizeof(address)) == -1)
+  {
+    log->log("Metrics", Log::CRIT, "Could not bind to 127.0.0.1:%u", port);
+    shutdown();
+    return 0;
+  }
+
+  if (listen(listeningSocket, 5) == -1)
+  {
+    shutdown();
+    return 0;
+  }
+
+  if (!threadStart())
+  {
+    shutdown();
+    return 0;
+  }
+
+  log->log("Metrics", Log::INFO, "Metrics server listening on 127.0.0.1:%u", port);
+  return 1;
+}
+
+void MetricsServer::threadMethod()
+{
+  fd_set readSet;
+  struct timeval timeout;
+
+  while(threadIsActive())
+  {
+    FD_ZERO(&readSet);
+    FD_SET(listeningSocket, &readSet);
+    timeout.tv_sec = 1;  // check for shutdown once a second
+    timeout.tv_usec = 0;
+    if (select(listeningSocket + 1, &readSet, NULL, NULL, &timeout) < 1) continue;
+
+    int clientSocket = accept(listeningSocket, NULL, NULL);
+    if (clientSocket == -1) continue;
+
+    handleConnection(clientSocket);
+    close(clientSocket);
+  }
+}
+
+void MetricsServer::handleConnection(int clientSocket)
+{
+  // Only the request line matters. Give up on slow or silent clients
+  // rather than holding up the next scrape.
+  char request[1024];
+  int got = 0;
+  fd_set readSet;
+  struct timeval timeout;
+
+  while (got < (int)sizeof(request) - 1)
+  {
+    FD_ZERO(&readSet);
+    FD_SET(clientSocket, &readSet);
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    if (select(clientSocket + 1, &readSet, NULL, NULL, &timeout) < 1) return;
+
+    int thisRead = read(clientSocket, &request[got], sizeof(request) - 1 - got);
+    if (thisRead <= 0) return;
+    got += thisRead;
+    request[got] = '\0';
+    if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+  }
+
+  std::string body;
+  const char* status;
+  const char* contentType = "text/plain; version=0.0.4";
+
+  if (!strncmp(request, "GET /metrics ", 13) || !strncmp(request, "GET /metrics?", 13))
+  {
+    status = "200 OK";
+    body = buildMetrics();
+  }
+  else
+  {
+    status = "404 Not Found";
+    contentType = "text/plain";
+    body = "Not found, try /metrics\n";
+  }
+
+  char header[256];
+  int headerLength = snprintf(header, sizeof(header),
+                              "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %lu\r\nConnection: close\r\n\r\n",
+                              status, contentType, (unsigned long)body.size());
+
+  std::string reply(header, headerLength);
+  reply += body;
+
+  size_t sent = 0;
+  while (sent < reply.size())
+  {
+    ssize_t thisWrite = send(clientSocket, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+    if (thisWrite <= 0)
+    {
+      if ((thisWrite == -1) && (errno == EINTR)) continue;
+      return;
+    }
+    sent += thisWrite;
+  }
+}
+
+static void appendf(std::string& out, const char* format, ...) __attribute__ ((format (printf, 2, 3)));
+static void appendf(std::string& out, const char* format, ...)
+{
+  char line[512];
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(line, sizeof(line), format, ap);
+  va_end(ap);
+  out += line;
+}
+
+void MetricsServer::addHistogram(std::string& out, const char* name, const char* labels, const LatencyHistogram& h)
+{
+  const char* sep = labels[0] ? "," : "";
+  ULLONG cumulative = 0;
+  int b = 0;
+  for (int i = 0; i < numPublishedBuckets; i++)
+  {
+    for (; b <= publishedBuckets[i]; b++) cumulative += h.buckets[b];
+    appendf(out, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels, sep,
+            LatencyHistogram::bucketLimit(publishedBuckets[i]) / 1000000.0, (unsigned long long)cumulative);
+  }
+  for (; b < LatencyHistogram::NUM_BUCKETS; b++) cumulative += h.buckets[b];
+  appendf(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, (unsigned long long)cumulative);
+  appendf(out, "%s_sum{%s} %g\n", name, labels, h.sumUs / 1000000.0);
+  appendf(out, "%s_count{%s} %llu\n", name, labels, (unsigned long long)cumulative);
+}
+
+int MetricsServer::getThreadCount()
+{
+  FILE* f = fopen("/proc/self/status", "r");
+  if (!f) return -1;
+
+  char line[256];
+  int threads = -1;
+  while (fgets(line, sizeof(line), f))
+  {
+    if (!strncmp(line, "Threads:", 8))
+    {
+      threads = atoi(line + 8);
+      break;
+    }
+  }
+  fclose(f);
+  return threads;
+}
+
+std::string MetricsServer::buildMetrics()
+{
+  std::string out;
+  Stats* stats = Stats::getInstance();
+  if (!stats) return out;
+
+  std::list<ClientStats> clients;
+  ClientStats closed;
+  stats->getClients(clients, &closed);
+
+  out += "# HELP vomp_clients Connected clients.\n# TYPE vomp_clients gauge\n";
+  appendf(out, "vomp_clients %i\n", VompClient::getNrClients());
+
+  out += "# HELP vomp_threads Threads in the VDR process.\n# TYPE vomp_threads gauge\n";
+  appendf(out, "vomp_threads %i\n", getThreadCount());
+
+  out += "# HELP vomp_uptime_seconds Time since the server started.\n# TYPE vomp_uptime_seconds gauge\n";
+  appendf(out, "vomp_uptime_seconds %ld\n", (long)(time(NULL) - stats->startTime));
+
+  // Per opcode
+
+  const char* counters[4] = { "vomp_requests_total", "vomp_request_errors_total",
+                              "vomp_requests_cancelled_total", "vomp_response_bytes_total" };
+  const char* counterHelp[4] = { "Requests processed.", "Requests whose handler failed.",
+                                 "Requests cancelled while queued.", "Response bytes sent." };
+
+  for (int c = 0; c < 4; c++)
+  {
+    appendf(out, "# HELP %s %s\n# TYPE %s counter\n", counters[c], counterHelp[c], counters[c]);
+    for (ULONG op = 0; op <= (Stats::MAX_OPCODE + 1); op++)
+    {
+      OpcodeStats* o = stats->getOpcodeStats(op);
+      if (!o->requests && !o->cancelled) continue;
+      ULLONG values[4] = { o->requests, o->errors, o->cancelled, o->bytesOut };
+      if (op > Stats::MAX_OPCODE) appendf(out, "%s{opcode=\"other\"} %llu\n", counters[c], (unsigned long long)values[c]);
+      else appendf(out, "%s{opcode=\"%lu\"} %llu\n", counters[c], (unsigned long)op, (unsigned long long)values[c]);
+    }
+  }
+
+  const char* histograms[3] = { "vomp_request_queue_wait_seconds", "vomp_request_processing_seconds",
+                                "vomp_response_send_seconds" };
+  const char* histogramHelp[3] = { "Time from reading a request to its handler starting.",
+                                   "Time spent in the request handler.",
+                                   "Time from queueing a response to writing it to the socket." };
+
+  for (int hi = 0; hi < 3; hi++)
+  {
+    appendf(out, "# HELP %s %s\n# TYPE %s histogram\n", histograms[hi], histogramHelp[hi], histograms[hi]);
+    for (ULONG op = 0; op <= (Stats::MAX_OPCODE + 1); op++)
+    {
+      OpcodeStats* o = stats->getOpcodeStats(op);
+      if (!o->requests) continue;
+      const LatencyHistogram* h = (hi == 0) ? &o->queueWait : ((hi == 1) ? &o->processing : &o->send);
+      char labels[32];
+      if (op > Stats::MAX_OPCODE) snprintf(labels, sizeof(labels), "opcode=\"other\"");
+      else snprintf(labels, sizeof(labels), "opcode=\"%lu\"", (unsigned long)op);
+      addHistogram(out, histograms[hi], labels, *h);
+    }
+  }
+
+  // VDR locks
+
+  out += "# HELP vomp_vdr_lock_hold_seconds Time request handlers hold VDR list locks.\n# TYPE vomp_vdr_lock_hold_seconds histogram\n";
+  for (int l = 0; l < Stats::NUM_LOCKS; l++)
+  {
+    char labels[32];
+    snprintf(labels, sizeof(labels), "lock=\"%s\"", Stats::lockNames[l]);
+    addHistogram(out, "vomp_vdr_lock_hold_seconds", labels, stats->lockHolds[l]);
+  }
+
+  // Recordings
+
+  out += "# HELP vomp_recplayer_read_seconds RecPlayer getBlock read time.\n# TYPE vomp_recplayer_read_seconds histogram\n";
+  addHistogram(out, "vomp_recplayer_read_seconds", "", stats->recPlayerReads);
+  out += "# HELP vomp_recplayer_read_bytes_total Bytes read from recordings.\n# TYPE vomp_recplayer_read_bytes_total counter\n";
+  appendf(out, "vomp_recplayer_read_bytes_total %llu\n", (unsigned long long)stats->recPlayerBytes);
+
+  // Traffic, totals include clients that have gone
+
+  ULLONG bytesIn = closed.bytesIn;
+  ULLONG bytesOut = closed.bytesOut;
+  ULLONG streamBytes = closed.streamBytes;
+  ULLONG ringDrops = closed.ringDrops;
+  ULLONG requests = closed.requests;
+  ULLONG readSyscalls = closed.readSyscalls;
+  ULLONG writeSyscalls = closed.writeSyscalls;
+  for (std::list<ClientStats>::iterator i = clients.begin(); i != clients.end(); ++i)
+  {
+    bytesIn += i->bytesIn;
+    bytesOut += i->bytesOut;
+    streamBytes += i->streamBytes;
+    ringDrops += i->ringDrops;
+    requests += i->requests;
+    readSyscalls += i->readSyscalls;
+    writeSyscalls += i->writeSyscalls;
+  }
+
+  out += "# HELP vomp_received_bytes_total Bytes received from clients.\n# TYPE vomp_received_bytes_total counter\n";
+  appendf(out, "vomp_received_bytes_total %llu\n", (unsigned long long)bytesIn);
+  out += "# HELP vomp_sent_bytes_total Bytes sent to clients.\n# TYPE vomp_sent_bytes_total counter\n";
+  appendf(out, "vomp_sent_bytes_total %llu\n", (unsigned long long)bytesOut);
+  out += "# HELP vomp_stream_bytes_total Live TV bytes sent.\n# TYPE vomp_stream_bytes_total counter\n";
+  appendf(out, "vomp_stream_bytes_total %llu\n", (unsigned long long)streamBytes);
+  out += "# HELP vomp_ring_dropped_bytes_total Live TV bytes overwritten in receiver ringbuffers.\n# TYPE vomp_ring_dropped_bytes_total counter\n";
+  appendf(out, "vomp_ring_dropped_bytes_total %llu\n", (unsigned long long)ringDrops);
+  out += "# HELP vomp_received_requests_total Requests read from clients.\n# TYPE vomp_received_requests_total counter\n";
+  appendf(out, "vomp_received_requests_total %llu\n", (unsigned long long)requests);
+  out += "# HELP vomp_read_syscalls_total select() and read() calls made reading client requests.\n# TYPE vomp_read_syscalls_total counter\n";
+  appendf(out, "vomp_read_syscalls_total %llu\n", (unsigned long long)readSyscalls);
+  out += "# HELP vomp_write_syscalls_total select() and sendmsg() calls made writing to clients.\n# TYPE vomp_write_syscalls_total counter\n";
+  appendf(out, "vomp_write_syscalls_total %llu\n", (unsigned long long)writeSyscalls);
+
+  out += "# HELP vomp_ring_fill_ratio Live TV receiver ringbuffer fill level per client.\n# TYPE vomp_ring_fill_ratio gauge\n";
+  for (std::list<ClientStats>::iterator i = clients.begin(); i != clients.end(); ++i)
+  {
+    if (!i->ringSize) continue;
+    appendf(out, "vomp_ring_fill_ratio{client=\"%lu\"} %g\n", (unsigned long)i->id, (double)i->ringFill / i->ringSize);
+  }
+
+  // Caches
+
+  out += "# HELP vomp_cache_hits_total Cache and pool hits.\n# TYPE vomp_cache_hits_total counter\n";
+  for (int c = 0; c < Stats::NUM_CACHES; c++)
+    appendf(out, "vomp_cache_hits_total{cache=\"%s\"} %llu\n", Stats::cacheNames[c], (unsigned long long)stats->cacheHits[c]);
+  out += "# HELP vomp_cache_misses_total Cache and pool misses.\n# TYPE vomp_cache_misses_total counter\n";
+  for (int c = 0; c < Stats::NUM_CACHES; c++)
+    appendf(out, "vomp_cache_misses_total{cache=\"%s\"} %llu\n", Stats::cacheNames[c], (unsigned long long)stats->cacheMisses[c]);
+
+  return out;
+}
@@ -0,0 +1,59 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <string>
+
+#include "defines.h"
+#include "log.h"
+#include "thread.h"
+
+class LatencyHistogram;
+
+/*
+  Tiny HTTP server on 127.0.0.1 that answers GET /metrics with the Stats
+  counters in Prometheus text format. Runs on its own thread and only reads
+  Stats, it never touches a client connection. Enabled with
+  "Metrics port = <port>" in vomp.conf.
+*/
+
+class MetricsServer : public Thread
+{
+  public:
+    MetricsServer();
+    virtual ~MetricsServer();
+
+    int run(USHORT port);
+    int shutdown();
+
+  private:
+    void threadMethod();
+    void handleConnection(int clientSocket);
+    std::string buildMetrics();
+    void addHistogram(std::string& out, const char* name, const char* labels, const LatencyHistogram& h);
+    static int getThreadCount();
+
+    Log* log;
+    int listeningSocket;
+};
+
+#endif
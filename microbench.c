@@ -0,0 +1,507 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Microbenchmarks for the server's hot helper classes. Not part of the
+  plugin, build with "make microbench" and run ./microbench [filter].
+
+  Each benchmark runs its body a fixed number of times per batch, five
+  batches in a row, and prints the median batch as ns per operation and,
+  where the body moves data, MB/s. The median keeps one batch disturbed
+  by the scheduler from moving the result, so runs on the same machine
+  are comparable and a regression in one of these shared components
+  shows up as a change in its line.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <endian.h>
+#include <arpa/inet.h>
+#include <algorithm>
+
+#include "defines.h"
+#include "responsepacket.h"
+#include "ringbuffer.h"
+#include "serialize.h"
+#include "media.h"
+#include "vdrcommand.h"
+#include "log.h"
+
+static double nowMs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static const char* benchFilter = NULL;
+
+// Stops the optimiser throwing results away
+static volatile ULONG benchSink;
+
+const static int benchBatches = 5;
+
+/*
+  opsPerIter is how many operations one call of fn does, ns/op is per
+  operation. bytesPerIter is the payload one call moves, 0 leaves the
+  MB/s column empty.
+*/
+
+static void runBench(const char* name, int iterations, void (*fn)(), int opsPerIter = 1, double bytesPerIter = 0)
+{
+  if (benchFilter && !strstr(name, benchFilter)) return;
+
+  fn(); // warm up
+
+  double batchMs[benchBatches];
+  for (int b = 0; b < benchBatches; b++)
+  {
+    double start = nowMs();
+    for (int i = 0; i < iterations; i++) fn();
+    batchMs[b] = nowMs() - start;
+  }
+  std::sort(batchMs, batchMs + benchBatches);
+  double median = batchMs[benchBatches / 2];
+
+  double nsPerOp = median * 1000000.0 / ((double)iterations * opsPerIter);
+  if (bytesPerIter > 0)
+  {
+    double mbPerSec = bytesPerIter * iterations / (median / 1000.0) / 1000000.0;
+    printf("%-44s %12.1f ns/op %10.1f MB/s\n", name, nsPerOp, mbPerSec);
+  }
+  else
+  {
+    printf("%-44s %12.1f ns/op %10s\n", name, nsPerOp, "-");
+  }
+}
+
+// ---- ResponsePacket ----------------------------------------------------------
+
+/*
+  A recordings list style reply: per entry a start time, a length and a
+  name. 4000 entries come to roughly 300 KB. The names are made up front
+  so that the benchmarks time packing the reply and not snprintf.
+*/
+
+const static int listEntries = 4000;
+static ResponsePacketPool benchPool;
+static char listNames[listEntries][64];
+
+static void makeListNames()
+{
+  for (int i = 0; i < listEntries; i++)
+    snprintf(listNames[i], sizeof(listNames[i]), "Some~Series name~Episode title number %i", i);
+}
+
+/*
+  ResponsePacket as it was before it grew geometrically: the buffer starts
+  at 512 bytes and is realloc'd by max(512, n) whenever it is full.
+*/
+
+class LinearPacket
+{
+  public:
+    LinearPacket() : buffer(NULL), bufSize(0), bufUsed(0) {}
+    ~LinearPacket() { free(buffer); }
+
+    bool init(ULONG requestID);
+    void finalise() { *(ULONG*)&buffer[8] = htonl(bufUsed - 12); }
+    bool addString(const char* string);
+    bool addULONG(ULONG ul);
+    bool addUCHAR(UCHAR c);
+    ULONG getLen() { return bufUsed; }
+
+  private:
+    UCHAR* buffer;
+    ULONG bufSize;
+    ULONG bufUsed;
+
+    bool checkExtend(ULONG by);
+};
+
+// Out of line, like ResponsePacket's
+__attribute__((noinline)) bool LinearPacket::init(ULONG requestID)
+{
+  bufSize = 512;
+  buffer = (UCHAR*)malloc(bufSize);
+  if (!buffer) return false;
+  *(ULONG*)&buffer[0] = htonl(1);
+  *(ULONG*)&buffer[4] = htonl(requestID);
+  *(ULONG*)&buffer[8] = 0;
+  bufUsed = 12;
+  return true;
+}
+
+__attribute__((noinline)) bool LinearPacket::addString(const char* string)
+{
+  ULONG len = strlen(string) + 1;
+  if (!checkExtend(len)) return false;
+  memcpy(buffer + bufUsed, string, len);
+  bufUsed += len;
+  return true;
+}
+
+__attribute__((noinline)) bool LinearPacket::addULONG(ULONG ul)
+{
+  if (!checkExtend(sizeof(ULONG))) return false;
+  *(ULONG*)&buffer[bufUsed] = htonl(ul);
+  bufUsed += sizeof(ULONG);
+  return true;
+}
+
+__attribute__((noinline)) bool LinearPacket::addUCHAR(UCHAR c)
+{
+  if (!checkExtend(sizeof(UCHAR))) return false;
+  buffer[bufUsed] = c;
+  bufUsed += sizeof(UCHAR);
+  return true;
+}
+
+bool LinearPacket::checkExtend(ULONG by)
+{
+  if ((bufUsed + by) < bufSize) return true;
+  if (512 > by) by = 512;
+  UCHAR* newBuf = (UCHAR*)realloc(buffer, bufSize + by);
+  if (!newBuf) return false;
+  buffer = newBuf;
+  bufSize += by;
+  return true;
+}
+
+/*
+  In the server other allocations happen while a reply is built (charset
+  conversions, other clients' packets), so realloc can rarely grow the
+  buffer in place and has to copy it. With interleave set every entry
+  also allocates a small block that lives until the reply is done, which
+  does the same here. Without it the buffer sits at the top of the heap
+  and a linear realloc is nearly free, which flatters the old strategy.
+*/
+
+template <class Packet> static void fillList(Packet* resp, bool interleave)
+{
+  std::vector<char*> others;
+  if (interleave) others.reserve(listEntries);
+  for (int i = 0; i < listEntries; i++)
+  {
+    resp->addULONG(1400000000 + i);
+    resp->addUCHAR(0);
+    resp->addString(listNames[i]);
+    resp->addString("/video/Some_Series/2014-05-13.20.15.50-0.rec");
+    if (interleave) others.push_back(strdup(listNames[i]));
+  }
+  resp->finalise();
+  for (UINT i = 0; i < others.size(); i++) free(others[i]);
+}
+
+static void listLinear(bool interleave)
+{
+  LinearPacket* resp = new LinearPacket();
+  resp->init(1);
+  fillList(resp, interleave);
+  benchSink = resp->getLen();
+  delete resp;
+}
+
+static void listNew(bool interleave)
+{
+  ResponsePacket* resp = new ResponsePacket();
+  resp->init(1);
+  fillList(resp, interleave);
+  benchSink = resp->getLen();
+  resp->release();
+}
+
+static void listHinted(bool interleave)
+{
+  ResponsePacket* resp = new ResponsePacket();
+  resp->init(1, 65536);
+  fillList(resp, interleave);
+  benchSink = resp->getLen();
+  resp->release();
+}
+
+static void listPooled(bool interleave)
+{
+  ResponsePacket* resp = benchPool.get();
+  resp->init(1, 65536);
+  fillList(resp, interleave);
+  benchSink = resp->getLen();
+  resp->release();
+}
+
+static void benchListLinearGrowth() { listLinear(false); }
+static void benchListNew() { listNew(false); }
+static void benchListHinted() { listHinted(false); }
+static void benchListPooled() { listPooled(false); }
+static void benchListLinearGrowthInterleaved() { listLinear(true); }
+static void benchListNewInterleaved() { listNew(true); }
+static void benchListPooledInterleaved() { listPooled(true); }
+
+static void benchSmallNew()
+{
+  ResponsePacket* resp = new ResponsePacket();
+  resp->init(1);
+  resp->addULONG(1);
+  resp->finalise();
+  benchSink = resp->getLen();
+  resp->release();
+}
+
+static void benchSmallPooled()
+{
+  ResponsePacket* resp = benchPool.get();
+  resp->init(1);
+  resp->addULONG(1);
+  resp->finalise();
+  benchSink = resp->getLen();
+  resp->release();
+}
+
+// ---- Ringbuffer -------------------------------------------------------------
+
+/*
+  Put and get in equal chunks through a 1 MB buffer, as the recording
+  and live paths use it, and the live pattern of TS packets in and
+  stream blocks out.
+*/
+
+const static int ringSize = 1048576;
+const static int ringBytesPerIter = 262144;
+static Ringbuffer benchRing;
+static UCHAR ringData[65536];
+static int ringChunk;
+
+static void benchRingChunks()
+{
+  for (int done = 0; done < ringBytesPerIter; done += ringChunk)
+  {
+    benchRing.put(ringData, ringChunk);
+    benchSink = benchRing.get(ringData, ringChunk);
+  }
+}
+
+static void benchRing188() { ringChunk = 188; benchRingChunks(); }
+static void benchRing4k() { ringChunk = 4096; benchRingChunks(); }
+static void benchRing64k() { ringChunk = 65536; benchRingChunks(); }
+
+static void benchRingStream()
+{
+  const int blockSize = 50000;
+  for (int done = 0; done < ringBytesPerIter; )
+  {
+    while (benchRing.getContent() < blockSize) benchRing.put(ringData, 188);
+    done += benchRing.get(ringData, blockSize);
+  }
+  benchSink = benchRing.getContent();
+}
+
+// ---- Serialization -----------------------------------------------------------
+
+/*
+  A media directory of 1000 files as VDR_GETMEDIALIST answers it, encoded
+  and decoded through the same VDR_Command the server and vompload use.
+*/
+
+const static int mediaEntries = 1000;
+static MediaList* benchMediaList;
+static SerializeBuffer* benchMediaBuffer;
+static int benchMediaLen;
+
+static void setupMediaList()
+{
+  MediaURI root(1, "/srv/media/Music/Some Artist", NULL);
+  benchMediaList = new MediaList(&root);
+  char name[64];
+  for (int i = 0; i < mediaEntries; i++)
+  {
+    Media* m = new Media();
+    snprintf(name, sizeof(name), "%03i - Track title number %i.mp3", i, i);
+    m->setFileName(name);
+    m->setTime(1400000000 + i);
+    m->setMediaType(MEDIA_TYPE_AUDIO);
+    benchMediaList->push_back(m);
+  }
+
+  ULONG flags = 0;
+  VDR_GetMediaListResponse response(&flags, benchMediaList);
+  benchMediaBuffer = new SerializeBuffer(1024, false, true);
+  response.serialize(benchMediaBuffer);
+  benchMediaLen = benchMediaBuffer->getCurrent() - benchMediaBuffer->getStart();
+}
+
+static void benchMediaListEncode()
+{
+  ULONG flags = 0;
+  VDR_GetMediaListResponse response(&flags, benchMediaList);
+  SerializeBuffer buffer(benchMediaLen, false, true);
+  response.serialize(&buffer);
+  benchSink = buffer.getCurrent() - buffer.getStart();
+}
+
+static void benchMediaListDecode()
+{
+  SerializeBuffer buffer(benchMediaBuffer->getStart(), benchMediaLen);
+  ULONG flags = 0;
+  MediaList list(NULL);
+  VDR_GetMediaListResponse response(&flags, &list);
+  response.deserialize(&buffer);
+  benchSink = list.size();
+}
+
+const static int encodeCount = 10000;
+
+static void benchEncodeLong()
+{
+  SerializeBuffer buffer(encodeCount * 4, false, false);
+  for (int i = 0; i < encodeCount; i++) buffer.encodeLong(i);
+  benchSink = buffer.getCurrent() - buffer.getStart();
+}
+
+static void benchEncodeString()
+{
+  SerializeBuffer buffer(encodeCount * 40, false, false);
+  for (int i = 0; i < encodeCount; i++) buffer.encodeString("Some~Series name~Episode");
+  benchSink = buffer.getCurrent() - buffer.getStart();
+}
+
+// ---- htonll ------------------------------------------------------------------
+
+/*
+  The 64 bit byte swap as ResponsePacket and VompClient write it (both
+  keep it private, this is the same code) against the libc helper.
+*/
+
+static ULLONG shiftHtonll(ULLONG a)
+{
+  #if BYTE_ORDER == BIG_ENDIAN
+    return a;
+  #else
+    return ((a << 56) & 0xFF00000000000000ULL)
+         | ((a << 40) & 0x00FF000000000000ULL)
+         | ((a << 24) & 0x0000FF0000000000ULL)
+         | ((a <<  8) & 0x000000FF00000000ULL)
+         | ((a >>  8) & 0x00000000FF000000ULL)
+         | ((a >> 24) & 0x0000000000FF0000ULL)
+         | ((a >> 40) & 0x000000000000FF00ULL)
+         | ((a >> 56) & 0x00000000000000FFULL) ;
+  #endif
+}
+
+const static int swapCount = 100000;
+static volatile ULLONG swapSeed = 0x0123456789ABCDEFULL;
+
+static void benchHtonllShift()
+{
+  ULLONG a = swapSeed, acc = 0;
+  for (int i = 0; i < swapCount; i++) acc += shiftHtonll(a + i);
+  benchSink = (ULONG)acc;
+}
+
+static void benchHtonllLibc()
+{
+  ULLONG a = swapSeed, acc = 0;
+  for (int i = 0; i < swapCount; i++) acc += htobe64(a + i);
+  benchSink = (ULONG)acc;
+}
+
+// ---- Log ---------------------------------------------------------------------
+
+/*
+  Log::log to /dev/null. This is the cost to the calling thread, the
+  formatting into the ring; the writer thread does the write()s. Lines
+  the writer could not keep up with are dropped, the count is printed
+  after the benchmark. The filtered cases are a DEBUG line with the log
+  level at INFO, through log() and through the LOG() macro.
+*/
+
+const static int logCount = 1000;
+static Log benchLog;
+
+static void benchLogWritten()
+{
+  for (int i = 0; i < logCount; i++)
+    benchLog.log("Bench", Log::INFO, "Client %i sent opcode %i, %lu bytes", 3, i, (unsigned long)1234);
+}
+
+static void benchLogFiltered()
+{
+  for (int i = 0; i < logCount; i++)
+    benchLog.log("Bench", Log::DEBUG, "Client %i sent opcode %i, %lu bytes", 3, i, (unsigned long)1234);
+}
+
+static void benchLogMacroFiltered()
+{
+  for (int i = 0; i < logCount; i++)
+    LOG("Bench", Log::DEBUG, "Client %i sent opcode %i, %lu bytes", 3, i, (unsigned long)1234);
+}
+
+// ---- main --------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  if (argc > 1) benchFilter = argv[1];
+
+  makeListNames();
+  ResponsePacket* sizer = new ResponsePacket();
+  sizer->init(1);
+  fillList(sizer, false);
+  double listBytes = sizer->getLen();
+  sizer->release();
+
+  runBench("responsepacket/list300k_linear_growth", 40, benchListLinearGrowth, listEntries, listBytes);
+  runBench("responsepacket/list300k_new", 40, benchListNew, listEntries, listBytes);
+  runBench("responsepacket/list300k_hinted", 40, benchListHinted, listEntries, listBytes);
+  runBench("responsepacket/list300k_pooled", 40, benchListPooled, listEntries, listBytes);
+  runBench("responsepacket/list300k_linear_growth_mixed", 40, benchListLinearGrowthInterleaved, listEntries, listBytes);
+  runBench("responsepacket/list300k_new_mixed", 40, benchListNewInterleaved, listEntries, listBytes);
+  runBench("responsepacket/list300k_pooled_mixed", 40, benchListPooledInterleaved, listEntries, listBytes);
+  runBench("responsepacket/small_new", 40000, benchSmallNew);
+  runBench("responsepacket/small_pooled", 40000, benchSmallPooled);
+
+  benchRing.init(ringSize);
+  runBench("ringbuffer/putget_188", 100, benchRing188, ringBytesPerIter / 188, ringBytesPerIter);
+  runBench("ringbuffer/putget_4k", 100, benchRing4k, ringBytesPerIter / 4096, ringBytesPerIter);
+  runBench("ringbuffer/putget_64k", 100, benchRing64k, ringBytesPerIter / 65536, ringBytesPerIter);
+  runBench("ringbuffer/stream_188_in_50000_out", 100, benchRingStream, ringBytesPerIter / 188, ringBytesPerIter);
+
+  setupMediaList();
+  runBench("serialize/medialist1000_encode", 100, benchMediaListEncode, mediaEntries, benchMediaLen);
+  runBench("serialize/medialist1000_decode", 100, benchMediaListDecode, mediaEntries, benchMediaLen);
+  runBench("serialize/encode_long", 100, benchEncodeLong, encodeCount, encodeCount * 4);
+  runBench("serialize/encode_string", 100, benchEncodeString, encodeCount, encodeCount * 29);
+  delete benchMediaBuffer;
+  delete benchMediaList;
+
+  runBench("htonll/shift", 100, benchHtonllShift, swapCount);
+  runBench("htonll/htobe64", 100, benchHtonllLibc, swapCount);
+
+  char logFile[] = "/dev/null";
+  benchLog.init(Log::INFO, logFile);
+  runBench("log/written", 20, benchLogWritten, logCount);
+  runBench("log/filtered", 200, benchLogFiltered, logCount);
+  runBench("log/filtered_macro", 200, benchLogMacroFiltered, logCount);
+  benchLog.shutdown();
+  if (!benchFilter || strstr("log/written", benchFilter))
+    printf("%-44s %12llu lines\n", "log/written dropped", (unsigned long long)benchLog.getDropped());
+
+  return 0;
+}
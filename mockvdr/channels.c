@@ -0,0 +1,169 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "vdr/channels.h"
+
+const tChannelID tChannelID::InvalidID;
+
+static cChannels channels;
+
+// Source codes as VDR builds them: 'S' << 24 | position, east
+#define SOURCE_S192E (('S' << 24) | 192)
+
+tChannelID tChannelID::FromString(const char* s)
+{
+  char sourcebuf[16];
+  int nid, tid, sid, rid = 0;
+  int fields = sscanf(s, "%15[^-]-%d-%d-%d-%d", sourcebuf, &nid, &tid, &sid, &rid);
+  if ((fields != 4) && (fields != 5)) return tChannelID::InvalidID;
+
+  int source = 0;
+  char type;
+  int whole, fraction;
+  char direction;
+  if (sscanf(sourcebuf, "%c%d.%d%c", &type, &whole, &fraction, &direction) == 4)
+    source = (type << 24) | (whole * 10 + fraction);
+  return tChannelID(source, nid, tid, sid, rid);
+}
+
+cString tChannelID::ToString() const
+{
+  int position = source & 0xFFFFFF;
+  char sourcebuf[16];
+  snprintf(sourcebuf, sizeof(sourcebuf), "%c%d.%d%c", (char)(source >> 24), position / 10, position % 10, 'E');
+  if (rid) return cString::sprintf("%s-%d-%d-%d-%d", sourcebuf, nid, tid, sid, rid);
+  return cString::sprintf("%s-%d-%d-%d", sourcebuf, nid, tid, sid);
+}
+
+cChannel::cChannel()
+{
+  name = strdup("");
+  number = 0;
+  groupSep = false;
+  source = nid = tid = sid = 0;
+  vpid = ppid = vtype = tpid = 0;
+  memset(apids, 0, sizeof(apids));
+  memset(atypes, 0, sizeof(atypes));
+  memset(alangs, 0, sizeof(alangs));
+  memset(dpids, 0, sizeof(dpids));
+  memset(dtypes, 0, sizeof(dtypes));
+  memset(dlangs, 0, sizeof(dlangs));
+  memset(spids, 0, sizeof(spids));
+  memset(slangs, 0, sizeof(slangs));
+  memset(subtitlingTypes, 0, sizeof(subtitlingTypes));
+  memset(compositionPageIds, 0, sizeof(compositionPageIds));
+  memset(ancillaryPageIds, 0, sizeof(ancillaryPageIds));
+  memset(caids, 0, sizeof(caids));
+}
+
+cChannel::~cChannel()
+{
+  free(name);
+}
+
+cChannels::cChannels()
+: cList<cChannel>("Channels")
+{
+  maxNumber = 0;
+}
+
+const cChannel* cChannels::GetByNumber(int Number, int SkipGap) const
+{
+  for (const cChannel* channel = First(); channel; channel = Next(channel))
+  {
+    if (!channel->GroupSep() && (channel->Number() == Number)) return channel;
+  }
+  return NULL;
+}
+
+const cChannel* cChannels::GetByChannelID(tChannelID ChannelID, bool TryWithoutRid, bool TryWithoutPolarization) const
+{
+  for (const cChannel* channel = First(); channel; channel = Next(channel))
+  {
+    if (channel->GetChannelID() == ChannelID) return channel;
+  }
+  return NULL;
+}
+
+const cChannels* cChannels::GetChannelsRead(cStateKey& StateKey, int TimeoutMs)
+{
+  return channels.Lock(StateKey, false, TimeoutMs) ? &channels : NULL;
+}
+
+cChannels* cChannels::GetChannelsWrite(cStateKey& StateKey, int TimeoutMs)
+{
+  return channels.Lock(StateKey, true, TimeoutMs) ? &channels : NULL;
+}
+
+void cChannels::CreateSynthetic(int numChannels)
+{
+  static const char* languages[] = { "deu", "eng", "fra" };
+  const int numRadio = 5;
+
+  Clear();
+  int number = 0;
+  for (int i = 0; i < numChannels + numRadio; i++)
+  {
+    bool radio = (i >= numChannels);
+    cChannel* channel = new cChannel;
+    free(channel->name);
+    if (radio) asprintf(&channel->name, "Radio %d", i - numChannels + 1);
+    else asprintf(&channel->name, "Channel %d", i + 1);
+    channel->number = ++number;
+    channel->source = SOURCE_S192E;
+    channel->nid = 1;
+    channel->tid = 1000 + (i / 8);
+    channel->sid = 10000 + i;
+
+    int basePid = 100 + i * 10;
+    if (!radio)
+    {
+      channel->vpid = basePid;
+      channel->ppid = basePid;
+      channel->vtype = 2;
+      channel->tpid = basePid + 9;
+    }
+
+    int numAudio = radio ? 1 : 2;
+    for (int a = 0; a < numAudio; a++)
+    {
+      channel->apids[a] = basePid + 1 + a;
+      channel->atypes[a] = 4;
+      strcpy(channel->alangs[a], languages[(i + a) % 3]);
+    }
+
+    if (!radio)
+    {
+      channel->dpids[0] = basePid + 4;
+      channel->dtypes[0] = 0x6A;
+      strcpy(channel->dlangs[0], languages[i % 3]);
+      channel->spids[0] = basePid + 6;
+      strcpy(channel->slangs[0], languages[i % 3]);
+      channel->subtitlingTypes[0] = 0x10;
+      channel->compositionPageIds[0] = 1;
+      channel->ancillaryPageIds[0] = 1;
+      if ((i % 5) == 4) channel->caids[0] = 0x1702;
+    }
+
+    Add(channel);
+  }
+  maxNumber = number;
+  SetModified();
+}
@@ -0,0 +1,261 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <time.h>
+
+#include "vdr/device.h"
+#include "vdr/receiver.h"
+#include "tsgen.h"
+
+int cDevice::numDevices = 0;
+cDevice* cDevice::devices[MAXDEVICES] = { NULL };
+int cDevice::bitrate = 4000000;
+
+// ---- cDevice -----------------------------------------------------------------
+
+void cDevice::Initialize(int NumDevices, int Bitrate)
+{
+  if (NumDevices > MAXDEVICES) NumDevices = MAXDEVICES;
+  bitrate = Bitrate;
+  for (int i = 0; i < NumDevices; i++)
+  {
+    devices[i] = new cDevice(i);
+    numDevices++;
+  }
+}
+
+void cDevice::Shutdown()
+{
+  for (int i = 0; i < numDevices; i++)
+  {
+    delete devices[i];
+    devices[i] = NULL;
+  }
+  numDevices = 0;
+}
+
+cDevice* cDevice::GetDevice(int Index)
+{
+  return ((Index >= 0) && (Index < numDevices)) ? devices[Index] : NULL;
+}
+
+cDevice* cDevice::GetDevice(const cChannel* Channel, int Priority, bool LiveView, bool Query)
+{
+  // Prefer a device already tuned to this channel, then any idle one
+  cDevice* idle = NULL;
+  for (int i = 0; i < numDevices; i++)
+  {
+    cDevice* d = devices[i];
+    cMutexLock lock(&d->mutex);
+    if (d->channel == Channel) return d;
+    if (!idle && !d->Receiving()) idle = d;
+  }
+  return idle;
+}
+
+cDevice::cDevice(int DeviceNumber)
+{
+  deviceNumber = DeviceNumber;
+  channel = NULL;
+  generator = NULL;
+  for (int i = 0; i < MAXRECEIVERS; i++) receivers[i] = NULL;
+  running = true;
+  pthread_create(&thread, NULL, threadEntry, this);
+}
+
+cDevice::~cDevice()
+{
+  running = false;
+  pthread_join(thread, NULL);
+  for (int i = 0; i < MAXRECEIVERS; i++)
+  {
+    if (receivers[i]) Detach(receivers[i]);
+  }
+  delete generator;
+}
+
+bool cDevice::Receiving() const
+{
+  cMutexLock lock(&mutex);
+  for (int i = 0; i < MAXRECEIVERS; i++)
+  {
+    if (receivers[i]) return true;
+  }
+  return false;
+}
+
+bool cDevice::SwitchChannel(const cChannel* Channel, bool LiveView)
+{
+  cMutexLock lock(&mutex);
+  if (Channel == channel) return true;
+  if (Receiving()) return false;
+
+  delete generator;
+  channel = Channel;
+  generator = new cTsGenerator(channel->Vpid(), channel->Apid(0), channel->Vpid() ? bitrate : 256000);
+  dsyslog("device %d switched to channel %d", deviceNumber + 1, channel->Number());
+  return true;
+}
+
+bool cDevice::AttachReceiver(cReceiver* Receiver)
+{
+  if (!Receiver || Receiver->device == this) return true;
+  {
+    cMutexLock lock(&mutex);
+    int i;
+    for (i = 0; i < MAXRECEIVERS; i++)
+    {
+      if (!receivers[i]) break;
+    }
+    if (i == MAXRECEIVERS)
+    {
+      esyslog("ERROR: no free receiver slot on device %d", deviceNumber + 1);
+      return false;
+    }
+    receivers[i] = Receiver;
+    Receiver->device = this;
+  }
+  Receiver->Activate(true);
+  return true;
+}
+
+void cDevice::Detach(cReceiver* Receiver)
+{
+  if (!Receiver || (Receiver->device != this)) return;
+  {
+    cMutexLock lock(&mutex);
+    for (int i = 0; i < MAXRECEIVERS; i++)
+    {
+      if (receivers[i] == Receiver) receivers[i] = NULL;
+    }
+    Receiver->device = NULL;
+  }
+  Receiver->Activate(false);
+}
+
+void* cDevice::threadEntry(void* arg)
+{
+  ((cDevice*)arg)->Action();
+  return NULL;
+}
+
+void cDevice::Action()
+{
+  unsigned char* buffer = NULL;
+  int bufferSize = 0;
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  while (running)
+  {
+    int length = 0;
+    int fps = 25;
+    {
+      cMutexLock lock(&mutex);
+      if (generator && Receiving())
+      {
+        fps = generator->Fps();
+        if (bufferSize < generator->MaxFrameSize())
+        {
+          bufferSize = generator->MaxFrameSize();
+          buffer = (unsigned char*)realloc(buffer, bufferSize);
+        }
+        length = generator->NextFrame(buffer, bufferSize);
+
+        // One packet per call, like VDR's receivers get them
+        for (int offset = 0; offset < length; offset += TS_SIZE)
+        {
+          int pid = ((buffer[offset + 1] & 0x1F) << 8) | buffer[offset + 2];
+          for (int i = 0; i < MAXRECEIVERS; i++)
+          {
+            if (receivers[i] && ((pid == 0) || (pid == cTsGenerator::PMT_PID) || receivers[i]->WantsPid(pid)))
+              receivers[i]->Receive(buffer + offset, TS_SIZE);
+          }
+        }
+      }
+    }
+
+    if (!length)
+    {
+      // Idle, poll for receivers
+      cCondWait::SleepMs(20);
+      clock_gettime(CLOCK_MONOTONIC, &next);
+      continue;
+    }
+
+    next.tv_nsec += 1000000000 / fps;
+    if (next.tv_nsec >= 1000000000)
+    {
+      next.tv_sec++;
+      next.tv_nsec -= 1000000000;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  free(buffer);
+}
+
+// ---- cReceiver ---------------------------------------------------------------
+
+cReceiver::cReceiver(const cChannel* Channel, int Priority)
+{
+  device = NULL;
+  priority = Priority;
+  numPids = 0;
+  if (Channel)
+  {
+    channelID = Channel->GetChannelID();
+    AddPid(Channel->Vpid());
+    if (Channel->Ppid() != Channel->Vpid()) AddPid(Channel->Ppid());
+    for (int i = 0; Channel->Apid(i); i++) AddPid(Channel->Apid(i));
+    for (int i = 0; Channel->Dpid(i); i++) AddPid(Channel->Dpid(i));
+    for (int i = 0; Channel->Spid(i); i++) AddPid(Channel->Spid(i));
+  }
+}
+
+cReceiver::~cReceiver()
+{
+  if (device)
+  {
+    esyslog("ERROR: receiver still attached in destructor");
+    Detach();
+  }
+}
+
+bool cReceiver::AddPid(int Pid)
+{
+  if (!Pid || WantsPid(Pid)) return true;
+  if (numPids >= (int)(sizeof(pids) / sizeof(pids[0]))) return false;
+  pids[numPids++] = Pid;
+  return true;
+}
+
+bool cReceiver::WantsPid(int Pid)
+{
+  for (int i = 0; i < numPids; i++)
+  {
+    if (pids[i] == Pid) return true;
+  }
+  return false;
+}
+
+void cReceiver::Detach()
+{
+  if (device) device->Detach(this);
+}
@@ -0,0 +1,238 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "vdr/epg.h"
+
+static cSchedules schedules;
+
+// ---- cComponents -------------------------------------------------------------
+
+cComponents::cComponents()
+{
+  components = NULL;
+  numComponents = 0;
+}
+
+cComponents::~cComponents()
+{
+  for (int i = 0; i < numComponents; i++) free(components[i].description);
+  free(components);
+}
+
+void cComponents::SetComponent(int Index, uchar Stream, uchar Type, const char* Language, const char* Description)
+{
+  if (Index >= numComponents)
+  {
+    components = (tComponent*)realloc(components, (Index + 1) * sizeof(tComponent));
+    memset(&components[numComponents], 0, (Index + 1 - numComponents) * sizeof(tComponent));
+    numComponents = Index + 1;
+  }
+  tComponent* c = &components[Index];
+  c->stream = Stream;
+  c->type = Type;
+  snprintf(c->language, sizeof(c->language), "%s", Language ? Language : "");
+  free(c->description);
+  c->description = Description ? strdup(Description) : NULL;
+}
+
+// ---- cEvent ------------------------------------------------------------------
+
+cEvent::cEvent(uint32_t EventID)
+{
+  schedule = NULL;
+  eventID = EventID;
+  title = shortText = description = NULL;
+  components = NULL;
+  startTime = 0;
+  duration = 0;
+  seen = 0;
+}
+
+cEvent::~cEvent()
+{
+  free(title);
+  free(shortText);
+  free(description);
+  delete components;
+}
+
+void cEvent::SetTitle(const char* Title)
+{
+  free(title);
+  title = Title ? strdup(Title) : NULL;
+}
+
+void cEvent::SetShortText(const char* ShortText)
+{
+  free(shortText);
+  shortText = ShortText ? strdup(ShortText) : NULL;
+}
+
+void cEvent::SetDescription(const char* Description)
+{
+  free(description);
+  description = Description ? strdup(Description) : NULL;
+}
+
+void cEvent::SetComponents(cComponents* Components)
+{
+  delete components;
+  components = Components;
+}
+
+// ---- cSchedule ---------------------------------------------------------------
+
+cSchedule::cSchedule(tChannelID ChannelID)
+{
+  channelID = ChannelID;
+  modified = 0;
+}
+
+const cEvent* cSchedule::GetPresentEvent() const
+{
+  return GetEventAround(time(NULL));
+}
+
+const cEvent* cSchedule::GetFollowingEvent() const
+{
+  const cEvent* present = GetPresentEvent();
+  return present ? events.Next(present) : NULL;
+}
+
+const cEvent* cSchedule::GetEvent(uint32_t EventID, time_t StartTime) const
+{
+  for (const cEvent* event = events.First(); event; event = events.Next(event))
+  {
+    if (event->EventID() == EventID) return event;
+  }
+  return NULL;
+}
+
+const cEvent* cSchedule::GetEventAround(time_t Time) const
+{
+  for (const cEvent* event = events.First(); event; event = events.Next(event))
+  {
+    if ((event->StartTime() <= Time) && (Time < event->EndTime())) return event;
+  }
+  return NULL;
+}
+
+cEvent* cSchedule::AddEvent(cEvent* Event)
+{
+  Event->schedule = this;
+  events.Add(Event);
+  SetModified();
+  return Event;
+}
+
+// ---- cSchedules --------------------------------------------------------------
+
+cSchedules::cSchedules()
+: cList<cSchedule>("Schedules")
+{
+}
+
+const cSchedule* cSchedules::GetSchedule(tChannelID ChannelID) const
+{
+  for (const cSchedule* schedule = First(); schedule; schedule = Next(schedule))
+  {
+    if (schedule->ChannelID() == ChannelID) return schedule;
+  }
+  return NULL;
+}
+
+const cSchedule* cSchedules::GetSchedule(const cChannel* Channel, bool AddIfMissing) const
+{
+  return GetSchedule(Channel->GetChannelID());
+}
+
+cSchedule* cSchedules::AddSchedule(tChannelID ChannelID)
+{
+  cSchedule* schedule = const_cast<cSchedule*>(GetSchedule(ChannelID));
+  if (!schedule)
+  {
+    schedule = new cSchedule(ChannelID);
+    Add(schedule);
+  }
+  return schedule;
+}
+
+const cSchedules* cSchedules::GetSchedulesRead(cStateKey& StateKey, int TimeoutMs)
+{
+  return schedules.Lock(StateKey, false, TimeoutMs) ? &schedules : NULL;
+}
+
+cSchedules* cSchedules::GetSchedulesWrite(cStateKey& StateKey, int TimeoutMs)
+{
+  return schedules.Lock(StateKey, true, TimeoutMs) ? &schedules : NULL;
+}
+
+void cSchedules::CreateSynthetic(const cChannels* Channels, int eventsPerChannel)
+{
+  static const char* genres[] = { "News", "Documentary", "Film", "Series", "Sport", "Music" };
+  static const int durations[] = { 1800, 2700, 3600, 5400, 900 };
+  static const char* filler =
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+    "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+    "exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat. Duis aute irure "
+    "dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur. "
+    "Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt "
+    "mollit anim id est laborum. Sed ut perspiciatis unde omnis iste natus error sit "
+    "voluptatem accusantium doloremque laudantium.";
+
+  Clear();
+
+  // Start on a half hour boundary a few hours in the past so that clients
+  // asking for "now" find a present event on every channel
+  time_t start = time(NULL);
+  start -= start % 1800;
+  start -= 3 * 3600;
+
+  uint32_t eventID = 1;
+  for (const cChannel* channel = Channels->First(); channel; channel = Channels->Next(channel))
+  {
+    cSchedule* schedule = AddSchedule(channel->GetChannelID());
+    time_t t = start;
+    for (int i = 0; i < eventsPerChannel; i++)
+    {
+      const char* genre = genres[(channel->Number() + i) % 6];
+      cEvent* event = new cEvent(eventID++);
+      char buf[128];
+      snprintf(buf, sizeof(buf), "%s %d on %s", genre, i + 1, channel->Name());
+      event->SetTitle(buf);
+      snprintf(buf, sizeof(buf), "%s, part %d", genre, (i % 4) + 1);
+      event->SetShortText(buf);
+      cString description = cString::sprintf("%s %d. %s", genre, i + 1, filler);
+      event->SetDescription(description);
+
+      cComponents* components = new cComponents;
+      components->SetComponent(0, 1, 3, channel->Alang(0), "16:9");
+      components->SetComponent(1, 2, 3, channel->Alang(0), "stereo");
+      if (*channel->Alang(1)) components->SetComponent(2, 2, 3, channel->Alang(1), "stereo");
+      event->SetComponents(components);
+
+      event->SetStartTime(t);
+      event->SetDuration(durations[(channel->Number() * 7 + i) % 5]);
+      t += event->Duration();
+      schedule->AddEvent(event);
+    }
+  }
+  SetModified();
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  A stand-in for VDR: builds synthetic channels and EPG, scans a video
+  directory, starts the tuner devices and then loads the plugin it is
+  linked with the way VDR's plugin manager would. Lines read from stdin
+  are passed to the plugin as SVDRP commands ("PLUG vompserver" is
+  implied), e.g. STAT or STAT JSON.
+*/
+
+#include <getopt.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "vdr/channels.h"
+#include "vdr/device.h"
+#include "vdr/epg.h"
+#include "vdr/plugin.h"
+#include "vdr/recording.h"
+#include "vdr/videodir.h"
+
+extern "C" void* VDRPluginCreator(void);
+
+static cPlugin* plugin = NULL;
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [options] [-- plugin options]\n"
+                  "  -v dir      video directory (default ./video)\n"
+                  "  -c dir      config directory, the plugin's is dir/plugins/vompserver (default ./mockcfg)\n"
+                  "  -n count    number of TV channels (default 50)\n"
+                  "  -e count    EPG events per channel (default 48)\n"
+                  "  -d count    number of tuner devices (default 4)\n"
+                  "  -r bitrate  live TV bitrate in bit/s (default 4000000)\n"
+                  "  -l level    VDR log level 0-3 (default 1)\n", name);
+}
+
+// One line from fd 0. Not stdio: the plugin's Log does fflush(NULL), which
+// would block on stdin's lock for as long as a reader sits in fgets().
+static int readLine(char* line, int size)
+{
+  int l = 0;
+  char c;
+  while (read(0, &c, 1) == 1)
+  {
+    if (c == '\n')
+    {
+      line[l] = 0;
+      return 1;
+    }
+    if ((c != '\r') && (l < size - 1)) line[l++] = c;
+  }
+  line[l] = 0;
+  return l > 0;
+}
+
+static void* svdrpThread(void* arg)
+{
+  char line[1024];
+  while (readLine(line, sizeof(line)))
+  {
+    size_t l = strlen(line);
+    if (!l) continue;
+
+    char* option = strchr(line, ' ');
+    if (option)
+    {
+      *option++ = 0;
+      while (*option == ' ') option++;
+    }
+    if (!strcasecmp(line, "QUIT"))
+    {
+      kill(getpid(), SIGTERM);
+      break;
+    }
+
+    int replyCode = 900;
+    cString reply = plugin->SVDRPCommand(line, option ? option : "", replyCode);
+    if (*reply) printf("%d %s\n", replyCode, *reply);
+    else printf("502 Unknown command \"%s\"\n", line);
+    fflush(stdout);
+  }
+  return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* videoDir = "./video";
+  const char* configDir = "./mockcfg";
+  int numChannels = 50;
+  int numEvents = 48;
+  int numDevices = 4;
+  int bitrate = 4000000;
+
+  int c;
+  while ((c = getopt(argc, argv, "v:c:n:e:d:r:l:h")) != -1)
+  {
+    switch (c)
+    {
+      case 'v': videoDir = optarg; break;
+      case 'c': configDir = optarg; break;
+      case 'n': numChannels = atoi(optarg); break;
+      case 'e': numEvents = atoi(optarg); break;
+      case 'd': numDevices = atoi(optarg); break;
+      case 'r': bitrate = atoi(optarg); break;
+      case 'l': SysLogLevel = atoi(optarg); break;
+      default:
+        usage(argv[0]);
+        return (c == 'h') ? 0 : 2;
+    }
+  }
+
+  // Like VDR: signals are handled here only, writes to closed sockets are errors
+  signal(SIGPIPE, SIG_IGN);
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  cVideoDirectory::SetName(videoDir);
+  cPlugin::SetConfigDirectory(configDir);
+
+  {
+    LOCK_CHANNELS_WRITE;
+    Channels->CreateSynthetic(numChannels);
+  }
+  {
+    LOCK_CHANNELS_READ;
+    LOCK_SCHEDULES_WRITE;
+    Schedules->CreateSynthetic(Channels, numEvents);
+  }
+  {
+    LOCK_RECORDINGS_WRITE;
+    Recordings->Update();
+    isyslog("%d recordings in %s", Recordings->Count(), videoDir);
+  }
+  cDevice::Initialize(numDevices, bitrate);
+
+  plugin = (cPlugin*)VDRPluginCreator();
+  plugin->SetName("vompserver");
+
+  // Whatever follows -- goes to the plugin, with getopt reset for it
+  int pluginArgc = argc - optind + 1;
+  char** pluginArgv = new char*[pluginArgc + 1];
+  pluginArgv[0] = (char*)"vompserver";
+  for (int i = 1; i < pluginArgc; i++) pluginArgv[i] = argv[optind + i - 1];
+  pluginArgv[pluginArgc] = NULL;
+  optind = 0;
+
+  if (!plugin->ProcessArgs(pluginArgc, pluginArgv) || !plugin->Initialize() || !plugin->Start())
+  {
+    fprintf(stderr, "%s: plugin failed to start\n", argv[0]);
+    return 1;
+  }
+  fprintf(stderr, "vompserver %s running on mock VDR: %d channels, %d devices, video dir %s\n",
+          plugin->Version(), numChannels, numDevices, videoDir);
+
+  pthread_t svdrp;
+  pthread_create(&svdrp, NULL, svdrpThread, NULL);
+  pthread_detach(svdrp);
+
+  int sig;
+  sigwait(&signals, &sig);
+
+  plugin->Stop();
+  delete plugin;
+  cDevice::Shutdown();
+  delete[] pluginArgv;
+  return 0;
+}
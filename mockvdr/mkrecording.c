@@ -0,0 +1,196 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Writes synthetic TS recordings in VDR's on disk layout for the mock VDR
+  (and vompload) to play back: segment files split on I frames, the index,
+  info and marks files.
+*/
+
+#include <getopt.h>
+#include <string>
+
+#include "vdr/recording.h"
+#include "tsgen.h"
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [options]\n"
+                  "  -v dir      video directory (default ./video)\n"
+                  "  -n name     recording name, ~ separates folders (default Mock recording)\n"
+                  "  -l seconds  length (default 600)\n"
+                  "  -b bitrate  bit/s (default 4000000)\n"
+                  "  -c count    number of recordings (default 1)\n"
+                  "  -s MB       segment file size (default 100)\n", name);
+}
+
+// VDR's plain name to directory mapping, see ExchangeChars()
+static std::string toFileSystem(const char* name)
+{
+  std::string s;
+  for (const char* p = name; *p; p++)
+  {
+    switch (*p)
+    {
+      case ' ': s += '_'; break;
+      case '/': s += (char)0x02; break;
+      case '~': s += '/'; break;
+      default: s += *p;
+    }
+  }
+  return s;
+}
+
+static int makeDirs(const std::string& path)
+{
+  for (size_t i = 1; i <= path.size(); i++)
+  {
+    if ((i == path.size()) || (path[i] == '/'))
+    {
+      std::string dir = path.substr(0, i);
+      if ((mkdir(dir.c_str(), 0755) != 0) && (errno != EEXIST))
+      {
+        fprintf(stderr, "Can't create %s: %s\n", dir.c_str(), strerror(errno));
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static int writeRecording(const char* videoDir, const char* name, time_t start, int seconds, int bitrate, long long segmentBytes, int channel)
+{
+  struct tm tm;
+  localtime_r(&start, &tm);
+  char recDir[64];
+  snprintf(recDir, sizeof(recDir), "%04d-%02d-%02d.%02d.%02d.%d-0.rec",
+           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, channel);
+  std::string dir = std::string(videoDir) + "/" + toFileSystem(name) + "/" + recDir;
+  if (!makeDirs(dir)) return 0;
+
+  const int fps = 25;
+  const int vpid = 100 + (channel - 1) * 10;
+  cTsGenerator generator(vpid, vpid + 1, bitrate, fps);
+  int bufferSize = generator.MaxFrameSize();
+  unsigned char* buffer = new unsigned char[bufferSize];
+
+  FILE* index = fopen((dir + "/index").c_str(), "w");
+  FILE* segment = NULL;
+  int fileNumber = 0;
+  long long offset = 0;
+  int frames = seconds * fps;
+  for (int i = 0; i < frames; i++)
+  {
+    bool independent;
+    int length = generator.NextFrame(buffer, bufferSize, &independent);
+    if (!segment || (independent && (offset + length > segmentBytes)))
+    {
+      if (segment) fclose(segment);
+      char segmentName[16];
+      snprintf(segmentName, sizeof(segmentName), "/%05d.ts", ++fileNumber);
+      segment = fopen((dir + segmentName).c_str(), "w");
+      offset = 0;
+      if (!segment) break;
+    }
+
+    tIndexTs entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = offset;
+    entry.independent = independent;
+    entry.number = fileNumber;
+    if (fwrite(&entry, sizeof(entry), 1, index) != 1) break;
+    if (fwrite(buffer, 1, length, segment) != (size_t)length) break;
+    offset += length;
+  }
+  if (segment) fclose(segment);
+  if (index) fclose(index);
+  delete[] buffer;
+
+  FILE* info = fopen((dir + "/info").c_str(), "w");
+  if (info)
+  {
+    fprintf(info, "C S19.2E-1-%d-%d Channel %d\n", 1000 + (channel - 1) / 8, 10000 + channel - 1, channel);
+    fprintf(info, "E %d %ld %d 4E 0\n", channel * 1000, (long)start, seconds);
+    const char* title = strrchr(name, '~');
+    fprintf(info, "T %s\n", title ? title + 1 : name);
+    fprintf(info, "S Mock recording, %d minutes\n", seconds / 60);
+    fprintf(info, "D Synthetic MPEG-2 recording written by mkrecording.|It decodes to nothing useful.\n");
+    fprintf(info, "X 1 03 deu 16:9\n");
+    fprintf(info, "X 2 03 deu stereo\n");
+    fprintf(info, "F %d\n", fps);
+    fprintf(info, "P 50\n");
+    fprintf(info, "L 99\n");
+    fclose(info);
+  }
+
+  FILE* marks = fopen((dir + "/marks").c_str(), "w");
+  if (marks)
+  {
+    int first = seconds / 10, last = seconds - seconds / 10;
+    fprintf(marks, "%d:%02d:%02d.01 start\n", first / 3600, (first / 60) % 60, first % 60);
+    fprintf(marks, "%d:%02d:%02d.01 end\n", last / 3600, (last / 60) % 60, last % 60);
+    fclose(marks);
+  }
+
+  printf("%s: %d frames in %d files\n", dir.c_str(), frames, fileNumber);
+  return 1;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* videoDir = "./video";
+  const char* name = "Mock recording";
+  int seconds = 600;
+  int bitrate = 4000000;
+  int count = 1;
+  int segmentMB = 100;
+
+  int c;
+  while ((c = getopt(argc, argv, "v:n:l:b:c:s:h")) != -1)
+  {
+    switch (c)
+    {
+      case 'v': videoDir = optarg; break;
+      case 'n': name = optarg; break;
+      case 'l': seconds = atoi(optarg); break;
+      case 'b': bitrate = atoi(optarg); break;
+      case 'c': count = atoi(optarg); break;
+      case 's': segmentMB = atoi(optarg); break;
+      default:
+        usage(argv[0]);
+        return (c == 'h') ? 0 : 2;
+    }
+  }
+  if ((seconds <= 0) || (bitrate <= 0) || (count <= 0) || (segmentMB <= 0))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  time_t now = time(NULL);
+  for (int i = 0; i < count; i++)
+  {
+    std::string recName = name;
+    if (count > 1) recName += " " + std::to_string(i + 1);
+    time_t start = now - seconds - 3600 * (i + 1);
+    if (!writeRecording(videoDir, recName.c_str(), start, seconds, bitrate, segmentMB * 1024LL * 1024LL, (i % 10) + 1)) return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "vdr/plugin.h"
+#include "vdr/remote.h"
+
+static char* configDirectory = NULL;
+static char* resourceDirectory = NULL;
+static char* cacheDirectory = NULL;
+
+cPlugin::cPlugin()
+{
+  name = NULL;
+}
+
+cPlugin::~cPlugin()
+{
+}
+
+void cPlugin::SetConfigDirectory(const char* Dir)
+{
+  free(configDirectory);
+  configDirectory = strdup(Dir);
+}
+
+void cPlugin::SetResourceDirectory(const char* Dir)
+{
+  free(resourceDirectory);
+  resourceDirectory = strdup(Dir);
+}
+
+void cPlugin::SetCacheDirectory(const char* Dir)
+{
+  free(cacheDirectory);
+  cacheDirectory = strdup(Dir);
+}
+
+// Like VDR: <dir>/plugins[/<name>], created if missing
+static const char* pluginDirectory(const char* Base, const char* PluginName, cString& Buffer)
+{
+  if (!Base) return NULL;
+  Buffer = cString::sprintf("%s/plugins%s%s", Base, PluginName ? "/" : "", PluginName ? PluginName : "");
+  cString plugins = cString::sprintf("%s/plugins", Base);
+  mkdir(Base, 0755);
+  mkdir(plugins, 0755);
+  if (PluginName) mkdir(Buffer, 0755);
+  return Buffer;
+}
+
+const char* cPlugin::ConfigDirectory(const char* PluginName)
+{
+  static cString buffer;
+  return pluginDirectory(configDirectory, PluginName, buffer);
+}
+
+const char* cPlugin::ResourceDirectory(const char* PluginName)
+{
+  static cString buffer;
+  return pluginDirectory(resourceDirectory ? resourceDirectory : configDirectory, PluginName, buffer);
+}
+
+const char* cPlugin::CacheDirectory(const char* PluginName)
+{
+  static cString buffer;
+  return pluginDirectory(cacheDirectory ? cacheDirectory : configDirectory, PluginName, buffer);
+}
+
+bool cRemote::Put(eKeys Key, bool AtFront)
+{
+  isyslog("remote key %d", (int)Key);
+  return true;
+}
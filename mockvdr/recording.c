@@ -0,0 +1,575 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <math.h>
+#include <sys/statvfs.h>
+
+#include "vdr/recording.h"
+#include "vdr/videodir.h"
+
+#define INFOFILESUFFIX   "/info"
+#define INDEXFILESUFFIX  "/index"
+#define MARKSFILESUFFIX  "/marks"
+#define RESUMEFILESUFFIX "/resume"
+#define RECEXT           ".rec"
+#define DELEXT           ".del"
+#define MEGABYTE(n)      ((n) * 1024LL * 1024LL)
+
+static cRecordings recordings;
+
+// ---- cVideoDirectory ---------------------------------------------------------
+
+char* cVideoDirectory::name = strdup("/video");
+
+void cVideoDirectory::SetName(const char* Name)
+{
+  free(name);
+  name = strdup(Name);
+  // No trailing slash, recording names are derived from what follows it
+  size_t l = strlen(name);
+  while ((l > 1) && (name[l - 1] == '/')) name[--l] = 0;
+}
+
+int cVideoDirectory::VideoDiskSpace(int* FreeMB, int* UsedMB)
+{
+  struct statvfs st;
+  if (statvfs(name, &st) != 0)
+  {
+    if (FreeMB) *FreeMB = 0;
+    if (UsedMB) *UsedMB = 0;
+    return 0;
+  }
+  long long total = (long long)st.f_blocks * st.f_frsize / MEGABYTE(1);
+  long long free = (long long)st.f_bavail * st.f_frsize / MEGABYTE(1);
+  if (FreeMB) *FreeMB = (int)free;
+  if (UsedMB) *UsedMB = (int)(total - free);
+  return total ? (int)((total - free) * 100 / total) : 0;
+}
+
+// ---- Name mapping ------------------------------------------------------------
+
+/*
+  VDR's plain (non DirectoryEncoding) mapping between recording names and
+  directory names: blanks are stored as '_', a '/' in a name is stored as
+  0x02 and the folder delimiter '~' becomes a directory level.
+*/
+
+char* ExchangeChars(char* s, bool ToFileSystem)
+{
+  for (char* p = s; *p; p++)
+  {
+    if (ToFileSystem)
+    {
+      switch (*p)
+      {
+        case ' ': *p = '_'; break;
+        case '/': *p = 0x02; break;
+        case '~': *p = '/'; break;
+      }
+    }
+    else
+    {
+      switch (*p)
+      {
+        case '_': *p = ' '; break;
+        case 0x02: *p = '/'; break;
+        case '/': *p = '~'; break;
+      }
+    }
+  }
+  return s;
+}
+
+// ---- cRecordingInfo ----------------------------------------------------------
+
+cRecordingInfo::cRecordingInfo(const char* FileName)
+{
+  channelName = NULL;
+  event = new cEvent(0);
+  aux = NULL;
+  framesPerSecond = DEFAULTFRAMESPERSECOND;
+  priority = 50;
+  lifetime = 99;
+  fileName = NULL;
+  if (asprintf(&fileName, "%s%s", FileName, INFOFILESUFFIX) < 0) fileName = NULL;
+}
+
+cRecordingInfo::~cRecordingInfo()
+{
+  delete event;
+  free(channelName);
+  free(aux);
+  free(fileName);
+}
+
+bool cRecordingInfo::Read()
+{
+  if (!fileName) return false;
+  FILE* f = fopen(fileName, "r");
+  if (!f) return false;
+
+  cComponents* components = NULL;
+  int numComponents = 0;
+  char line[4096];
+  while (fgets(line, sizeof(line), f))
+  {
+    size_t l = strlen(line);
+    while (l && ((line[l - 1] == '\n') || (line[l - 1] == '\r'))) line[--l] = 0;
+    if (l < 2) continue;
+
+    char* value = line + 2;
+    switch (line[0])
+    {
+      case 'C':
+      {
+        char* name = strchr(value, ' ');
+        if (name) *name++ = 0;
+        channelID = tChannelID::FromString(value);
+        free(channelName);
+        channelName = name ? strdup(name) : NULL;
+        break;
+      }
+      case 'E':
+      {
+        unsigned int id = 0;
+        long startTime = 0;
+        int duration = 0;
+        if (sscanf(value, "%u %ld %d", &id, &startTime, &duration) >= 3)
+        {
+          cEvent* e = new cEvent(id);
+          e->SetStartTime(startTime);
+          e->SetDuration(duration);
+          delete event;
+          event = e;
+        }
+        break;
+      }
+      case 'T': event->SetTitle(value); break;
+      case 'S': event->SetShortText(value); break;
+      case 'D':
+      {
+        // Line breaks in the description are stored as '|'
+        for (char* p = value; *p; p++) if (*p == '|') *p = '\n';
+        event->SetDescription(value);
+        break;
+      }
+      case 'X':
+      {
+        unsigned int stream = 0, type = 0;
+        char language[MAXLANGCODE2] = "";
+        int n = 0;
+        if (sscanf(value, "%x %x %7s %n", &stream, &type, language, &n) >= 3)
+        {
+          if (!components) components = new cComponents;
+          components->SetComponent(numComponents++, stream, type, language, n ? value + n : NULL);
+        }
+        break;
+      }
+      case 'F': framesPerSecond = atof(value); break;
+      case 'P': priority = atoi(value); break;
+      case 'L': lifetime = atoi(value); break;
+      case '@':
+        free(aux);
+        aux = strdup(value);
+        break;
+    }
+  }
+  fclose(f);
+
+  if (components) event->SetComponents(components);
+  if (framesPerSecond <= 0) framesPerSecond = DEFAULTFRAMESPERSECOND;
+  return true;
+}
+
+// ---- cRecording --------------------------------------------------------------
+
+cRecording::cRecording(const char* FileName)
+{
+  fileName = strdup(FileName);
+  size_t l = strlen(fileName);
+  while ((l > 1) && (fileName[l - 1] == '/')) fileName[--l] = 0;
+
+  // The name is the path below the video directory without the .rec level
+  const char* videoDir = cVideoDirectory::Name();
+  const char* relative = fileName;
+  if (!strncmp(fileName, videoDir, strlen(videoDir)) && (fileName[strlen(videoDir)] == '/'))
+    relative = fileName + strlen(videoDir) + 1;
+  name = strdup(relative);
+  char* last = strrchr(name, '/');
+  if (last) *last = 0;
+  ExchangeChars(name, false);
+
+  // YYYY-MM-DD.HH.MM.CH-RI.rec
+  start = 0;
+  const char* base = strrchr(fileName, '/');
+  base = base ? base + 1 : fileName;
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  if (sscanf(base, "%d-%d-%d.%d.%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min) == 5)
+  {
+    tm.tm_year -= 1900;
+    tm.tm_mon--;
+    tm.tm_isdst = -1;
+    start = mktime(&tm);
+  }
+
+  info = new cRecordingInfo(fileName);
+  info->Read();
+  priority = info->priority;
+  lifetime = info->lifetime;
+
+  char* resumeName = NULL;
+  if (asprintf(&resumeName, "%s%s", fileName, RESUMEFILESUFFIX) < 0) resumeName = NULL;
+  isNew = resumeName && (access(resumeName, F_OK) != 0);
+  free(resumeName);
+}
+
+cRecording::~cRecording()
+{
+  delete info;
+  free(name);
+  free(fileName);
+}
+
+int cRecording::LengthInSeconds() const
+{
+  int frames = cIndexFile::GetLength(fileName);
+  if (frames < 0) return -1;
+  return (int)(frames / FramesPerSecond() + 0.5);
+}
+
+int cRecording::FileSizeMB() const
+{
+  long long size = 0;
+  char segment[PATH_MAX];
+  for (int i = 1; i < 65535; i++)
+  {
+    snprintf(segment, sizeof(segment), "%s/%05d.ts", fileName, i);
+    struct stat st;
+    if (stat(segment, &st) != 0) break;
+    size += st.st_size;
+  }
+  return (int)(size / MEGABYTE(1));
+}
+
+bool cRecording::Delete()
+{
+  // Like VDR, rename to .del and leave the actual removal to someone else
+  size_t l = strlen(fileName);
+  if ((l < strlen(RECEXT)) || strcmp(fileName + l - strlen(RECEXT), RECEXT)) return false;
+  char* newName = strdup(fileName);
+  strcpy(newName + l - strlen(RECEXT), DELEXT);
+  bool result = (rename(fileName, newName) == 0);
+  if (!result) esyslog("ERROR: can't rename %s to %s: %s", fileName, newName, strerror(errno));
+  free(newName);
+  return result;
+}
+
+bool cRecording::ChangeName(const char* NewName)
+{
+  char* dirName = strdup(NewName);
+  ExchangeChars(dirName, true);
+  const char* base = strrchr(fileName, '/');
+  base = base ? base + 1 : fileName;
+
+  char newFileName[PATH_MAX];
+  snprintf(newFileName, sizeof(newFileName), "%s/%s", cVideoDirectory::Name(), dirName);
+  free(dirName);
+
+  // Create the intermediate directories
+  for (char* p = newFileName + strlen(cVideoDirectory::Name()) + 1; *p; p++)
+  {
+    if (*p != '/') continue;
+    *p = 0;
+    mkdir(newFileName, 0755);
+    *p = '/';
+  }
+  mkdir(newFileName, 0755);
+
+  size_t l = strlen(newFileName);
+  snprintf(newFileName + l, sizeof(newFileName) - l, "/%s", base);
+  if (rename(fileName, newFileName) != 0)
+  {
+    esyslog("ERROR: can't rename %s to %s: %s", fileName, newFileName, strerror(errno));
+    return false;
+  }
+  free(fileName);
+  fileName = strdup(newFileName);
+  free(name);
+  name = strdup(NewName);
+  return true;
+}
+
+// ---- cRecordings -------------------------------------------------------------
+
+cRecordings::cRecordings(bool Deleted)
+: cList<cRecording>("Recordings")
+{
+}
+
+const cRecording* cRecordings::GetByName(const char* FileName) const
+{
+  if (!FileName) return NULL;
+  for (const cRecording* recording = First(); recording; recording = Next(recording))
+  {
+    if (!strcmp(recording->FileName(), FileName)) return recording;
+  }
+  return NULL;
+}
+
+cRecording* cRecordings::GetByName(const char* FileName)
+{
+  return const_cast<cRecording*>(static_cast<const cRecordings*>(this)->GetByName(FileName));
+}
+
+void cRecordings::DelByName(const char* FileName)
+{
+  cRecording* recording = GetByName(FileName);
+  if (recording) Del(recording);
+}
+
+void cRecordings::Update(bool Wait)
+{
+  Clear();
+  ScanVideoDir(cVideoDirectory::Name());
+  SetModified();
+}
+
+void cRecordings::ScanVideoDir(const char* DirName)
+{
+  DIR* dir = opendir(DirName);
+  if (!dir) return;
+
+  struct dirent* e;
+  while ((e = readdir(dir)))
+  {
+    if (e->d_name[0] == '.') continue;
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", DirName, e->d_name);
+    struct stat st;
+    if ((stat(path, &st) != 0) || !S_ISDIR(st.st_mode)) continue;
+
+    size_t l = strlen(e->d_name);
+    if ((l > strlen(RECEXT)) && !strcmp(e->d_name + l - strlen(RECEXT), RECEXT))
+      Add(new cRecording(path));
+    else if ((l <= strlen(DELEXT)) || strcmp(e->d_name + l - strlen(DELEXT), DELEXT))
+      ScanVideoDir(path);
+  }
+  closedir(dir);
+}
+
+const cRecordings* cRecordings::GetRecordingsRead(cStateKey& StateKey, int TimeoutMs)
+{
+  return recordings.Lock(StateKey, false, TimeoutMs) ? &recordings : NULL;
+}
+
+cRecordings* cRecordings::GetRecordingsWrite(cStateKey& StateKey, int TimeoutMs)
+{
+  return recordings.Lock(StateKey, true, TimeoutMs) ? &recordings : NULL;
+}
+
+// ---- cResumeFile -------------------------------------------------------------
+
+cResumeFile::cResumeFile(const char* FileName, bool IsPesRecording)
+{
+  if (asprintf(&fileName, "%s%s", FileName, RESUMEFILESUFFIX) < 0) fileName = NULL;
+}
+
+cResumeFile::~cResumeFile()
+{
+  free(fileName);
+}
+
+int cResumeFile::Read()
+{
+  if (!fileName) return -1;
+  FILE* f = fopen(fileName, "r");
+  if (!f) return -1;
+
+  int resume = -1;
+  char line[256];
+  while (fgets(line, sizeof(line), f))
+  {
+    if ((line[0] == 'I') && (line[1] == ' ')) resume = atoi(line + 2);
+  }
+  fclose(f);
+  return resume;
+}
+
+bool cResumeFile::Save(int Index)
+{
+  if (!fileName) return false;
+  FILE* f = fopen(fileName, "w");
+  if (!f) return false;
+  fprintf(f, "I %d\n", Index);
+  fclose(f);
+  return true;
+}
+
+void cResumeFile::Delete()
+{
+  if (fileName) unlink(fileName);
+}
+
+// ---- cMarks ------------------------------------------------------------------
+
+cMark::cMark(int Position, const char* Comment, double FramesPerSecond)
+{
+  position = Position;
+  comment = Comment ? strdup(Comment) : NULL;
+}
+
+cMark::~cMark()
+{
+  free(comment);
+}
+
+bool cMarks::Load(const char* RecordingFileName, double FramesPerSecond, bool IsPesRecording)
+{
+  Clear();
+  char marksName[PATH_MAX];
+  snprintf(marksName, sizeof(marksName), "%s%s", RecordingFileName, MARKSFILESUFFIX);
+  FILE* f = fopen(marksName, "r");
+  if (!f) return false;
+
+  // H:MM:SS.FF [comment], frames counted from 1
+  char line[256];
+  while (fgets(line, sizeof(line), f))
+  {
+    int h, m, s, frame = 1, n = 0;
+    if (sscanf(line, "%d:%d:%d%n", &h, &m, &s, &n) < 3) continue;
+    if (line[n] == '.')
+    {
+      int fn = 0;
+      sscanf(line + n + 1, "%d%n", &frame, &fn);
+      n += 1 + fn;
+    }
+    while ((line[n] == ' ') || (line[n] == '\t')) n++;
+    char* comment = line + n;
+    size_t l = strlen(comment);
+    while (l && ((comment[l - 1] == '\n') || (comment[l - 1] == '\r'))) comment[--l] = 0;
+
+    int position = (int)round((h * 3600 + m * 60 + s) * FramesPerSecond) + frame - 1;
+    Add(new cMark(position, l ? comment : NULL, FramesPerSecond));
+  }
+  fclose(f);
+  return true;
+}
+
+// ---- cIndexFile --------------------------------------------------------------
+
+cIndexFile::cIndexFile(const char* FileName, bool Record, bool IsPesRecording, bool PauseLive, bool Update)
+{
+  index = NULL;
+  last = -1;
+  fileName = strdup(FileName);
+
+  char indexName[PATH_MAX];
+  snprintf(indexName, sizeof(indexName), "%s%s", FileName, INDEXFILESUFFIX);
+  int fd = open(indexName, O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat st;
+  if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(tIndexTs)))
+  {
+    int entries = st.st_size / sizeof(tIndexTs);
+    index = (tIndexTs*)malloc(entries * sizeof(tIndexTs));
+    if (index && (read(fd, index, entries * sizeof(tIndexTs)) == (ssize_t)(entries * sizeof(tIndexTs))))
+    {
+      last = entries - 1;
+    }
+    else
+    {
+      free(index);
+      index = NULL;
+    }
+  }
+  close(fd);
+}
+
+cIndexFile::~cIndexFile()
+{
+  free(index);
+  free(fileName);
+}
+
+// Length of frame Index: up to the next entry or the end of its file
+static int frameLength(const tIndexTs* index, int last, const char* fileName, int Index)
+{
+  if ((Index < last) && (index[Index + 1].number == index[Index].number))
+    return (int)(index[Index + 1].offset - index[Index].offset);
+
+  char segment[PATH_MAX];
+  snprintf(segment, sizeof(segment), "%s/%05d.ts", fileName, (int)index[Index].number);
+  struct stat st;
+  if (stat(segment, &st) != 0) return -1;
+  return (int)(st.st_size - (off_t)index[Index].offset);
+}
+
+bool cIndexFile::Get(int Index, uint16_t* FileNumber, off_t* FileOffset, bool* Independent, int* Length)
+{
+  if (!index || (Index < 0) || (Index > last)) return false;
+  *FileNumber = index[Index].number;
+  *FileOffset = index[Index].offset;
+  if (Independent) *Independent = index[Index].independent;
+  if (Length) *Length = frameLength(index, last, fileName, Index);
+  return true;
+}
+
+int cIndexFile::GetNextIFrame(int Index, bool Forward, uint16_t* FileNumber, off_t* FileOffset, int* Length)
+{
+  if (!index) return -1;
+  int d = Forward ? 1 : -1;
+  for (Index += d; (Index >= 0) && (Index <= last); Index += d)
+  {
+    if (!index[Index].independent) continue;
+    if (FileNumber) *FileNumber = index[Index].number;
+    if (FileOffset) *FileOffset = index[Index].offset;
+    if (Length) *Length = frameLength(index, last, fileName, Index);
+    return Index;
+  }
+  return -1;
+}
+
+int cIndexFile::Get(uint16_t FileNumber, off_t FileOffset)
+{
+  if (!index) return -1;
+  // First frame at or after the position, entries are in file order
+  int lo = 0, hi = last + 1;
+  while (lo < hi)
+  {
+    int mid = (lo + hi) / 2;
+    if ((index[mid].number < FileNumber) || ((index[mid].number == FileNumber) && ((off_t)index[mid].offset < FileOffset)))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+int cIndexFile::GetLength(const char* FileName, bool IsPesRecording)
+{
+  char indexName[PATH_MAX];
+  snprintf(indexName, sizeof(indexName), "%s%s", FileName, INDEXFILESUFFIX);
+  struct stat st;
+  if (stat(indexName, &st) != 0) return -1;
+  return st.st_size / sizeof(tIndexTs);
+}
@@ -0,0 +1,218 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "vdr/thread.h"
+
+static void absTime(struct timespec* ts, int timeoutMs)
+{
+  clock_gettime(CLOCK_REALTIME, ts);
+  ts->tv_sec += timeoutMs / 1000;
+  ts->tv_nsec += (timeoutMs % 1000) * 1000000;
+  if (ts->tv_nsec >= 1000000000)
+  {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000;
+  }
+}
+
+// ---- cMutex ------------------------------------------------------------------
+
+cMutex::cMutex()
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE); // like VDR's
+  pthread_mutex_init(&mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+cMutex::~cMutex()
+{
+  pthread_mutex_destroy(&mutex);
+}
+
+void cMutex::Lock()
+{
+  pthread_mutex_lock(&mutex);
+}
+
+void cMutex::Unlock()
+{
+  pthread_mutex_unlock(&mutex);
+}
+
+cMutexLock::cMutexLock(cMutex* Mutex)
+{
+  mutex = Mutex;
+  if (mutex) mutex->Lock();
+}
+
+cMutexLock::~cMutexLock()
+{
+  if (mutex) mutex->Unlock();
+}
+
+// ---- cCondWait ---------------------------------------------------------------
+
+cCondWait::cCondWait()
+{
+  signaled = false;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&cond, NULL);
+}
+
+cCondWait::~cCondWait()
+{
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&mutex);
+}
+
+void cCondWait::SleepMs(int TimeoutMs)
+{
+  usleep((TimeoutMs > 3 ? TimeoutMs : 3) * 1000);
+}
+
+bool cCondWait::Wait(int TimeoutMs)
+{
+  pthread_mutex_lock(&mutex);
+  if (!signaled)
+  {
+    if (TimeoutMs)
+    {
+      struct timespec abstime;
+      absTime(&abstime, TimeoutMs);
+      while (!signaled)
+      {
+        if (pthread_cond_timedwait(&cond, &mutex, &abstime) == ETIMEDOUT) break;
+      }
+    }
+    else
+    {
+      while (!signaled) pthread_cond_wait(&cond, &mutex);
+    }
+  }
+  bool r = signaled;
+  signaled = false;
+  pthread_mutex_unlock(&mutex);
+  return r;
+}
+
+void cCondWait::Signal()
+{
+  pthread_mutex_lock(&mutex);
+  signaled = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+}
+
+// ---- cRwLock -----------------------------------------------------------------
+
+cRwLock::cRwLock()
+{
+  pthread_rwlock_init(&rwlock, NULL);
+}
+
+cRwLock::~cRwLock()
+{
+  pthread_rwlock_destroy(&rwlock);
+}
+
+bool cRwLock::Lock(bool Write, int TimeoutMs)
+{
+  if (TimeoutMs)
+  {
+    struct timespec abstime;
+    absTime(&abstime, TimeoutMs);
+    if (Write) return pthread_rwlock_timedwrlock(&rwlock, &abstime) == 0;
+    return pthread_rwlock_timedrdlock(&rwlock, &abstime) == 0;
+  }
+  if (Write) return pthread_rwlock_wrlock(&rwlock) == 0;
+  return pthread_rwlock_rdlock(&rwlock) == 0;
+}
+
+void cRwLock::Unlock()
+{
+  pthread_rwlock_unlock(&rwlock);
+}
+
+// ---- cStateLock / cStateKey --------------------------------------------------
+
+cStateLock::cStateLock(const char* Name)
+{
+  name = Name;
+  state = 1; // lists count as modified once they are loaded
+}
+
+bool cStateLock::Lock(cStateKey& StateKey, bool Write, int TimeoutMs)
+{
+  if (!rwLock.Lock(Write, TimeoutMs))
+  {
+    StateKey.timedOut = true;
+    return false;
+  }
+
+  // Like VDR, a reader that has seen this state before gets nothing
+  if (!Write && (StateKey.state == state))
+  {
+    rwLock.Unlock();
+    return false;
+  }
+
+  StateKey.stateLock = this;
+  StateKey.write = Write;
+  StateKey.timedOut = false;
+  return true;
+}
+
+void cStateLock::Unlock(cStateKey& StateKey, bool IncState)
+{
+  if (StateKey.write && IncState) __sync_fetch_and_add(&state, 1);
+  StateKey.state = state;
+  StateKey.stateLock = NULL;
+  rwLock.Unlock();
+}
+
+cStateKey::cStateKey(bool IgnoreFirst)
+{
+  stateLock = NULL;
+  write = false;
+  state = IgnoreFirst ? 0 : -1; // -1 never matches a lock's state
+  timedOut = false;
+}
+
+cStateKey::~cStateKey()
+{
+  if (stateLock) Remove(); // VDR logs an error here, the LOCK_ macros rely on it
+}
+
+void cStateKey::Remove(bool IncState)
+{
+  if (stateLock) stateLock->Unlock(*this, IncState);
+}
+
+bool cStateKey::StateChanged()
+{
+  return stateLock && (state != stateLock->state);
+}
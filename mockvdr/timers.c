@@ -0,0 +1,141 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "vdr/timers.h"
+
+static cTimers timers;
+
+cTimer::cTimer()
+{
+  flags = tfNone;
+  channel = NULL;
+  day = 0;
+  weekdays = 0;
+  start = stop = 0;
+  priority = 50;
+  lifetime = 99;
+  file = strdup("");
+}
+
+cTimer::~cTimer()
+{
+  free(file);
+}
+
+// Midnight of a YYYY-MM-DD day, local time
+static time_t parseDay(const char* s)
+{
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  if (sscanf(s, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3) return 0;
+  tm.tm_year -= 1900;
+  tm.tm_mon--;
+  tm.tm_isdst = -1;
+  return mktime(&tm);
+}
+
+/*
+  flags:channel:day:start:stop:priority:lifetime:file:aux where day is
+  YYYY-MM-DD or a weekday mask like MTWTF-- optionally followed by
+  @YYYY-MM-DD.
+*/
+
+bool cTimer::Parse(const char* s)
+{
+  char* copy = strdup(s);
+  char* fields[9];
+  int numFields = 0;
+  char* p = copy;
+  while (numFields < 9)
+  {
+    fields[numFields++] = p;
+    char* colon = (numFields < 9) ? strchr(p, ':') : NULL;
+    if (!colon) break;
+    *colon = 0;
+    p = colon + 1;
+  }
+  if (numFields < 8)
+  {
+    free(copy);
+    return false;
+  }
+
+  flags = strtoul(fields[0], NULL, 10);
+
+  int channelNumber = atoi(fields[1]);
+  {
+    LOCK_CHANNELS_READ;
+    channel = Channels ? Channels->GetByNumber(channelNumber) : NULL;
+  }
+
+  weekdays = 0;
+  day = 0;
+  const char* d = fields[2];
+  if ((strlen(d) >= 10) && (d[4] == '-'))
+  {
+    day = parseDay(d);
+  }
+  else if (strlen(d) >= 7)
+  {
+    for (int i = 0; i < 7; i++) if (d[i] != '-') weekdays |= (1 << i);
+    if (d[7] == '@') day = parseDay(d + 8);
+  }
+
+  start = atoi(fields[3]);
+  stop = atoi(fields[4]);
+  priority = atoi(fields[5]);
+  lifetime = atoi(fields[6]);
+  free(file);
+  file = strdup(fields[7]);
+  free(copy);
+
+  return channel && (day || weekdays);
+}
+
+cTimers::cTimers()
+: cList<cTimer>("Timers")
+{
+}
+
+const cTimer* cTimers::GetTimer(const cTimer* Timer) const
+{
+  for (const cTimer* ti = First(); ti; ti = Next(ti))
+  {
+    if ((ti->Channel() == Timer->Channel()) && (ti->Day() == Timer->Day()) && (ti->WeekDays() == Timer->WeekDays())
+        && (ti->Start() == Timer->Start()) && (ti->Stop() == Timer->Stop()))
+      return ti;
+  }
+  return NULL;
+}
+
+cTimer* cTimers::GetTimer(const cTimer* Timer)
+{
+  return const_cast<cTimer*>(static_cast<const cTimers*>(this)->GetTimer(Timer));
+}
+
+const cTimers* cTimers::GetTimersRead(cStateKey& StateKey, int TimeoutMs)
+{
+  return timers.Lock(StateKey, false, TimeoutMs) ? &timers : NULL;
+}
+
+cTimers* cTimers::GetTimersWrite(cStateKey& StateKey, int TimeoutMs)
+{
+  return timers.Lock(StateKey, true, TimeoutMs) ? &timers : NULL;
+}
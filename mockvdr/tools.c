@@ -0,0 +1,278 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdarg.h>
+
+#include "vdr/config.h"
+#include "vdr/tools.h"
+#include "vdr/i18n.h"
+
+int SysLogLevel = 1;
+
+// ---- cString -----------------------------------------------------------------
+
+cString::cString(const char* S, bool TakePointer)
+{
+  s = TakePointer ? (char*)S : (S ? strdup(S) : NULL);
+}
+
+cString::cString(const cString& String)
+{
+  s = String.s ? strdup(String.s) : NULL;
+}
+
+cString::~cString()
+{
+  free(s);
+}
+
+cString& cString::operator=(const cString& String)
+{
+  if (this == &String) return *this;
+  free(s);
+  s = String.s ? strdup(String.s) : NULL;
+  return *this;
+}
+
+cString& cString::operator=(const char* String)
+{
+  if (s == String) return *this;
+  free(s);
+  s = String ? strdup(String) : NULL;
+  return *this;
+}
+
+cString cString::sprintf(const char* fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  char* buffer;
+  if (vasprintf(&buffer, fmt, ap) < 0) buffer = NULL;
+  va_end(ap);
+  return cString(buffer, true);
+}
+
+// ---- cCharSetConv ------------------------------------------------------------
+
+char* cCharSetConv::systemCharacterTable = NULL;
+
+cCharSetConv::cCharSetConv(const char* FromCode, const char* ToCode)
+{
+  if (!FromCode) FromCode = systemCharacterTable ? systemCharacterTable : "UTF-8";
+  if (!ToCode) ToCode = "UTF-8";
+  cd = iconv_open(ToCode, FromCode);
+  result = NULL;
+  length = 0;
+}
+
+cCharSetConv::~cCharSetConv()
+{
+  free(result);
+  if (cd != (iconv_t)-1) iconv_close(cd);
+}
+
+void cCharSetConv::SetSystemCharacterTable(const char* CharacterTable)
+{
+  free(systemCharacterTable);
+  systemCharacterTable = CharacterTable ? strdup(CharacterTable) : NULL;
+}
+
+const char* cCharSetConv::Convert(const char* From, char* To, size_t ToLength)
+{
+  if ((cd == (iconv_t)-1) || !From || !*From) return From;
+
+  char* FromPtr = (char*)From;
+  size_t FromLength = strlen(From);
+  char* ToPtr = To;
+  if (!ToPtr)
+  {
+    size_t NewLength = FromLength * 2 + 1; // some room for multi byte characters
+    if (NewLength > length)
+    {
+      char* NewResult = (char*)realloc(result, NewLength);
+      if (!NewResult) return From;
+      result = NewResult;
+      length = NewLength;
+    }
+    ToPtr = result;
+    ToLength = length;
+  }
+  else if (!ToLength)
+  {
+    return From;
+  }
+
+  char* Converted = ToPtr;
+  ToLength--; // room for the terminator
+  iconv(cd, NULL, NULL, NULL, NULL);
+  while (FromLength > 0)
+  {
+    if (iconv(cd, &FromPtr, &FromLength, &ToPtr, &ToLength) == (size_t)-1)
+    {
+      if ((errno == E2BIG) && !To)
+      {
+        // The result buffer is too small, grow it and carry on
+        size_t Used = ToPtr - result;
+        size_t NewLength = length * 2;
+        char* NewResult = (char*)realloc(result, NewLength);
+        if (!NewResult) break;
+        result = NewResult;
+        length = NewLength;
+        Converted = result;
+        ToPtr = result + Used;
+        ToLength = length - Used - 1;
+        continue;
+      }
+      if (errno == EILSEQ)
+      {
+        // Skip the offending character
+        if (!ToLength) break;
+        *ToPtr++ = '?';
+        ToLength--;
+        FromPtr++;
+        FromLength--;
+        continue;
+      }
+      break;
+    }
+  }
+  *ToPtr = 0;
+  return Converted;
+}
+
+// ---- Lists -------------------------------------------------------------------
+
+int cListObject::Index() const
+{
+  int i = -1;
+  for (const cListObject* p = this; p; p = p->prev) i++;
+  return i;
+}
+
+cListBase::cListBase(const char* NeedsLocking)
+: stateLock(NeedsLocking)
+{
+  objects = lastObject = NULL;
+  count = 0;
+}
+
+cListBase::~cListBase()
+{
+  Clear();
+}
+
+bool cListBase::Lock(cStateKey& StateKey, bool Write, int TimeoutMs) const
+{
+  return stateLock.Lock(StateKey, Write, TimeoutMs);
+}
+
+void cListBase::Add(cListObject* Object, cListObject* After)
+{
+  if (After && (After != lastObject))
+  {
+    Object->next = After->next;
+    Object->prev = After;
+    After->next->prev = Object;
+    After->next = Object;
+  }
+  else
+  {
+    Object->prev = lastObject;
+    Object->next = NULL;
+    if (lastObject) lastObject->next = Object;
+    else objects = Object;
+    lastObject = Object;
+  }
+  count++;
+}
+
+void cListBase::Del(cListObject* Object, bool DeleteObject)
+{
+  if (Object == objects) objects = Object->next;
+  if (Object == lastObject) lastObject = Object->prev;
+  if (Object->prev) Object->prev->next = Object->next;
+  if (Object->next) Object->next->prev = Object->prev;
+  Object->prev = Object->next = NULL;
+  if (DeleteObject) delete Object;
+  count--;
+}
+
+void cListBase::Clear()
+{
+  while (objects)
+  {
+    cListObject* object = objects->next;
+    delete objects;
+    objects = object;
+  }
+  objects = lastObject = NULL;
+  count = 0;
+}
+
+cListObject* cListBase::Get(int Index) const
+{
+  if (Index < 0) return NULL;
+  cListObject* object = objects;
+  while (object && (Index-- > 0)) object = object->next;
+  return object;
+}
+
+cStringList::~cStringList()
+{
+  for (size_t i = 0; i < strings.size(); i++) free(strings[i]);
+}
+
+// ---- i18n --------------------------------------------------------------------
+
+static const char* languageCodes[] = { "eng", "deu", "fra", "ita", "nld", "spa", "swe", "fin", NULL };
+
+const cStringList* I18nLanguages()
+{
+  static cStringList* languages = NULL;
+  if (!languages)
+  {
+    languages = new cStringList;
+    for (int i = 0; languageCodes[i]; i++) languages->Append(strdup(languageCodes[i]));
+  }
+  return languages;
+}
+
+const char* I18nLanguageCode(int Language)
+{
+  if ((Language < 0) || (Language >= I18nLanguages()->Size())) return NULL;
+  return languageCodes[Language];
+}
+
+// ---- Setup -------------------------------------------------------------------
+
+cSetup Setup;
+
+cSetup::cSetup()
+{
+  ResumeID = 0;
+  DisplaySubtitles = 0;
+  for (int i = 0; i <= I18N_MAX_LANGUAGES; i++)
+  {
+    AudioLanguages[i] = -1;
+    SubtitleLanguages[i] = -1;
+  }
+  AudioLanguages[0] = 1; // deu, then eng
+  AudioLanguages[1] = 0;
+}
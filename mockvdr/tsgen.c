@@ -0,0 +1,253 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tsgen.h"
+
+#define AUDIO_FRAME_BYTES 576 // one 192 kbit/s MPEG-1 layer II frame at 48 kHz
+
+cTsGenerator::cTsGenerator(int Vpid, int Apid, int Bitrate, int Fps)
+{
+  vpid = Vpid;
+  apid = Apid;
+  bitrate = Bitrate;
+  fps = (Fps > 0) ? Fps : 25;
+  videoFrameBytes = vpid ? (bitrate / 8 / fps) : 0;
+  if (vpid && (videoFrameBytes < 64)) videoFrameBytes = 64;
+  frameNumber = 0;
+  ccPat = ccPmt = ccVideo = ccAudio = 0;
+  pesBuffer = (unsigned char*)malloc(videoFrameBytes + AUDIO_FRAME_BYTES + 64);
+}
+
+cTsGenerator::~cTsGenerator()
+{
+  free(pesBuffer);
+}
+
+int cTsGenerator::MaxFrameSize() const
+{
+  // PAT, PMT, and each PES rounded up to whole packets with room for headers
+  int videoPackets = vpid ? (videoFrameBytes + 32) / (TS_SIZE - 4) + 2 : 0;
+  int audioPackets = (AUDIO_FRAME_BYTES + 32) / (TS_SIZE - 4) + 2;
+  return (2 + videoPackets + audioPackets) * TS_SIZE;
+}
+
+uint32_t cTsGenerator::crc32(const unsigned char* data, int length)
+{
+  // MPEG-2 CRC, polynomial 0x04C11DB7, no reflection
+  uint32_t crc = 0xFFFFFFFF;
+  for (int i = 0; i < length; i++)
+  {
+    crc ^= (uint32_t)data[i] << 24;
+    for (int b = 0; b < 8; b++) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+  }
+  return crc;
+}
+
+int cTsGenerator::putPsi(unsigned char* p, int pid, const unsigned char* section, int length, unsigned char* cc)
+{
+  p[0] = 0x47;
+  p[1] = 0x40 | ((pid >> 8) & 0x1F);
+  p[2] = pid & 0xFF;
+  p[3] = 0x10 | (*cc & 0x0F);
+  *cc = (*cc + 1) & 0x0F;
+  p[4] = 0; // pointer field
+  memcpy(p + 5, section, length);
+  memset(p + 5 + length, 0xFF, TS_SIZE - 5 - length);
+  return TS_SIZE;
+}
+
+int cTsGenerator::putPes(unsigned char* p, int pid, const unsigned char* pes, int length, unsigned char* cc)
+{
+  int written = 0;
+  bool first = true;
+  while (length > 0)
+  {
+    unsigned char* t = p + written;
+    t[0] = 0x47;
+    t[1] = (first ? 0x40 : 0x00) | ((pid >> 8) & 0x1F);
+    t[2] = pid & 0xFF;
+    int payload = TS_SIZE - 4;
+    if (length >= payload)
+    {
+      t[3] = 0x10 | (*cc & 0x0F);
+      memcpy(t + 4, pes, payload);
+    }
+    else
+    {
+      // Last packet, pad with an adaptation field
+      int stuffing = payload - length;
+      t[3] = 0x30 | (*cc & 0x0F);
+      t[4] = stuffing - 1;
+      if (stuffing > 1)
+      {
+        t[5] = 0x00;
+        memset(t + 6, 0xFF, stuffing - 2);
+      }
+      memcpy(t + 4 + stuffing, pes, length);
+      payload = length;
+    }
+    *cc = (*cc + 1) & 0x0F;
+    pes += payload;
+    length -= payload;
+    written += TS_SIZE;
+    first = false;
+  }
+  return written;
+}
+
+static int putPesHeader(unsigned char* p, unsigned char streamID, int payloadLength, uint64_t pts)
+{
+  p[0] = 0x00;
+  p[1] = 0x00;
+  p[2] = 0x01;
+  p[3] = streamID;
+  int pesLength = payloadLength ? payloadLength + 8 : 0; // 0 means unbounded, video only
+  if (pesLength > 0xFFFF) pesLength = 0;
+  p[4] = pesLength >> 8;
+  p[5] = pesLength & 0xFF;
+  p[6] = 0x80;
+  p[7] = 0x80; // PTS only
+  p[8] = 5;
+  p[9] = 0x21 | ((pts >> 29) & 0x0E);
+  p[10] = (pts >> 22) & 0xFF;
+  p[11] = 0x01 | ((pts >> 14) & 0xFE);
+  p[12] = (pts >> 7) & 0xFF;
+  p[13] = 0x01 | ((pts << 1) & 0xFE);
+  return 14;
+}
+
+int cTsGenerator::NextFrame(unsigned char* Buffer, int Size, bool* Independent)
+{
+  if (Size < MaxFrameSize()) return 0;
+
+  bool iFrame = (frameNumber % GOP_SIZE) == 0;
+  uint64_t pts = (90000 + frameNumber * 90000 / fps) & 0x1FFFFFFFFULL;
+  int written = 0;
+
+  if (iFrame)
+  {
+    // PAT: program 1 on PMT_PID
+    unsigned char pat[16];
+    int n = 0;
+    pat[n++] = 0x00;
+    pat[n++] = 0xB0;
+    pat[n++] = 13;
+    pat[n++] = 0x00; pat[n++] = 0x01; // transport stream id
+    pat[n++] = 0xC1;
+    pat[n++] = 0x00;
+    pat[n++] = 0x00;
+    pat[n++] = 0x00; pat[n++] = 0x01; // program number
+    pat[n++] = 0xE0 | (PMT_PID >> 8);
+    pat[n++] = PMT_PID & 0xFF;
+    uint32_t crc = crc32(pat, n);
+    pat[n++] = crc >> 24; pat[n++] = crc >> 16; pat[n++] = crc >> 8; pat[n++] = crc;
+    written += putPsi(Buffer + written, 0, pat, n, &ccPat);
+
+    // PMT: MPEG-2 video and MPEG audio
+    unsigned char pmt[32];
+    n = 0;
+    int pcrPid = vpid ? vpid : apid;
+    int sectionLength = 9 + (vpid ? 5 : 0) + 5 + 4;
+    pmt[n++] = 0x02;
+    pmt[n++] = 0xB0;
+    pmt[n++] = sectionLength;
+    pmt[n++] = 0x00; pmt[n++] = 0x01; // program number
+    pmt[n++] = 0xC1;
+    pmt[n++] = 0x00;
+    pmt[n++] = 0x00;
+    pmt[n++] = 0xE0 | ((pcrPid >> 8) & 0x1F);
+    pmt[n++] = pcrPid & 0xFF;
+    pmt[n++] = 0xF0; pmt[n++] = 0x00;
+    if (vpid)
+    {
+      pmt[n++] = 0x02;
+      pmt[n++] = 0xE0 | ((vpid >> 8) & 0x1F);
+      pmt[n++] = vpid & 0xFF;
+      pmt[n++] = 0xF0; pmt[n++] = 0x00;
+    }
+    pmt[n++] = 0x04;
+    pmt[n++] = 0xE0 | ((apid >> 8) & 0x1F);
+    pmt[n++] = apid & 0xFF;
+    pmt[n++] = 0xF0; pmt[n++] = 0x00;
+    crc = crc32(pmt, n);
+    pmt[n++] = crc >> 24; pmt[n++] = crc >> 16; pmt[n++] = crc >> 8; pmt[n++] = crc;
+    written += putPsi(Buffer + written, PMT_PID, pmt, n, &ccPmt);
+  }
+
+  if (vpid)
+  {
+    unsigned char* p = pesBuffer;
+    int h = putPesHeader(p, 0xE0, 0, pts);
+    unsigned char* es = p + h;
+    int e = 0;
+    if (iFrame)
+    {
+      // Sequence header, 720x576 16:9 25 fps
+      int br = bitrate / 400;
+      if (br > 0x3FFFF) br = 0x3FFFF;
+      int vbv = 112;
+      es[e++] = 0x00; es[e++] = 0x00; es[e++] = 0x01; es[e++] = 0xB3;
+      es[e++] = 0x2D; es[e++] = 0x02; es[e++] = 0x40;
+      es[e++] = 0x33;
+      es[e++] = (br >> 10) & 0xFF;
+      es[e++] = (br >> 2) & 0xFF;
+      es[e++] = ((br & 0x03) << 6) | 0x20 | ((vbv >> 5) & 0x1F);
+      es[e++] = (vbv & 0x1F) << 3;
+      // GOP header, closed
+      int seconds = (int)(frameNumber / fps);
+      es[e++] = 0x00; es[e++] = 0x00; es[e++] = 0x01; es[e++] = 0xB8;
+      uint32_t timeCode = (((seconds / 3600) % 24) << 19) | (((seconds / 60) % 60) << 13) | (1 << 12) | ((seconds % 60) << 6);
+      uint32_t gop = (timeCode << 7) | 0x40;
+      es[e++] = gop >> 24; es[e++] = gop >> 16; es[e++] = gop >> 8; es[e++] = gop;
+    }
+    // Picture header: temporal reference and coding type (1 = I, 2 = P)
+    int temporalReference = frameNumber % GOP_SIZE;
+    int codingType = iFrame ? 1 : 2;
+    es[e++] = 0x00; es[e++] = 0x00; es[e++] = 0x01; es[e++] = 0x00;
+    es[e++] = temporalReference >> 2;
+    es[e++] = ((temporalReference & 0x03) << 6) | (codingType << 3);
+    es[e++] = 0xFF;
+    es[e++] = 0xF8;
+    int fill = videoFrameBytes - h - e;
+    if (fill > 0)
+    {
+      memset(es + e, 0, fill);
+      e += fill;
+    }
+    written += putPes(Buffer + written, vpid, p, h + e, &ccVideo);
+  }
+
+  // One MPEG-1 layer II frame header, 192 kbit/s, 48 kHz, stereo
+  unsigned char* p = pesBuffer;
+  int h = putPesHeader(p, 0xC0, AUDIO_FRAME_BYTES, pts);
+  p[h + 0] = 0xFF;
+  p[h + 1] = 0xFD;
+  p[h + 2] = 0xA4;
+  p[h + 3] = 0x04;
+  memset(p + h + 4, 0x55, AUDIO_FRAME_BYTES - 4);
+  written += putPes(Buffer + written, apid, p, h + AUDIO_FRAME_BYTES, &ccAudio);
+
+  if (Independent) *Independent = iFrame;
+  frameNumber++;
+  return written;
+}
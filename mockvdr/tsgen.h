@@ -0,0 +1,70 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Synthetic MPEG-2 transport stream for the mock devices and mkrecording.
+  Each frame is a video PES (sequence and GOP headers on I frames, then a
+  picture header padded to the bitrate) plus one MPEG audio PES, with a
+  PAT and PMT in front of every I frame. Good enough for clients to sync
+  on and for index files to point at; it does not decode to a picture.
+*/
+
+#ifndef TSGEN_H
+#define TSGEN_H
+
+#include <stdint.h>
+
+#define TS_SIZE 188
+
+class cTsGenerator
+{
+  public:
+    // Vpid 0 gives an audio only (radio) stream. Bitrate in bits per second.
+    cTsGenerator(int Vpid, int Apid, int Bitrate, int Fps = 25);
+    ~cTsGenerator();
+
+    // Largest frame NextFrame() will produce
+    int MaxFrameSize() const;
+
+    // Writes the next frame to Buffer, returns its length (a multiple of
+    // TS_SIZE) or 0 if Size is too small
+    int NextFrame(unsigned char* Buffer, int Size, bool* Independent = 0);
+
+    int Fps() const { return fps; }
+
+    const static int GOP_SIZE = 12;
+    const static int PMT_PID = 0x20;
+
+  private:
+    int putPsi(unsigned char* p, int pid, const unsigned char* section, int length, unsigned char* cc);
+    int putPes(unsigned char* p, int pid, const unsigned char* pes, int length, unsigned char* cc);
+    static uint32_t crc32(const unsigned char* data, int length);
+
+    int vpid;
+    int apid;
+    int bitrate;
+    int fps;
+    int videoFrameBytes;
+    uint64_t frameNumber;
+    unsigned char ccPat, ccPmt, ccVideo, ccAudio;
+    unsigned char* pesBuffer;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: channels, filled with synthetic ones by cChannels::CreateSynthetic()
+
+#ifndef MOCKVDR_CHANNELS_H
+#define MOCKVDR_CHANNELS_H
+
+#include "config.h"
+#include "tools.h"
+
+#define MAXAPIDS 32
+#define MAXDPIDS 16
+#define MAXSPIDS 32
+#define MAXCAIDS 12
+#define MAXLANGCODE2 8
+
+struct tChannelID
+{
+  public:
+    tChannelID() : source(0), nid(0), tid(0), sid(0), rid(0) {}
+    tChannelID(int Source, int Nid, int Tid, int Sid, int Rid = 0) : source(Source), nid(Nid), tid(Tid), sid(Sid), rid(Rid) {}
+    bool operator==(const tChannelID& Arg) const { return (sid == Arg.sid) && (tid == Arg.tid) && (nid == Arg.nid) && (source == Arg.source) && (rid == Arg.rid); }
+    bool Valid() const { return (nid || tid) && sid; }
+    static tChannelID FromString(const char* s);
+    cString ToString() const;
+    static const tChannelID InvalidID;
+
+    int source;
+    int nid;
+    int tid;
+    int sid;
+    int rid;
+};
+
+class cChannel : public cListObject
+{
+  friend class cChannels;
+  public:
+    cChannel();
+    virtual ~cChannel();
+
+    const char* Name() const { return name; }
+    int Number() const { return number; }
+    bool GroupSep() const { return groupSep; }
+    int Vpid() const { return vpid; }
+    int Ppid() const { return ppid; }
+    int Vtype() const { return vtype; }
+    int Tpid() const { return tpid; }
+    const int* Apids() const { return apids; }
+    const int* Dpids() const { return dpids; }
+    const int* Spids() const { return spids; }
+    int Apid(int i) const { return (0 <= i && i < MAXAPIDS) ? apids[i] : 0; }
+    int Dpid(int i) const { return (0 <= i && i < MAXDPIDS) ? dpids[i] : 0; }
+    int Spid(int i) const { return (0 <= i && i < MAXSPIDS) ? spids[i] : 0; }
+    const char* Alang(int i) const { return (0 <= i && i < MAXAPIDS) ? alangs[i] : ""; }
+    const char* Dlang(int i) const { return (0 <= i && i < MAXDPIDS) ? dlangs[i] : ""; }
+    const char* Slang(int i) const { return (0 <= i && i < MAXSPIDS) ? slangs[i] : ""; }
+    int Atype(int i) const { return (0 <= i && i < MAXAPIDS) ? atypes[i] : 0; }
+    int Dtype(int i) const { return (0 <= i && i < MAXDPIDS) ? dtypes[i] : 0; }
+    uchar SubtitlingType(int i) const { return (0 <= i && i < MAXSPIDS) ? subtitlingTypes[i] : uchar(0); }
+    uint16_t CompositionPageId(int i) const { return (0 <= i && i < MAXSPIDS) ? compositionPageIds[i] : uint16_t(0); }
+    uint16_t AncillaryPageId(int i) const { return (0 <= i && i < MAXSPIDS) ? ancillaryPageIds[i] : uint16_t(0); }
+    int Ca(int Index = 0) const { return (0 <= Index && Index < MAXCAIDS) ? caids[Index] : 0; }
+    tChannelID GetChannelID() const { return tChannelID(source, nid, tid, sid); }
+
+  private:
+    char* name;
+    int number;
+    bool groupSep;
+    int source, nid, tid, sid;
+    int vpid, ppid, vtype, tpid;
+    int apids[MAXAPIDS + 1];
+    int atypes[MAXAPIDS + 1];
+    char alangs[MAXAPIDS][MAXLANGCODE2];
+    int dpids[MAXDPIDS + 1];
+    int dtypes[MAXDPIDS + 1];
+    char dlangs[MAXDPIDS][MAXLANGCODE2];
+    int spids[MAXSPIDS + 1];
+    char slangs[MAXSPIDS][MAXLANGCODE2];
+    uchar subtitlingTypes[MAXSPIDS];
+    uint16_t compositionPageIds[MAXSPIDS];
+    uint16_t ancillaryPageIds[MAXSPIDS];
+    int caids[MAXCAIDS + 1];
+};
+
+class cChannels : public cList<cChannel>
+{
+  public:
+    cChannels();
+    const cChannel* GetByNumber(int Number, int SkipGap = 0) const;
+    const cChannel* GetByChannelID(tChannelID ChannelID, bool TryWithoutRid = false, bool TryWithoutPolarization = false) const;
+    int MaxNumber() const { return maxNumber; }
+
+    static const cChannels* GetChannelsRead(cStateKey& StateKey, int TimeoutMs = 0);
+    static cChannels* GetChannelsWrite(cStateKey& StateKey, int TimeoutMs = 0);
+
+    // Mock: numChannels TV channels, every fifth one encrypted, then a few radio channels
+    void CreateSynthetic(int numChannels);
+
+  private:
+    int maxNumber;
+};
+
+#define LOCK_CHANNELS_READ  cStateKey _StateKeyChannels; const cChannels* Channels = cChannels::GetChannelsRead(_StateKeyChannels)
+#define LOCK_CHANNELS_WRITE cStateKey _StateKeyChannels; cChannels* Channels = cChannels::GetChannelsWrite(_StateKeyChannels)
+
+#endif
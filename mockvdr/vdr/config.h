@@ -0,0 +1,49 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: version and the Setup fields the plugin reads
+
+#ifndef MOCKVDR_CONFIG_H
+#define MOCKVDR_CONFIG_H
+
+#include "tools.h"
+
+// The mock implements the VDR 2.4 API, the plugin's newest code paths
+#define VDRVERSION  "2.4.0-mock"
+#define VDRVERSNUM  20400
+#define APIVERSION  "2.4.0"
+#define APIVERSNUM  20400
+
+#define MAXLANGCODE1 4
+#define I18N_MAX_LANGUAGES 32
+
+class cSetup
+{
+  public:
+    cSetup();
+    int ResumeID;
+    int DisplaySubtitles;
+    int AudioLanguages[I18N_MAX_LANGUAGES + 1];
+    int SubtitleLanguages[I18N_MAX_LANGUAGES + 1];
+};
+
+extern cSetup Setup;
+
+#endif
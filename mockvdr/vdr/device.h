@@ -0,0 +1,77 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Mock VDR: tuner devices. A fixed number of devices, each of which can
+  be tuned to one channel at a time and then feeds synthetic TS for that
+  channel to all attached receivers, one packet per Receive() call like
+  the real thing, at the bitrate given to Initialize().
+*/
+
+#ifndef MOCKVDR_DEVICE_H
+#define MOCKVDR_DEVICE_H
+
+#include "channels.h"
+#include "thread.h"
+#include "tools.h"
+
+#define MAXDEVICES 16
+#define MAXRECEIVERS 16
+
+class cReceiver;
+class cTsGenerator;
+
+class cDevice
+{
+  public:
+    static int NumDevices() { return numDevices; }
+    static cDevice* GetDevice(int Index);
+    static cDevice* GetDevice(const cChannel* Channel, int Priority, bool LiveView, bool Query = false);
+
+    int DeviceNumber() const { return deviceNumber; }
+    bool SwitchChannel(const cChannel* Channel, bool LiveView);
+    bool AttachReceiver(cReceiver* Receiver);
+    void Detach(cReceiver* Receiver);
+    bool Receiving() const;
+
+    // Mock: create the devices, bitrate in bits per second
+    static void Initialize(int NumDevices, int Bitrate);
+    static void Shutdown();
+
+  private:
+    cDevice(int DeviceNumber);
+    ~cDevice();
+    static void* threadEntry(void* arg);
+    void Action();
+
+    static int numDevices;
+    static cDevice* devices[MAXDEVICES];
+    static int bitrate;
+
+    int deviceNumber;
+    mutable cMutex mutex;
+    const cChannel* channel;
+    cTsGenerator* generator;
+    cReceiver* receivers[MAXRECEIVERS];
+    bool running;
+    pthread_t thread;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: EPG, with synthetic schedules for every channel
+
+#ifndef MOCKVDR_EPG_H
+#define MOCKVDR_EPG_H
+
+#include "channels.h"
+#include "tools.h"
+
+struct tComponent
+{
+  uchar stream;
+  uchar type;
+  char language[MAXLANGCODE2];
+  char* description;
+};
+
+class cComponents
+{
+  public:
+    cComponents();
+    ~cComponents();
+    int NumComponents() const { return numComponents; }
+    void SetComponent(int Index, uchar Stream, uchar Type, const char* Language, const char* Description);
+    tComponent* Component(int Index) const { return (Index < numComponents) ? &components[Index] : NULL; }
+
+  private:
+    tComponent* components;
+    int numComponents;
+};
+
+class cSchedule;
+
+class cEvent : public cListObject
+{
+  friend class cSchedule;
+  public:
+    cEvent(uint32_t EventID);
+    virtual ~cEvent();
+
+    const cSchedule* Schedule() const { return schedule; }
+    uint32_t EventID() const { return eventID; }
+    const char* Title() const { return title; }
+    const char* ShortText() const { return shortText; }
+    const char* Description() const { return description; }
+    const cComponents* Components() const { return components; }
+    time_t StartTime() const { return startTime; }
+    time_t EndTime() const { return startTime + duration; }
+    int Duration() const { return duration; }
+    time_t Vps() const { return 0; }
+    time_t Seen() const { return seen; }
+
+    void SetTitle(const char* Title);
+    void SetShortText(const char* ShortText);
+    void SetDescription(const char* Description);
+    void SetComponents(cComponents* Components);
+    void SetStartTime(time_t StartTime) { startTime = StartTime; }
+    void SetDuration(int Duration) { duration = Duration; }
+
+  private:
+    cSchedule* schedule;
+    uint32_t eventID;
+    char* title;
+    char* shortText;
+    char* description;
+    cComponents* components;
+    time_t startTime;
+    int duration;
+    time_t seen;
+};
+
+class cSchedule : public cListObject
+{
+  public:
+    cSchedule(tChannelID ChannelID);
+    tChannelID ChannelID() const { return channelID; }
+    bool Modified(int& State) const { bool Result = State != modified; State = modified; return Result; }
+    void SetModified() { modified++; }
+    const cList<cEvent>* Events() const { return &events; }
+    const cEvent* GetPresentEvent() const;
+    const cEvent* GetFollowingEvent() const;
+    const cEvent* GetEvent(uint32_t EventID, time_t StartTime = 0) const;
+    const cEvent* GetEventAround(time_t Time) const;
+    cEvent* AddEvent(cEvent* Event);
+
+  private:
+    tChannelID channelID;
+    cList<cEvent> events;
+    int modified;
+};
+
+class cSchedules : public cList<cSchedule>
+{
+  public:
+    cSchedules();
+    const cSchedule* GetSchedule(tChannelID ChannelID) const;
+    const cSchedule* GetSchedule(const cChannel* Channel, bool AddIfMissing = false) const;
+    cSchedule* AddSchedule(tChannelID ChannelID);
+
+    static const cSchedules* GetSchedulesRead(cStateKey& StateKey, int TimeoutMs = 0);
+    static cSchedules* GetSchedulesWrite(cStateKey& StateKey, int TimeoutMs = 0);
+
+    // Mock: eventsPerChannel events per channel starting a few hours ago
+    void CreateSynthetic(const cChannels* Channels, int eventsPerChannel);
+};
+
+#define LOCK_SCHEDULES_READ  cStateKey _StateKeySchedules; const cSchedules* Schedules = cSchedules::GetSchedulesRead(_StateKeySchedules)
+#define LOCK_SCHEDULES_WRITE cStateKey _StateKeySchedules; cSchedules* Schedules = cSchedules::GetSchedulesWrite(_StateKeySchedules)
+
+#endif
@@ -0,0 +1,34 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: a fixed list of OSD languages and no translations
+
+#ifndef MOCKVDR_I18N_H
+#define MOCKVDR_I18N_H
+
+class cStringList;
+
+const cStringList* I18nLanguages();
+const char* I18nLanguageCode(int Language);
+
+inline const char* tr(const char* s) { return s; }
+#define trNOOP(s) (s)
+
+#endif
@@ -0,0 +1,41 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: record controls. Nothing records, so there never is one.
+
+#ifndef MOCKVDR_MENU_H
+#define MOCKVDR_MENU_H
+
+#include "timers.h"
+#include "tools.h"
+
+class cRecordControl
+{
+  public:
+    cTimer* Timer() { return NULL; }
+};
+
+class cRecordControls
+{
+  public:
+    static cRecordControl* GetRecordControl(const char* FileName) { return NULL; }
+};
+
+#endif
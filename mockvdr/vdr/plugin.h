@@ -0,0 +1,84 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Mock VDR: the plugin interface. The mock main creates the one plugin it
+  is linked with through VDRPluginCreator() and drives it the way VDR's
+  plugin manager does.
+*/
+
+#ifndef MOCKVDR_PLUGIN_H
+#define MOCKVDR_PLUGIN_H
+
+#include "config.h"
+#include "i18n.h"
+#include "tools.h"
+
+class cOsdObject {};
+class cMenuSetupPage {};
+
+class cPlugin
+{
+  public:
+    cPlugin();
+    virtual ~cPlugin();
+
+    const char* Name() { return name; }
+    virtual const char* Version() = 0;
+    virtual const char* Description() = 0;
+    virtual const char* CommandLineHelp() { return NULL; }
+    virtual bool ProcessArgs(int argc, char* argv[]) { return true; }
+    virtual bool Initialize() { return true; }
+    virtual bool Start() { return true; }
+    virtual void Stop() {}
+    virtual void Housekeeping() {}
+    virtual void MainThreadHook() {}
+    virtual cString Active() { return NULL; }
+    virtual time_t WakeupTime() { return 0; }
+    virtual const char* MainMenuEntry() { return NULL; }
+    virtual cOsdObject* MainMenuAction() { return NULL; }
+    virtual cMenuSetupPage* SetupMenu() { return NULL; }
+    virtual bool SetupParse(const char* Name, const char* Value) { return false; }
+    virtual bool Service(const char* Id, void* Data = NULL) { return false; }
+    virtual const char** SVDRPHelpPages() { return NULL; }
+    virtual cString SVDRPCommand(const char* Command, const char* Option, int& ReplyCode) { return NULL; }
+
+    void SetName(const char* Name) { name = Name; }
+    static void SetConfigDirectory(const char* Dir);
+    static void SetResourceDirectory(const char* Dir);
+    static void SetCacheDirectory(const char* Dir);
+    static const char* ConfigDirectory(const char* PluginName = NULL);
+    static const char* ResourceDirectory(const char* PluginName = NULL);
+    static const char* CacheDirectory(const char* PluginName = NULL);
+
+  private:
+    const char* name;
+};
+
+// No other plugins are loaded
+class cPluginManager
+{
+  public:
+    static cPlugin* GetPlugin(const char* Name) { return NULL; }
+};
+
+#define VDRPLUGINCREATOR(PluginClass) extern "C" void* VDRPluginCreator(void) { return new PluginClass; }
+
+#endif
@@ -0,0 +1,57 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: the receiver interface
+
+#ifndef MOCKVDR_RECEIVER_H
+#define MOCKVDR_RECEIVER_H
+
+#include "channels.h"
+#include "device.h"
+#include "tools.h"
+
+#define MINPRIORITY (-99)
+#define MAXPRIORITY 99
+
+class cReceiver
+{
+  friend class cDevice;
+  public:
+    cReceiver(const cChannel* Channel = NULL, int Priority = MINPRIORITY);
+    virtual ~cReceiver();
+    bool AddPid(int Pid);
+    bool WantsPid(int Pid);
+    tChannelID ChannelID() { return channelID; }
+    bool IsAttached() { return device != NULL; }
+    void Detach();
+
+  protected:
+    virtual void Activate(bool On) {}
+    virtual void Receive(const uchar* Data, int Length) = 0;
+
+  private:
+    cDevice* device;
+    tChannelID channelID;
+    int priority;
+    int pids[MAXRECEIVERS * 4];
+    int numPids;
+};
+
+#endif
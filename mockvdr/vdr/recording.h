@@ -0,0 +1,181 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Mock VDR: recordings. Reads TS recordings from the video directory in
+  VDR's on disk layout (Name/YYYY-MM-DD.HH.MM.CH-RI.rec/ with 00001.ts,
+  index, info, marks and resume), such as mockvdr/mkrecording writes.
+  PES recordings are not supported.
+*/
+
+#ifndef MOCKVDR_RECORDING_H
+#define MOCKVDR_RECORDING_H
+
+#include "config.h"
+#include "epg.h"
+#include "tools.h"
+
+#define DEFAULTFRAMESPERSECOND 25.0
+
+class cRecordingInfo
+{
+  friend class cRecording;
+  public:
+    cRecordingInfo(const char* FileName);
+    ~cRecordingInfo();
+
+    tChannelID ChannelID() const { return channelID; }
+    const char* ChannelName() const { return channelName; }
+    const cEvent* GetEvent() const { return event; }
+    const char* Title() const { return event->Title(); }
+    const char* ShortText() const { return event->ShortText(); }
+    const char* Description() const { return event->Description(); }
+    const cComponents* Components() const { return event->Components(); }
+    const char* Aux() const { return aux; }
+    double FramesPerSecond() const { return framesPerSecond; }
+    bool Read();
+
+  private:
+    tChannelID channelID;
+    char* channelName;
+    cEvent* event;
+    char* aux;
+    double framesPerSecond;
+    int priority;
+    int lifetime;
+    char* fileName;
+};
+
+class cRecording : public cListObject
+{
+  public:
+    cRecording(const char* FileName);
+    virtual ~cRecording();
+
+    time_t Start() const { return start; }
+    int Priority() const { return priority; }
+    int Lifetime() const { return lifetime; }
+    const char* Name() const { return name; }
+    const char* FileName() const { return fileName; }
+    const cRecordingInfo* Info() const { return info; }
+    double FramesPerSecond() const { return info->FramesPerSecond(); }
+    int LengthInSeconds() const;
+    int FileSizeMB() const;
+    bool IsNew() const { return isNew; }
+    bool IsPesRecording() const { return false; }
+    int IsInUse() const { return 0; }
+    bool Delete();
+    bool ChangeName(const char* NewName);
+
+  private:
+    char* fileName;
+    char* name;
+    time_t start;
+    int priority;
+    int lifetime;
+    bool isNew;
+    cRecordingInfo* info;
+};
+
+class cRecordings : public cList<cRecording>
+{
+  public:
+    cRecordings(bool Deleted = false);
+    const cRecording* GetByName(const char* FileName) const;
+    cRecording* GetByName(const char* FileName);
+    void DelByName(const char* FileName);
+    void Update(bool Wait = false);
+
+    static const cRecordings* GetRecordingsRead(cStateKey& StateKey, int TimeoutMs = 0);
+    static cRecordings* GetRecordingsWrite(cStateKey& StateKey, int TimeoutMs = 0);
+
+  private:
+    void ScanVideoDir(const char* DirName);
+};
+
+#define LOCK_RECORDINGS_READ  cStateKey _StateKeyRecordings; const cRecordings* Recordings = cRecordings::GetRecordingsRead(_StateKeyRecordings)
+#define LOCK_RECORDINGS_WRITE cStateKey _StateKeyRecordings; cRecordings* Recordings = cRecordings::GetRecordingsWrite(_StateKeyRecordings)
+
+class cResumeFile
+{
+  public:
+    cResumeFile(const char* FileName, bool IsPesRecording = false);
+    ~cResumeFile();
+    int Read();
+    bool Save(int Index);
+    void Delete();
+
+  private:
+    char* fileName;
+};
+
+class cMark : public cListObject
+{
+  public:
+    cMark(int Position = 0, const char* Comment = NULL, double FramesPerSecond = DEFAULTFRAMESPERSECOND);
+    virtual ~cMark();
+    int Position() const { return position; }
+    const char* Comment() const { return comment; }
+
+  private:
+    int position;
+    char* comment;
+};
+
+class cMarks : public cList<cMark>
+{
+  public:
+    bool Load(const char* RecordingFileName, double FramesPerSecond = DEFAULTFRAMESPERSECOND, bool IsPesRecording = false);
+};
+
+/*
+  VDR's TS index: one 8 byte entry per frame with the file offset, the
+  file number and whether the frame is independently decodable.
+*/
+
+struct tIndexTs
+{
+  uint64_t offset:40;
+  int reserved:7;
+  int independent:1;
+  uint16_t number:16;
+};
+
+class cIndexFile
+{
+  public:
+    cIndexFile(const char* FileName, bool Record, bool IsPesRecording = false, bool PauseLive = false, bool Update = false);
+    ~cIndexFile();
+    bool Ok() { return index != NULL; }
+    bool Get(int Index, uint16_t* FileNumber, off_t* FileOffset, bool* Independent = NULL, int* Length = NULL);
+    int GetNextIFrame(int Index, bool Forward, uint16_t* FileNumber = NULL, off_t* FileOffset = NULL, int* Length = NULL);
+    int Get(uint16_t FileNumber, off_t FileOffset);
+    int Last() { return last; }
+    static int GetLength(const char* FileName, bool IsPesRecording = false);
+
+  private:
+    tIndexTs* index;
+    int last;
+    char* fileName;
+};
+
+char* ExchangeChars(char* s, bool ToFileSystem);
+
+#endif
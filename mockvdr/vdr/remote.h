@@ -0,0 +1,39 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: key presses, only logged
+
+#ifndef MOCKVDR_REMOTE_H
+#define MOCKVDR_REMOTE_H
+
+#include "tools.h"
+
+enum eKeys { kUp, kDown, kMenu, kOk, kBack, kLeft, kRight, kRed, kGreen, kYellow, kBlue,
+             k0, k1, k2, k3, k4, k5, k6, k7, k8, k9, kInfo, kPlay, kPause, kStop, kRecord,
+             kFastFwd, kFastRew, kNext, kPrev, kPower, kChanUp, kChanDn, kChanPrev,
+             kVolUp, kVolDn, kMute, kNone };
+
+class cRemote
+{
+  public:
+    static bool Put(eKeys Key, bool AtFront = false);
+};
+
+#endif
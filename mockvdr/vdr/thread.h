@@ -0,0 +1,126 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: the subset of VDR's thread.h the plugin uses
+
+#ifndef MOCKVDR_THREAD_H
+#define MOCKVDR_THREAD_H
+
+#include <pthread.h>
+#include <sys/types.h>
+
+class cMutex
+{
+  public:
+    cMutex();
+    ~cMutex();
+    void Lock();
+    void Unlock();
+
+  private:
+    pthread_mutex_t mutex;
+};
+
+class cMutexLock
+{
+  public:
+    cMutexLock(cMutex* Mutex = NULL);
+    ~cMutexLock();
+
+  private:
+    cMutex* mutex;
+};
+
+class cCondWait
+{
+  public:
+    cCondWait();
+    ~cCondWait();
+    static void SleepMs(int TimeoutMs);
+    bool Wait(int TimeoutMs = 0);
+    void Signal();
+
+  private:
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool signaled;
+};
+
+class cRwLock
+{
+  public:
+    cRwLock();
+    ~cRwLock();
+    bool Lock(bool Write, int TimeoutMs = 0);
+    void Unlock();
+
+  private:
+    pthread_rwlock_t rwlock;
+};
+
+class cThreadLock
+{
+  public:
+    cThreadLock(void* Thread = NULL) {}
+};
+
+class cStateKey;
+
+/*
+  VDR 2.3+ list locking. Lists carry a state counter that writers bump,
+  readers and writers lock through a cStateKey which unlocks again when it
+  goes out of scope.
+*/
+
+class cStateLock
+{
+  friend class cStateKey;
+  public:
+    cStateLock(const char* Name = NULL);
+    bool Lock(cStateKey& StateKey, bool Write = false, int TimeoutMs = 0);
+    void IncState() { __sync_fetch_and_add(&state, 1); }
+    int State() const { return state; }
+
+  private:
+    void Unlock(cStateKey& StateKey, bool IncState = true);
+
+    const char* name;
+    cRwLock rwLock;
+    int state;
+};
+
+class cStateKey
+{
+  friend class cStateLock;
+  public:
+    cStateKey(bool IgnoreFirst = false);
+    ~cStateKey();
+    void Reset() { state = -1; }
+    void Remove(bool IncState = true);
+    bool StateChanged();
+
+  private:
+    cStateLock* stateLock;
+    bool write;
+    int state;
+    bool timedOut;
+};
+
+#endif
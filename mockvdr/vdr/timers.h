@@ -0,0 +1,82 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: timers, kept in memory only. Nothing ever records.
+
+#ifndef MOCKVDR_TIMERS_H
+#define MOCKVDR_TIMERS_H
+
+#include "channels.h"
+#include "config.h"
+#include "tools.h"
+
+enum eTimerFlags { tfNone = 0x0000, tfActive = 0x0001, tfInstant = 0x0002, tfVps = 0x0004, tfRecording = 0x0008, tfAll = 0xFFFF };
+
+class cTimer : public cListObject
+{
+  public:
+    cTimer();
+    virtual ~cTimer();
+
+    bool Parse(const char* s);
+    bool Recording() const { return HasFlags(tfRecording); }
+    bool Pending() const { return false; }
+    bool HasFlags(unsigned int Flags) const { return (flags & Flags) == Flags; }
+    void SetFlags(unsigned int Flags) { flags |= Flags; }
+    void ClrFlags(unsigned int Flags) { flags &= ~Flags; }
+    const cChannel* Channel() const { return channel; }
+    time_t Day() const { return day; }
+    int WeekDays() const { return weekdays; }
+    int Start() const { return start; }
+    int Stop() const { return stop; }
+    int StartTime() const { return start; }
+    int StopTime() const { return stop; }
+    int Priority() const { return priority; }
+    int Lifetime() const { return lifetime; }
+    const char* File() const { return file; }
+
+  private:
+    unsigned int flags;
+    const cChannel* channel;
+    time_t day;
+    int weekdays;
+    int start;
+    int stop;
+    int priority;
+    int lifetime;
+    char* file;
+};
+
+class cTimers : public cList<cTimer>
+{
+  public:
+    cTimers();
+    const cTimer* GetTimer(const cTimer* Timer) const;
+    cTimer* GetTimer(const cTimer* Timer);
+    bool Save() { return true; }
+
+    static const cTimers* GetTimersRead(cStateKey& StateKey, int TimeoutMs = 0);
+    static cTimers* GetTimersWrite(cStateKey& StateKey, int TimeoutMs = 0);
+};
+
+#define LOCK_TIMERS_READ  cStateKey _StateKeyTimers; const cTimers* Timers = cTimers::GetTimersRead(_StateKeyTimers)
+#define LOCK_TIMERS_WRITE cStateKey _StateKeyTimers; cTimers* Timers = cTimers::GetTimersWrite(_StateKeyTimers)
+
+#endif
@@ -0,0 +1,152 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Mock VDR: the subset of VDR's tools.h the plugin uses
+
+#ifndef MOCKVDR_TOOLS_H
+#define MOCKVDR_TOOLS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <iconv.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "thread.h"
+#include "i18n.h"
+
+typedef unsigned char uchar;
+
+extern int SysLogLevel; // 0 = none, 1 = errors, 2 = info, 3 = debug
+
+#define esyslog(a...) void( (SysLogLevel > 0) ? fprintf(stderr, a), fputc('\n', stderr) : 0 )
+#define isyslog(a...) void( (SysLogLevel > 1) ? fprintf(stderr, a), fputc('\n', stderr) : 0 )
+#define dsyslog(a...) void( (SysLogLevel > 2) ? fprintf(stderr, a), fputc('\n', stderr) : 0 )
+
+inline bool isempty(const char* s) { return !s || !*s; }
+
+class cString
+{
+  public:
+    cString(const char* S = NULL, bool TakePointer = false);
+    cString(const cString& String);
+    ~cString();
+    operator const void* () const { return s; }
+    operator const char* () const { return s; }
+    const char* operator*() const { return s; }
+    cString& operator=(const cString& String);
+    cString& operator=(const char* String);
+    static cString sprintf(const char* fmt, ...) __attribute__ ((format (printf, 1, 2)));
+
+  private:
+    char* s;
+};
+
+class cCharSetConv
+{
+  public:
+    cCharSetConv(const char* FromCode = NULL, const char* ToCode = NULL);
+    ~cCharSetConv();
+    const char* Convert(const char* From, char* To = NULL, size_t ToLength = 0);
+    static const char* SystemCharacterTable() { return systemCharacterTable; }
+    static void SetSystemCharacterTable(const char* CharacterTable);
+
+  private:
+    iconv_t cd;
+    char* result;
+    size_t length;
+    static char* systemCharacterTable;
+};
+
+class cListObject
+{
+  friend class cListBase;
+  public:
+    cListObject() : prev(NULL), next(NULL) {}
+    virtual ~cListObject() {}
+    virtual int Compare(const cListObject& ListObject) const { return 0; }
+    cListObject* Prev() const { return prev; }
+    cListObject* Next() const { return next; }
+    int Index() const;
+
+  private:
+    cListObject* prev;
+    cListObject* next;
+};
+
+class cListBase
+{
+  public:
+    cListBase(const char* NeedsLocking = NULL);
+    virtual ~cListBase();
+    bool Lock(cStateKey& StateKey, bool Write = false, int TimeoutMs = 0) const;
+    void SetModified() { stateLock.IncState(); }
+    void Add(cListObject* Object, cListObject* After = NULL);
+    void Del(cListObject* Object, bool DeleteObject = true);
+    virtual void Clear();
+    int Count() const { return count; }
+    cListObject* Get(int Index) const;
+
+  protected:
+    cListObject* objects;
+    cListObject* lastObject;
+    int count;
+    mutable cStateLock stateLock;
+};
+
+template<class T> class cList : public cListBase
+{
+  public:
+    cList(const char* NeedsLocking = NULL) : cListBase(NeedsLocking) {}
+    const T* Get(int Index) const { return (T*)cListBase::Get(Index); }
+    const T* First() const { return (T*)objects; }
+    const T* Last() const { return (T*)lastObject; }
+    const T* Prev(const T* Object) const { return (T*)Object->cListObject::Prev(); }
+    const T* Next(const T* Object) const { return (T*)Object->cListObject::Next(); }
+    T* Get(int Index) { return const_cast<T*>(static_cast<const cList<T>*>(this)->Get(Index)); }
+    T* First() { return (T*)objects; }
+    T* Last() { return (T*)lastObject; }
+    T* Prev(const T* Object) { return (T*)Object->cListObject::Prev(); }
+    T* Next(const T* Object) { return (T*)Object->cListObject::Next(); }
+};
+
+class cStringList
+{
+  public:
+    ~cStringList();
+    int Size() const { return strings.size(); }
+    const char* At(int Index) const { return strings[Index]; }
+    const char* operator[](int Index) const { return strings[Index]; }
+    void Append(char* s) { strings.push_back(s); }
+
+  private:
+    std::vector<char*> strings;
+};
+
+#endif
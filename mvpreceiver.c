@@ -1,3 +1,5 @@
+#include <arpa/inet.h>
+
 #include "mvpreceiver.h"
 
 int MVPReceiver::numMVPReceivers = 0;
@@ -49,7 +51,8 @@ MVPReceiver::MVPReceiver(const cChannel* channel, cDevice* device)
   vdrActivated = false;
   inittedOK = 0;
   streamID = 0;
-  tcp = NULL;
+  sendQueue = NULL;
+  clientStats = NULL;
 
 #if VDRVERSNUM >= 10712
   AddPid(channel->Tpid()); 
@@ -73,15 +76,22 @@ MVPReceiver::MVPReceiver(const cChannel* channel, cDevice* device)
   device->AttachReceiver(this);
 }
 
-int MVPReceiver::init(TCP* ttcp, ULONG tstreamID)
+int MVPReceiver::init(SendQueue* tsendQueue, ULONG tstreamID, ClientStats* tclientStats)
 {
-  tcp = ttcp;
+  sendQueue = tsendQueue;
+  clientStats = tclientStats;
+  if (clientStats) Stats::set(&clientStats->ringSize, processed.getCapacity());
   streamID = tstreamID;
   return inittedOK;
 }
 
 MVPReceiver::~MVPReceiver()
 {
+  if (clientStats)
+  {
+    Stats::set(&clientStats->ringSize, 0);
+    Stats::set(&clientStats->ringFill, 0);
+  }
   numMVPReceivers--;
   Log::getInstance()->log("MVPReceiver", Log::DEBUG, "num mvp receivers now down to %i", numMVPReceivers);
 }
@@ -117,6 +127,7 @@ void MVPReceiver::detachMVPReceiver()
 void MVPReceiver::Receive(UCHAR* data, int length)
 {
   pthread_mutex_lock(&processedRingLock);
+  updateRingStats(length);
   processed.put(data, length);
   if (processed.getContent() > streamChunkSize) threadSignal();
   pthread_mutex_unlock(&processedRingLock);
@@ -124,17 +135,30 @@ void MVPReceiver::Receive(UCHAR* data, int length)
 void MVPReceiver::Receive(const UCHAR* data, int length)
 {
   pthread_mutex_lock(&processedRingLock);
+  updateRingStats(length);
   processed.put(data, length);
   if (processed.getContent() > streamChunkSize) threadSignal();
   pthread_mutex_unlock(&processedRingLock);
 }
 
 
+void MVPReceiver::updateRingStats(int length)
+{
+  // processedRingLock must be held. The ringbuffer overwrites the oldest
+  // data when full, count that as dropped.
+  if (!clientStats) return;
+  ULONG content = processed.getContent();
+  ULONG capacity = processed.getCapacity();
+  if ((content + length) > capacity) Stats::add(&clientStats->ringDrops, content + length - capacity);
+  Stats::set(&clientStats->ringFill, (content + length) > capacity ? capacity : content + length);
+}
+
 void MVPReceiver::threadMethod()
 {
   ULONG *p;
   ULONG headerLength = sizeof(ULONG) * 4;
-  UCHAR buffer[streamChunkSize + headerLength];
+  UCHAR header[headerLength];
+  UCHAR* buffer;
   int amountReceived;
 
 //   threadSetKillable(); ??
@@ -148,16 +172,24 @@ void MVPReceiver::threadMethod()
     
     do
     {
+      // The send queue takes this buffer over, so get a fresh one each time
+      buffer = (UCHAR*)malloc(streamChunkSize);
+      if (!buffer)
+      {
+        logger->log("MVPReceiver", Log::ERR, "Stream chunk malloc error");
+        break;
+      }
+
       pthread_mutex_lock(&processedRingLock);
-      amountReceived = processed.get(buffer+headerLength, streamChunkSize);
+      amountReceived = processed.get(buffer, streamChunkSize);
       pthread_mutex_unlock(&processedRingLock);
     
-      p = (ULONG*)&buffer[0]; *p = htonl(2); // stream channel
-      p = (ULONG*)&buffer[4]; *p = htonl(streamID);
-      p = (ULONG*)&buffer[8]; *p = htonl(0); // here insert flag: 0 = ok, data follows
-      p = (ULONG*)&buffer[12]; *p = htonl(amountReceived);
+      p = (ULONG*)&header[0]; *p = htonl(2); // stream channel
+      p = (ULONG*)&header[4]; *p = htonl(streamID);
+      p = (ULONG*)&header[8]; *p = htonl(0); // here insert flag: 0 = ok, data follows
+      p = (ULONG*)&header[12]; *p = htonl(amountReceived);
 
-      tcp->sendPacket(buffer, amountReceived + headerLength);
+      sendQueue->sendPacketV(SendQueue::LANE_STREAM, header, headerLength, buffer, amountReceived);
     } while(processed.getContent() >= streamChunkSize);
   }  
 }
@@ -171,7 +203,7 @@ void MVPReceiver::sendStreamEnd()
   p = (ULONG*)&buffer[4]; *p = htonl(streamID);
   p = (ULONG*)&buffer[8]; *p = htonl(1); // stream end
   p = (ULONG*)&buffer[12]; *p = htonl(0); // zero length, no more data
-  tcp->sendPacket(buffer, bufferLength);
+  sendQueue->sendPacket(SendQueue::LANE_STREAM, buffer, bufferLength);
 }
 
 
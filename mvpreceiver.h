@@ -28,7 +28,8 @@
 #include "log.h"
 #include "thread.h"
 #include "ringbuffer.h"
-#include "tcp.h"
+#include "sendqueue.h"
+#include "stats.h"
 #include "thread.h"
 
 class MVPReceiver : public cReceiver, public Thread
@@ -36,7 +37,7 @@ class MVPReceiver : public cReceiver, public Thread
   public:
     static MVPReceiver* create(const cChannel*, int priority);
     virtual ~MVPReceiver();
-    int init(TCP* tcp, ULONG streamID);
+    int init(SendQueue* sendQueue, ULONG streamID, ClientStats* clientStats);
     bool isVdrActivated();
     void detachMVPReceiver();
 
@@ -49,7 +50,8 @@ class MVPReceiver : public cReceiver, public Thread
     Ringbuffer processed;    // A simpler deleting ringbuffer for processed data
     pthread_mutex_t processedRingLock; // needs outside locking
 
-    TCP* tcp;
+    SendQueue* sendQueue;
+    ClientStats* clientStats;
     ULONG streamID;
     ULONG streamDataCollected;
     int streamChunkSize;
@@ -59,6 +61,7 @@ class MVPReceiver : public cReceiver, public Thread
     void Receive(UCHAR *Data, int Length); // VDR 2.2.0
     void Receive(const UCHAR *Data, int Length); // > VDR 2.2.0
     void sendStreamEnd();
+    void updateRingStats(int length);
 
     static int numMVPReceivers;
     
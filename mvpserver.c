@@ -56,6 +56,7 @@ int MVPServer::stop()
   bootpd.shutdown();
   tftpd.shutdown();
   mvprelay.shutdown();
+  metrics.shutdown();
 
   log.log("Main", Log::INFO, "Stopped main server thread");
   log.shutdown();
@@ -93,9 +94,27 @@ int MVPServer::run(char* tconfigDir)
   char* cfgLogFilename = config.getValueString("General", "Log file");
   if (cfgLogFilename)
   {
-    log.init(Log::DEBUG, cfgLogFilename);
+    int logLevel = Log::DEBUG;
+    char* cfgLogLevel = config.getValueString("General", "Log level");
+    if (cfgLogLevel)
+    {
+      int level = Log::levelFromName(cfgLogLevel);
+      if (level >= 0) logLevel = level;
+      else dsyslog("VOMP: Log level in config not understood, using debug");
+      delete[] cfgLogLevel;
+    }
+
+    log.init(logLevel, cfgLogFilename);
     delete[] cfgLogFilename;
     log.log("Main", Log::INFO, "Logging started");
+
+    char* cfgModuleLevels = config.getValueString("General", "Log levels");
+    if (cfgModuleLevels)
+    {
+      if (!log.setModuleLevels(cfgModuleLevels))
+        log.log("Main", Log::ERR, "Could not understand all of Log levels '%s'", cfgModuleLevels);
+      delete[] cfgModuleLevels;
+    }
   }
   else
   {
@@ -216,6 +235,10 @@ int MVPServer::run(char* tconfigDir)
   if (configString && (strcasecmp(configString, "yes"))) mvprelayEnabled = 0;
   if (configString) delete[] configString;
 
+  fail = 1;
+  int metricsPort = config.getValueLong("General", "Metrics port", &fail);
+  if (fail || (metricsPort <= 0) || (metricsPort > 65535)) metricsPort = 0;
+
 
   if (bootpEnabled)
   {
@@ -291,6 +314,13 @@ int MVPServer::run(char* tconfigDir)
   {
     log.log("Main", Log::INFO, "Not starting MVPRelay");
   }
+
+  // Metrics are for local monitoring only, a failure here is not fatal
+  if (metricsPort)
+  {
+    if (!metrics.run((USHORT)metricsPort))
+      log.log("Main", Log::ERR, "Could not start metrics server on port %i", metricsPort);
+  }
   
   // start thread here
   if (!threadStart())
@@ -29,11 +29,16 @@
 #include "udpreplier.h"
 #include "udp6replier.h"
 #include "mvprelay.h"
+#include "metricsserver.h"
 #include "bootpd.h"
 #include "tftpd.h"
 #include "vompclient.h"
 #include "thread.h"
 #include "config.h"
+#include "stats.h"
+#ifndef VOMPSTANDALONE
+#include "epgindex.h"
+#endif
 
 class MVPServer : public Thread
 {
@@ -48,12 +53,17 @@ class MVPServer : public Thread
     void threadMethod();
 
     Log log;
+    Stats stats;
+#ifndef VOMPSTANDALONE
+    EpgIndex epgIndex;
+#endif
     Config config;
     UDPReplier udpr;
     UDP6Replier udpr6;
     Bootpd bootpd;
     Tftpd tftpd;
     MVPRelay mvprelay;
+    MetricsServer metrics;
     int listeningSocket;
     char* configDir;
     char* logoDir;
@@ -9,15 +9,15 @@ PictureReader::PictureReader(VompClient *client)
 {
   logger = Log::getInstance();
   inittedOK = 0;
-  tcp = NULL;
+  sendQueue = NULL;
   x = client;
 
   pthread_mutex_init(&pictureLock, NULL);
 }  
 
-int PictureReader::init(TCP* ttcp)
+int PictureReader::init(SendQueue* tsendQueue)
 {
-  tcp = ttcp;
+  sendQueue = tsendQueue;
   threadStart();
 
   return inittedOK;
@@ -316,7 +316,7 @@ void PictureReader::threadMethod()
 {
   ULONG *p;
   ULONG headerLength = sizeof(ULONG) * 4;
-  UCHAR buffer[headerLength];
+  UCHAR header[headerLength];
 
 //   threadSetKillable(); ??
 
@@ -358,12 +358,15 @@ void PictureReader::threadMethod()
          memsize = filesize + headerLength;
 
          if (memsize && memsize < 1000000) { // No pictures over 1 MB
+            // The length field has always counted the header as well, so the
+            // payload is padded by headerLength to match it
             mem = (UCHAR*)malloc(memsize);
             if (mem) {
+        	memset(mem + filesize, 0, headerLength);
         	FILE * file=fopen(pictname.c_str(),"r");
 
         	if (file) {
-        	    size_t size=fread(mem+headerLength,1,filesize,file);
+        	    size_t size=fread(mem,1,filesize,file);
 
         	    fclose(file);
         	    if (size!=filesize) memsize=headerLength; // error
@@ -372,23 +375,19 @@ void PictureReader::threadMethod()
              }
            } 
        } 
-       if (!mem) {
-          mem = buffer;
-       }
-
-         
-    
-      p = (ULONG*)&mem[0]; *p = htonl(5); // stream channel
-      p = (ULONG*)&mem[4]; *p = htonl(req.streamID);
-      p = (ULONG*)&mem[8]; *p = htonl(flag); // here insert flag: 0 = ok, data follows
-      p = (ULONG*)&mem[12]; *p = htonl(memsize);
-
-      if (!tcp->sendPacket(mem, memsize + headerLength)) {
+       if (!mem) memsize = 0;
+
+      p = (ULONG*)&header[0]; *p = htonl(5); // stream channel
+      p = (ULONG*)&header[4]; *p = htonl(req.streamID);
+      p = (ULONG*)&header[8]; *p = htonl(flag); // here insert flag: 0 = ok, data follows
+      p = (ULONG*)&header[12]; *p = htonl(memsize);
+
+      // The picture buffer is handed over to the send queue and sent straight
+      // after the header, without copying it
+      if (!sendQueue->sendPacketV(SendQueue::LANE_BULK, header, headerLength, mem, memsize)) {
           logger->log("PictRead",Log::DEBUG,"Sending Picture failed");
       }
 
-      if (mem != buffer && mem) free(mem);
-
     } while (newpicture);
   }
   logger->log("PictRead",Log::DEBUG,"PictureReaderThread ended");
@@ -24,7 +24,7 @@
 #include "defines.h"
 #include "log.h"
 #include "thread.h"
-#include "tcp.h"
+#include "sendqueue.h"
 #include "thread.h"
 #include "vompclient.h"
 #include "services/scraper2vdr.h"
@@ -47,7 +47,7 @@ class PictureReader : public Thread
   public:
     PictureReader(VompClient * client);
     virtual ~PictureReader();
-    int init(TCP* tcp);
+    int init(SendQueue* sendQueue);
     void detachMVPReceiver();
     void addTVMediaRequest(TVMediaRequest&);
     bool epgImageExists(int event);
@@ -61,7 +61,7 @@ class PictureReader : public Thread
     pthread_mutex_t pictureLock; // needs outside locking
     std::queue<TVMediaRequest> pictures;
 
-    TCP* tcp;
+    SendQueue* sendQueue;
     VompClient * x;
     cSeries series;
     cMovie movie;
@@ -24,6 +24,7 @@
 
 #include "responsepacket.h"
 #include "log.h"
+#include "stats.h"
 
 /* Packet format for an RR channel response:
 
@@ -38,6 +39,7 @@ ResponsePacket::ResponsePacket()
   buffer = NULL;
   bufSize = 0;
   bufUsed = 0;
+  pool = NULL;
 }
 
 ResponsePacket::~ResponsePacket()
@@ -45,13 +47,12 @@ ResponsePacket::~ResponsePacket()
   if (buffer) free(buffer);
 }
 
-bool ResponsePacket::init(ULONG requestID)
+bool ResponsePacket::init(ULONG requestID, ULONG sizeHint)
 {
-  if (buffer) return false;
+  if (bufUsed) return false; // already initted
   
-  bufSize = 512;
-  buffer = (UCHAR*)malloc(bufSize);
-  if (!buffer) return false;
+  if (sizeHint < headerLength) sizeHint = headerLength;
+  if (!grow(sizeHint)) return false;
   
   *(ULONG*)&buffer[0] = htonl(1); // RR channel
   *(ULONG*)&buffer[4] = htonl(requestID);
@@ -129,15 +130,32 @@ bool ResponsePacket::adddouble(double d)
 
 bool ResponsePacket::checkExtend(ULONG by)
 {
-  if ((bufUsed + by) < bufSize) return true;
-  if (512 > by) by = 512;
-  UCHAR* newBuf = (UCHAR*)realloc(buffer, bufSize + by);
+  if (by > (maxBufSize - bufUsed)) return false;
+  if ((bufUsed + by) <= bufSize) return true;
+  return grow(bufUsed + by);
+}
+
+bool ResponsePacket::grow(ULONG needed)
+{
+  // Double until big enough, so building a large list costs a handful of
+  // reallocs rather than one per 512 bytes
+  if (needed <= bufSize) return true;
+  if (needed > maxBufSize) return false;
+  ULONG newSize = bufSize ? bufSize : minBufSize;
+  while (newSize < needed) newSize = (newSize > (maxBufSize / 2)) ? maxBufSize : newSize * 2;
+  UCHAR* newBuf = (UCHAR*)realloc(buffer, newSize);
   if (!newBuf) return false;
   buffer = newBuf;
-  bufSize += by;
+  bufSize = newSize;
   return true;
 }
 
+void ResponsePacket::release()
+{
+  if (pool) pool->put(this);
+  else delete this;
+}
+
 ULLONG ResponsePacket::htonll(ULLONG a)
 {
   #if BYTE_ORDER == BIG_ENDIAN
@@ -158,3 +176,62 @@ ULLONG ResponsePacket::htonll(ULLONG a)
   #endif
 }
 
+
+ResponsePacketPool::ResponsePacketPool()
+{
+  pthread_mutex_init(&poolLock, NULL);
+}
+
+ResponsePacketPool::~ResponsePacketPool()
+{
+  for (ULONG i = 0; i < freePackets.size(); i++) delete freePackets[i];
+  pthread_mutex_destroy(&poolLock);
+}
+
+ResponsePacket* ResponsePacketPool::get()
+{
+  ResponsePacket* packet = NULL;
+
+  pthread_mutex_lock(&poolLock);
+  if (!freePackets.empty())
+  {
+    packet = freePackets.back();
+    freePackets.pop_back();
+  }
+  pthread_mutex_unlock(&poolLock);
+
+  Stats* stats = Stats::getInstance();
+  if (stats)
+  {
+    if (packet) stats->cacheHit(Stats::CACHE_RESPONSE_POOL);
+    else stats->cacheMiss(Stats::CACHE_RESPONSE_POOL);
+  }
+
+  if (!packet)
+  {
+    packet = new ResponsePacket();
+    packet->pool = this;
+  }
+  return packet;
+}
+
+void ResponsePacketPool::put(ResponsePacket* packet)
+{
+  packet->bufUsed = 0;
+  if (packet->bufSize > maxKeepSize)
+  {
+    free(packet->buffer);
+    packet->buffer = NULL;
+    packet->bufSize = 0;
+  }
+
+  pthread_mutex_lock(&poolLock);
+  if (freePackets.size() < maxPooled)
+  {
+    freePackets.push_back(packet);
+    packet = NULL;
+  }
+  pthread_mutex_unlock(&poolLock);
+
+  if (packet) delete packet;
+}
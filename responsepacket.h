@@ -21,16 +21,23 @@
 #ifndef RESPONSEPACKET_H
 #define RESPONSEPACKET_H
 
+#include <pthread.h>
+#include <vector>
+
 #include "defines.h"
 #include <vdr/tools.h>
 
+class ResponsePacketPool;
+
 class ResponsePacket
 {
   public:
     ResponsePacket();
     ~ResponsePacket();
     
-    bool init(ULONG requestID);
+    // sizeHint is the expected size of the whole packet, if known. The
+    // buffer grows geometrically past it anyway.
+    bool init(ULONG requestID, ULONG sizeHint = 0);
     void finalise();
     bool copyin(const UCHAR* src, ULONG len);
     bool addString(const char* string);
@@ -42,19 +49,50 @@ class ResponsePacket
 
     UCHAR* getPtr() { return buffer; }
     ULONG getLen() { return bufUsed; }
+
+    // Hand the packet back to the pool it came from, or delete it
+    void release();
     
   private:
+    friend class ResponsePacketPool;
 
     UCHAR* buffer;
     ULONG bufSize;
     ULONG bufUsed;
+    ResponsePacketPool* pool;
 
     bool checkExtend(ULONG by);
+    bool grow(ULONG needed);
     ULLONG htonll(ULLONG a);
     
     const static ULONG headerLength = 12;
     const static ULONG userDataLenPos = 8;
+    const static ULONG minBufSize = 512;
+    const static ULONG maxBufSize = 0x10000000; // no reply gets near this, and doubling can't overflow
 };
 
-#endif
+/*
+  Keeps finished ResponsePackets and their buffers for reuse, so a busy
+  client doesn't malloc/realloc a new buffer for every reply. Packets can be
+  released from any thread (the send queue releases them after writing).
+  The pool must outlive every packet it has handed out.
+*/
 
+class ResponsePacketPool
+{
+  public:
+    ResponsePacketPool();
+    ~ResponsePacketPool();
+
+    ResponsePacket* get();
+    void put(ResponsePacket* packet);
+
+  private:
+    pthread_mutex_t poolLock;
+    std::vector<ResponsePacket*> freePackets;
+
+    const static ULONG maxPooled = 8;         // packets kept per pool
+    const static ULONG maxKeepSize = 524288;  // bigger buffers are freed, not kept
+};
+
+#endif
@@ -98,3 +98,8 @@ int Ringbuffer::getContent()
 {
   return content;
 }
+
+int Ringbuffer::getCapacity()
+{
+  return capacity;
+}
@@ -36,6 +36,7 @@ class Ringbuffer
     int put(const UCHAR* from, size_t amount);
     int get(UCHAR* to, size_t amount);
     int getContent();
+    int getCapacity();
 
   private:
     UCHAR* buffer;
@@ -0,0 +1,275 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+
+#include "sendqueue.h"
+#include "tcp.h"
+#include "responsepacket.h"
+#include "stats.h"
+#include "trace.h"
+
+// Per lane byte limits. Control packets are tiny, RR replies can be up to
+// about 1MB (getblock), stream chunks are 50k, pictures are up to 1MB.
+const ULONG SendQueue::laneLimits[SendQueue::NUM_LANES] = { 65536, 4000000, 2000000, 4000000 };
+
+SendQueue::SendQueue()
+{
+  log = Log::getInstance();
+  tcp = NULL;
+  clientStats = NULL;
+  trace = NULL;
+  stopping = false;
+  failed = false;
+  for (int i = 0; i < NUM_LANES; i++) laneBytes[i] = 0;
+
+  pthread_mutex_init(&queueLock, NULL);
+  pthread_cond_init(&dataCond, NULL);
+  pthread_cond_init(&spaceCond, NULL);
+}
+
+SendQueue::~SendQueue()
+{
+  shutdown();
+  pthread_cond_destroy(&spaceCond);
+  pthread_cond_destroy(&dataCond);
+  pthread_mutex_destroy(&queueLock);
+}
+
+int SendQueue::init(TCP* ttcp, ClientStats* tclientStats)
+{
+  tcp = ttcp;
+  clientStats = tclientStats;
+  if (!threadStart())
+  {
+    log->log("SendQueue", Log::ERR, "Could not start sender thread");
+    pthread_mutex_lock(&queueLock);
+    failed = true;
+    pthread_mutex_unlock(&queueLock);
+    return 0;
+  }
+  return 1;
+}
+
+void SendQueue::setTrace(RequestTrace* ttrace)
+{
+  trace = ttrace;
+}
+
+void SendQueue::shutdown()
+{
+  pthread_mutex_lock(&queueLock);
+  if (stopping)
+  {
+    pthread_mutex_unlock(&queueLock);
+    return;
+  }
+  stopping = true;
+  pthread_cond_broadcast(&dataCond);
+  pthread_cond_broadcast(&spaceCond);
+  pthread_mutex_unlock(&queueLock);
+
+  if (threadIsActive()) threadStop();
+
+  pthread_mutex_lock(&queueLock);
+  dropAll();
+  pthread_mutex_unlock(&queueLock);
+}
+
+int SendQueue::sendResponse(ResponsePacket* resp, ULONG opcode)
+{
+  Item item;
+  item.opcode = opcode;
+  item.headerLen = 0;
+  item.data = resp->getPtr();
+  item.len = resp->getLen();
+  item.resp = resp;
+  // RR header: channel, requestID, user data length
+  if (trace) trace->response(ntohl(*(ULONG*)&item.data[4]), opcode, ntohl(*(ULONG*)&item.data[8]));
+  return enqueue(LANE_RR, item);
+}
+
+int SendQueue::sendPacket(int lane, const UCHAR* data, ULONG len)
+{
+  UCHAR* copy = (UCHAR*)malloc(len);
+  if (!copy)
+  {
+    log->log("SendQueue", Log::ERR, "Packet copy malloc error");
+    return 0;
+  }
+  memcpy(copy, data, len);
+  return sendPacketNoCopy(lane, copy, len);
+}
+
+int SendQueue::sendPacketNoCopy(int lane, UCHAR* data, ULONG len)
+{
+  Item item;
+  item.opcode = Stats::NO_OPCODE;
+  item.headerLen = 0;
+  item.data = data;
+  item.len = len;
+  item.resp = NULL;
+  return enqueue(lane, item);
+}
+
+int SendQueue::sendPacketV(int lane, const UCHAR* header, ULONG headerLen, UCHAR* payload, ULONG payloadLen)
+{
+  Item item;
+  item.opcode = Stats::NO_OPCODE;
+  item.data = payload;
+  item.len = payloadLen;
+  item.resp = NULL;
+
+  if (headerLen > MAX_HEADER)
+  {
+    log->log("SendQueue", Log::ERR, "Header too long: %lu", headerLen);
+    release(item);
+    return 0;
+  }
+  memcpy(item.header, header, headerLen);
+  item.headerLen = headerLen;
+  return enqueue(lane, item);
+}
+
+int SendQueue::enqueue(int lane, Item& item)
+{
+  pthread_mutex_lock(&queueLock);
+
+  // Wait for room in this lane, but always accept into an empty lane
+  ULONG itemBytes = item.headerLen + item.len;
+  while (!stopping && !failed && laneBytes[lane] && ((laneBytes[lane] + itemBytes) > laneLimits[lane]))
+  {
+    pthread_cond_wait(&spaceCond, &queueLock);
+  }
+
+  if (stopping || failed)
+  {
+    pthread_mutex_unlock(&queueLock);
+    release(item);
+    return 0;
+  }
+
+  item.queuedUs = Stats::nowUs();
+  lanes[lane].push(item);
+  laneBytes[lane] += itemBytes;
+  pthread_cond_signal(&dataCond);
+  pthread_mutex_unlock(&queueLock);
+  return 1;
+}
+
+int SendQueue::nextLane()
+{
+  for (int i = 0; i < NUM_LANES; i++)
+  {
+    if (!lanes[i].empty()) return i;
+  }
+  return -1;
+}
+
+void SendQueue::release(Item& item)
+{
+  if (item.resp) item.resp->release();
+  else if (item.data) free(item.data);
+  item.data = NULL;
+  item.resp = NULL;
+}
+
+void SendQueue::dropAll()
+{
+  // queueLock must be held
+  for (int i = 0; i < NUM_LANES; i++)
+  {
+    while (!lanes[i].empty())
+    {
+      release(lanes[i].front());
+      lanes[i].pop();
+    }
+    laneBytes[i] = 0;
+  }
+}
+
+void SendQueue::threadMethod()
+{
+  pthread_mutex_lock(&queueLock);
+
+  while(1)
+  {
+    int lane = nextLane();
+    while ((lane == -1) && !stopping)
+    {
+      pthread_cond_wait(&dataCond, &queueLock);
+      lane = nextLane();
+    }
+    if (stopping) break;
+
+    Item item = lanes[lane].front();
+    lanes[lane].pop();
+    int more = (nextLane() != -1);
+    pthread_mutex_unlock(&queueLock);
+
+    struct iovec iov[2];
+    int iovcnt = 0;
+    if (item.headerLen)
+    {
+      iov[iovcnt].iov_base = item.header;
+      iov[iovcnt].iov_len = item.headerLen;
+      iovcnt++;
+    }
+    if (item.len)
+    {
+      iov[iovcnt].iov_base = item.data;
+      iov[iovcnt].iov_len = item.len;
+      iovcnt++;
+    }
+
+    int success = tcp->sendPacketV(iov, iovcnt, more);
+    ULONG len = item.headerLen + item.len;
+    if (success)
+    {
+      Stats* stats = Stats::getInstance();
+      if (item.opcode != Stats::NO_OPCODE) stats->responseSent(item.opcode, len, Stats::nowUs() - item.queuedUs);
+      if (clientStats)
+      {
+        Stats::add(&clientStats->bytesOut, len);
+        if (lane == LANE_STREAM) Stats::add(&clientStats->streamBytes, item.len);
+      }
+    }
+    release(item);
+
+    pthread_mutex_lock(&queueLock);
+    laneBytes[lane] -= len;
+
+    if (!success)
+    {
+      log->log("SendQueue", Log::DEBUG, "Send failed, dropping queued packets");
+      failed = true;
+      dropAll();
+      pthread_cond_broadcast(&spaceCond);
+      break;
+    }
+
+    pthread_cond_broadcast(&spaceCond);
+  }
+
+  pthread_mutex_unlock(&queueLock);
+}
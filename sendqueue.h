@@ -0,0 +1,124 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Outbound packet queue for one client connection.
+
+  Before this class every producer (RR thread, live receiver, picture reader,
+  keepalive replies) wrote to the socket itself, serialised only by the TCP
+  sendLock. A big getblock reply or a slow socket then held up everything else.
+
+  Now producers hand their packet to the SendQueue and return. A single
+  sender thread owns the socket writes and always picks the next packet from
+  the highest priority lane that has anything queued:
+
+    LANE_CONTROL   keepalive replies
+    LANE_RR        request/response replies
+    LANE_STREAM    live TV stream chunks
+    LANE_BULK      pictures
+
+  A packet can be queued as a small header plus a separate payload buffer.
+  The sender writes both with one sendmsg() so producers don't have to copy
+  payloads behind a header, and while more packets are waiting it sets
+  MSG_MORE so bursts of small replies go out in full segments.
+
+  Packets are never interleaved on the wire, so a packet that is already being
+  written still has to finish first. Each lane has a byte limit; a producer
+  that would push its lane over the limit waits until the sender has made
+  room (a packet is always accepted into an empty lane so oversize packets
+  can't deadlock). Other lanes are not affected by a full lane.
+*/
+
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <pthread.h>
+#include <queue>
+
+#include "defines.h"
+#include "log.h"
+#include "thread.h"
+
+class TCP;
+class ResponsePacket;
+struct ClientStats;
+class RequestTrace;
+
+class SendQueue : public Thread
+{
+  public:
+    SendQueue();
+    virtual ~SendQueue();
+
+    int init(TCP* tcp, ClientStats* clientStats);
+    void setTrace(RequestTrace* trace); // RR reply sizes are recorded here, call before init
+    void shutdown();
+
+    // All of these return 1 if the packet was queued, 0 if the connection
+    // is dead or shutting down. Ownership passes to the queue either way.
+    int sendResponse(ResponsePacket* resp, ULONG opcode);    // LANE_RR, released after sending
+    int sendPacket(int lane, const UCHAR* data, ULONG len);  // data is copied
+    int sendPacketNoCopy(int lane, UCHAR* data, ULONG len);  // data must be malloc'd, freed after sending
+    // header (up to MAX_HEADER bytes) is copied, payload as for sendPacketNoCopy and may be NULL
+    int sendPacketV(int lane, const UCHAR* header, ULONG headerLen, UCHAR* payload, ULONG payloadLen);
+
+    const static int LANE_CONTROL = 0;
+    const static int LANE_RR      = 1;
+    const static int LANE_STREAM  = 2;
+    const static int LANE_BULK    = 3;
+    const static int NUM_LANES    = 4;
+
+    const static ULONG MAX_HEADER = 16;
+
+  private:
+    struct Item
+    {
+      UCHAR header[MAX_HEADER];
+      ULONG headerLen;
+      UCHAR* data;
+      ULONG len;
+      ResponsePacket* resp;
+      ULONG opcode;     // for stats, Stats::NO_OPCODE if not a RR response
+      ULLONG queuedUs;
+    };
+
+    int enqueue(int lane, Item& item);
+    int nextLane();
+    void release(Item& item);
+    void dropAll();
+
+    void threadMethod();
+
+    Log* log;
+    TCP* tcp;
+    ClientStats* clientStats;
+    RequestTrace* trace;
+    pthread_mutex_t queueLock;
+    pthread_cond_t dataCond;   // signalled when something is queued or on shutdown
+    pthread_cond_t spaceCond;  // signalled when the sender has freed lane space
+    bool stopping;
+    bool failed;
+
+    std::queue<Item> lanes[NUM_LANES];
+    ULONG laneBytes[NUM_LANES];
+    const static ULONG laneLimits[NUM_LANES];
+};
+
+#endif
@@ -45,11 +45,14 @@ int SerializeBuffer::checkSpace(int amount) {
        end=start+size;
        return 0;
      }
-     UCHAR *ns=new UCHAR[size+BUFFERINCREASE];
+     ULONG increase=BUFFERINCREASE;
+     if ((ULONG)(current+amount-start) > size+increase) increase=current+amount-start-size;
+     UCHAR *ns=useMalloc?(UCHAR *)malloc(size+increase):new UCHAR[size+increase];
      if (!ns) return -1;
-     memcpy(ns,start,end-start);
-     size=size+BUFFERINCREASE;
+     memcpy(ns,start,current-start);
+     size=size+increase;
      end=ns+size;
+     current=ns+(current-start);
      if (useMalloc) free( start);
      else delete [] start;
      start=ns;
@@ -212,10 +215,12 @@ int Serializable::getSerializedLen() {
   return 6 + getSerializedLenImpl();
 }
 int Serializable::serialize(SerializeBuffer *b) {
-  UCHAR *ptr=b->getCurrent();
+  //keep an offset, the buffer can move when it grows
+  int offset=b->getCurrent()-b->getStart();
   if (b->encodeShort(version) != 0) return -1;
   if (b->encodeLong(0) != 0) return -1; //dummy len
   if (serializeImpl(b) != 0) return -1;
+  UCHAR *ptr=b->getStart()+offset;
   UCHAR *ep=b->getCurrent();
   //now write the len
   int len=ep-ptr-6;
@@ -37,14 +37,25 @@
 ServerMediaFile::ServerMediaFile(Config *c,MediaPlayerRegister *distributor):MediaFile(MPROVIDERID_SERVERMEDIAFILE){
   cfg=c;
   distributor->registerMediaProvider(this,MPROVIDERID_SERVERMEDIAFILE);
+  dirhandlerVersion=cfg->getVersion();
   dirhandler=new MediaLauncher(cfg);
   dirhandler->init();
   for (int i=0;i<NUMCHANNELS;i++) {
     launchers[i]=new MediaLauncher(cfg);
     launchers[i]->init(dirhandler);
+    launcherVersions[i]=dirhandlerVersion;
   }
 }
 
+//pick up config changes, the command checks only run again if the commands changed
+//call only while the dirhandler has no stream open
+void ServerMediaFile::refreshDirhandler() {
+  ULONG version=cfg->getVersion();
+  if (version == dirhandlerVersion) return;
+  dirhandlerVersion=version;
+  dirhandler->init();
+}
+
 ServerMediaFile::~ServerMediaFile(){
   for (int i=0;i<NUMCHANNELS;i++) {
     launchers[i]->closeStream();
@@ -55,6 +66,7 @@ ServerMediaFile::~ServerMediaFile(){
 
 MediaList* ServerMediaFile::getRootList() {
   Log::getInstance()->log("MediaFile::getRootList",Log::DEBUG,"");
+  refreshDirhandler();
   MediaURI *ru=new MediaURI(providerid,NULL,NULL);
   MediaList *rt=new MediaList(ru);
   delete ru;
@@ -64,7 +76,7 @@ MediaList* ServerMediaFile::getRootList() {
   for (int nr=1;nr<=50;nr++){
     char buffer[30];
     sprintf(buffer,"Dir.%d",nr);
-    const char * dn=cfg->getValueString("Media",buffer);
+    char * dn=cfg->getValueString("Media",buffer);
     if (dn != NULL) {
       if (stat(dn,&st) != 0 || ! S_ISDIR(st.st_mode)) {
         Log::getInstance()->log("MediaFile::getRootList",Log::ERR,"unable to open basedir %s",dn);
@@ -75,10 +87,13 @@ MediaList* ServerMediaFile::getRootList() {
         m->setMediaType(MEDIA_TYPE_DIR);
         m->setTime(st.st_mtime);
         sprintf(buffer,"Dir.Name.%d",nr);
-        m->setDisplayName(cfg->getValueString("Media",buffer));
+        char * displayName=cfg->getValueString("Media",buffer);
+        m->setDisplayName(displayName);
+        delete[] displayName;
         rt->push_back(m);
         Log::getInstance()->log("Media",Log::DEBUG,"added base dir %s",dn);
       }
+      delete[] dn;
      }
    }
   return rt;
@@ -93,6 +108,11 @@ ULONG ServerMediaFile::getMediaType(const char *filename) {
 int ServerMediaFile::openMedium(ULONG channel, const MediaURI * uri, ULLONG * size, ULONG xsize, ULONG ysize){
   if (channel >= NUMCHANNELS) return -1;
   launchers[channel]->closeStream();
+  refreshDirhandler();
+  if (launcherVersions[channel] != dirhandlerVersion) {
+    launchers[channel]->init(dirhandler);
+    launcherVersions[channel]=dirhandlerVersion;
+  }
   ULONG rt=launchers[channel]->getTypeForName(uri->getName());
   if (rt != MEDIA_TYPE_UNKNOWN) {
     *size=0;
@@ -132,6 +152,7 @@ int ServerMediaFile::getMediaInfo(ULONG channel, MediaInfo * result){
 
 
 MediaList* ServerMediaFile::getMediaList(const MediaURI *parent) {
+  refreshDirhandler();
   ULONG rt=dirhandler->getTypeForName(parent->getName());
   if (rt == MEDIA_TYPE_UNKNOWN) return MediaFile::getMediaList(parent);
   int op=dirhandler->openStream(parent->getName(),0,0);
@@ -49,6 +49,10 @@ class ServerMediaFile : public MediaFile
 
   private:
     Config *cfg;
+    //config versions the launchers were set up from
+    ULONG dirhandlerVersion;
+    ULONG launcherVersions[NUMCHANNELS];
+    void refreshDirhandler();
     ULONG addDataToList(unsigned char * buf, ULONG buflen,MediaList *list,bool extendedFormat) ;
 
 
@@ -0,0 +1,365 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdarg.h>
+
+#include "stats.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+  count = 0;
+  sumUs = 0;
+  maxUs = 0;
+  memset(buckets, 0, sizeof(buckets));
+}
+
+void LatencyHistogram::add(ULLONG us)
+{
+  int bucket = 0;
+  ULLONG v = us;
+  while (v && (bucket < (NUM_BUCKETS - 1)))
+  {
+    v >>= 1;
+    bucket++;
+  }
+
+  __sync_fetch_and_add(&buckets[bucket], 1);
+  __sync_fetch_and_add(&sumUs, us);
+  __sync_fetch_and_add(&count, 1);
+
+  ULLONG oldMax = maxUs;
+  while ((us > oldMax) && !__sync_bool_compare_and_swap(&maxUs, oldMax, us)) oldMax = maxUs;
+}
+
+ULLONG LatencyHistogram::bucketLimit(int bucket)
+{
+  return 1ULL << bucket;
+}
+
+ULLONG LatencyHistogram::percentile(double fraction) const
+{
+  ULLONG total = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++) total += buckets[i];
+  if (!total) return 0;
+
+  ULLONG wanted = (ULLONG)(total * fraction);
+  if (wanted >= total) wanted = total - 1;
+
+  ULLONG seen = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++)
+  {
+    seen += buckets[i];
+    if (seen > wanted)
+    {
+      ULLONG limit = bucketLimit(i);
+      return (limit < maxUs) ? limit : maxUs;
+    }
+  }
+  return maxUs;
+}
+
+Stats* Stats::instance = NULL;
+
+const char* Stats::cacheNames[NUM_CACHES] = { "response_pool", "request_pool", "i18n", "charsetconv", "epgindex" };
+const char* Stats::lockNames[NUM_LOCKS] = { "recordings", "channels", "schedules", "timers" };
+
+Stats::Stats()
+{
+  if (instance) return;
+  instance = this;
+
+  closedBytesIn = 0;
+  closedBytesOut = 0;
+  closedStreamBytes = 0;
+  closedRingDrops = 0;
+  closedRequests = 0;
+  closedReadSyscalls = 0;
+  closedWriteSyscalls = 0;
+  recPlayerBytes = 0;
+  memset(cacheHits, 0, sizeof(cacheHits));
+  memset(cacheMisses, 0, sizeof(cacheMisses));
+  startTime = time(NULL);
+  nextClientID = 1;
+  pthread_mutex_init(&clientsLock, NULL);
+}
+
+Stats::~Stats()
+{
+  pthread_mutex_lock(&clientsLock);
+  for (std::list<ClientStats*>::iterator i = clients.begin(); i != clients.end(); ++i) delete *i;
+  clients.clear();
+  pthread_mutex_unlock(&clientsLock);
+
+  instance = NULL;
+}
+
+Stats* Stats::getInstance()
+{
+  return instance;
+}
+
+ULLONG Stats::nowUs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ULLONG)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+LockHoldTimer::LockHoldTimer(int tlock)
+: lock(tlock), start(Stats::nowUs())
+{
+}
+
+LockHoldTimer::~LockHoldTimer()
+{
+  Stats* stats = Stats::getInstance();
+  if (stats) stats->lockHeld(lock, Stats::nowUs() - start);
+}
+
+OpcodeStats* Stats::getOpcodeStats(ULONG opcode)
+{
+  if (opcode > MAX_OPCODE) opcode = MAX_OPCODE + 1;
+  return &opcodes[opcode];
+}
+
+void Stats::requestProcessed(ULONG opcode, ULLONG queueWaitUs, ULLONG processingUs, bool ok)
+{
+  OpcodeStats* o = getOpcodeStats(opcode);
+  add(&o->requests, 1);
+  if (!ok) add(&o->errors, 1);
+  o->queueWait.add(queueWaitUs);
+  o->processing.add(processingUs);
+}
+
+void Stats::requestCancelled(ULONG opcode)
+{
+  add(&getOpcodeStats(opcode)->cancelled, 1);
+}
+
+void Stats::responseSent(ULONG opcode, ULONG bytes, ULLONG sendUs)
+{
+  if (opcode == NO_OPCODE) return;
+  OpcodeStats* o = getOpcodeStats(opcode);
+  add(&o->bytesOut, bytes);
+  o->send.add(sendUs);
+}
+
+void Stats::recPlayerRead(ULONG bytes, ULLONG us)
+{
+  add(&recPlayerBytes, bytes);
+  recPlayerReads.add(us);
+}
+
+ClientStats* Stats::registerClient()
+{
+  ClientStats* client = new ClientStats;
+  memset(client, 0, sizeof(ClientStats));
+  client->connectedAt = time(NULL);
+
+  pthread_mutex_lock(&clientsLock);
+  client->id = nextClientID++;
+  clients.push_back(client);
+  pthread_mutex_unlock(&clientsLock);
+  return client;
+}
+
+void Stats::unregisterClient(ClientStats* client)
+{
+  pthread_mutex_lock(&clientsLock);
+  clients.remove(client);
+  add(&closedBytesIn, client->bytesIn);
+  add(&closedBytesOut, client->bytesOut);
+  add(&closedStreamBytes, client->streamBytes);
+  add(&closedRingDrops, client->ringDrops);
+  add(&closedRequests, client->requests);
+  add(&closedReadSyscalls, client->readSyscalls);
+  add(&closedWriteSyscalls, client->writeSyscalls);
+  pthread_mutex_unlock(&clientsLock);
+  delete client;
+}
+
+void Stats::getClients(std::list<ClientStats>& result, ClientStats* closed)
+{
+  pthread_mutex_lock(&clientsLock);
+  for (std::list<ClientStats*>::iterator i = clients.begin(); i != clients.end(); ++i) result.push_back(**i);
+  if (closed)
+  {
+    memset(closed, 0, sizeof(ClientStats));
+    closed->bytesIn = closedBytesIn;
+    closed->bytesOut = closedBytesOut;
+    closed->streamBytes = closedStreamBytes;
+    closed->ringDrops = closedRingDrops;
+    closed->requests = closedRequests;
+    closed->readSyscalls = closedReadSyscalls;
+    closed->writeSyscalls = closedWriteSyscalls;
+  }
+  pthread_mutex_unlock(&clientsLock);
+}
+
+static void appendf(std::string& out, const char* format, ...) __attribute__ ((format (printf, 2, 3)));
+static void appendf(std::string& out, const char* format, ...)
+{
+  char line[512];
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(line, sizeof(line), format, ap);
+  va_end(ap);
+  out += line;
+}
+
+static void appendHistogram(std::string& out, const char* name, const LatencyHistogram& h, bool json)
+{
+  ULLONG mean = h.count ? h.sumUs / h.count : 0;
+  if (json)
+    appendf(out, "\"%s\":{\"count\":%llu,\"mean_us\":%llu,\"p50_us\":%llu,\"p99_us\":%llu,\"max_us\":%llu}",
+            name, (unsigned long long)h.count, (unsigned long long)mean, (unsigned long long)h.percentile(0.5),
+            (unsigned long long)h.percentile(0.99), (unsigned long long)h.maxUs);
+  else
+    appendf(out, " %s n=%llu mean=%llu p50=%llu p99=%llu max=%llu", name,
+            (unsigned long long)h.count, (unsigned long long)mean,
+            (unsigned long long)h.percentile(0.5), (unsigned long long)h.percentile(0.99), (unsigned long long)h.maxUs);
+}
+
+std::string Stats::dump(bool json)
+{
+  std::string out;
+  std::list<ClientStats> live;
+  ClientStats closed;
+  getClients(live, &closed);
+
+  if (json) appendf(out, "{\"uptime\":%ld,\"opcodes\":[", (long)(time(NULL) - startTime));
+  else appendf(out, "Uptime %ld s\nOpcodes (times in us):\n", (long)(time(NULL) - startTime));
+
+  bool first = true;
+  for (ULONG op = 0; op <= (MAX_OPCODE + 1); op++)
+  {
+    OpcodeStats& o = opcodes[op];
+    if (!o.requests && !o.cancelled && !o.send.count) continue;
+
+    if (json)
+    {
+      if (!first) out += ",";
+      if (op > MAX_OPCODE) appendf(out, "{\"opcode\":\"other\",");
+      else appendf(out, "{\"opcode\":%lu,", (unsigned long)op);
+      appendf(out, "\"requests\":%llu,\"errors\":%llu,\"cancelled\":%llu,\"bytes_out\":%llu,",
+              (unsigned long long)o.requests, (unsigned long long)o.errors,
+              (unsigned long long)o.cancelled, (unsigned long long)o.bytesOut);
+      appendHistogram(out, "queue_wait", o.queueWait, true);
+      out += ",";
+      appendHistogram(out, "processing", o.processing, true);
+      out += ",";
+      appendHistogram(out, "send", o.send, true);
+      out += "}";
+    }
+    else
+    {
+      if (op > MAX_OPCODE) appendf(out, "  op other:");
+      else appendf(out, "  op %lu:", (unsigned long)op);
+      appendf(out, " requests=%llu errors=%llu cancelled=%llu bytes_out=%llu\n", (unsigned long long)o.requests,
+              (unsigned long long)o.errors, (unsigned long long)o.cancelled, (unsigned long long)o.bytesOut);
+      out += "   ";
+      appendHistogram(out, "queue_wait", o.queueWait, false);
+      out += "\n   ";
+      appendHistogram(out, "processing", o.processing, false);
+      out += "\n   ";
+      appendHistogram(out, "send", o.send, false);
+      out += "\n";
+    }
+    first = false;
+  }
+
+  if (json)
+  {
+    out += "],";
+    appendHistogram(out, "recplayer_read", recPlayerReads, true);
+    appendf(out, ",\"recplayer_bytes\":%llu,\"closed\":{\"bytes_in\":%llu,\"bytes_out\":%llu,\"stream_bytes\":%llu,\"ring_drops\":%llu,"
+                 "\"requests\":%llu,\"read_syscalls\":%llu,\"write_syscalls\":%llu},",
+            (unsigned long long)recPlayerBytes, (unsigned long long)closed.bytesIn, (unsigned long long)closed.bytesOut,
+            (unsigned long long)closed.streamBytes, (unsigned long long)closed.ringDrops, (unsigned long long)closed.requests,
+            (unsigned long long)closed.readSyscalls, (unsigned long long)closed.writeSyscalls);
+    out += "\"caches\":{";
+    for (int c = 0; c < NUM_CACHES; c++)
+      appendf(out, "%s\"%s\":{\"hits\":%llu,\"misses\":%llu}", c ? "," : "", cacheNames[c],
+              (unsigned long long)cacheHits[c], (unsigned long long)cacheMisses[c]);
+    out += "},\"lock_holds\":{";
+    for (int l = 0; l < NUM_LOCKS; l++)
+    {
+      if (l) out += ",";
+      appendHistogram(out, lockNames[l], lockHolds[l], true);
+    }
+    out += "},\"clients\":[";
+  }
+  else
+  {
+    out += "RecPlayer:";
+    appendHistogram(out, "read", recPlayerReads, false);
+    appendf(out, " bytes=%llu\n", (unsigned long long)recPlayerBytes);
+    appendf(out, "Closed clients: bytes_in=%llu bytes_out=%llu stream_bytes=%llu ring_drops=%llu requests=%llu read_syscalls=%llu write_syscalls=%llu\n",
+            (unsigned long long)closed.bytesIn, (unsigned long long)closed.bytesOut, (unsigned long long)closed.streamBytes,
+            (unsigned long long)closed.ringDrops, (unsigned long long)closed.requests,
+            (unsigned long long)closed.readSyscalls, (unsigned long long)closed.writeSyscalls);
+    out += "Caches:";
+    for (int c = 0; c < NUM_CACHES; c++)
+      appendf(out, " %s=%llu/%llu", cacheNames[c], (unsigned long long)cacheHits[c],
+              (unsigned long long)(cacheHits[c] + cacheMisses[c]));
+    out += "\nLock holds (us):\n";
+    for (int l = 0; l < NUM_LOCKS; l++)
+    {
+      out += "  ";
+      appendHistogram(out, lockNames[l], lockHolds[l], false);
+      out += "\n";
+    }
+    appendf(out, "Clients: %lu\n", (unsigned long)live.size());
+  }
+
+  first = true;
+  for (std::list<ClientStats>::iterator i = live.begin(); i != live.end(); ++i)
+  {
+    if (json)
+    {
+      if (!first) out += ",";
+      appendf(out, "{\"id\":%lu,\"connected\":%ld,\"bytes_in\":%llu,\"bytes_out\":%llu,\"requests\":%llu,"
+                   "\"stream_bytes\":%llu,\"ring_fill\":%lu,\"ring_size\":%lu,\"ring_drops\":%llu,"
+                   "\"read_syscalls\":%llu,\"write_syscalls\":%llu}",
+              (unsigned long)i->id, (long)(time(NULL) - i->connectedAt),
+              (unsigned long long)i->bytesIn, (unsigned long long)i->bytesOut, (unsigned long long)i->requests,
+              (unsigned long long)i->streamBytes, (unsigned long)i->ringFill, (unsigned long)i->ringSize,
+              (unsigned long long)i->ringDrops,
+              (unsigned long long)i->readSyscalls, (unsigned long long)i->writeSyscalls);
+    }
+    else
+    {
+      appendf(out, "  client %lu: connected=%lds bytes_in=%llu bytes_out=%llu requests=%llu stream_bytes=%llu ring=%lu/%lu ring_drops=%llu"
+                   " read_syscalls=%llu write_syscalls=%llu\n",
+              (unsigned long)i->id, (long)(time(NULL) - i->connectedAt),
+              (unsigned long long)i->bytesIn, (unsigned long long)i->bytesOut, (unsigned long long)i->requests,
+              (unsigned long long)i->streamBytes, (unsigned long)i->ringFill, (unsigned long)i->ringSize,
+              (unsigned long long)i->ringDrops,
+              (unsigned long long)i->readSyscalls, (unsigned long long)i->writeSyscalls);
+    }
+    first = false;
+  }
+
+  if (json) out += "]}";
+  return out;
+}
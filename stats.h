@@ -0,0 +1,195 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <pthread.h>
+#include <time.h>
+#include <list>
+#include <string>
+
+#include "defines.h"
+
+/*
+  Latency histogram with power of two buckets in microseconds. Bucket 0
+  counts samples under 1us, bucket i samples in [2^(i-1), 2^i) us, the last
+  bucket everything above. Updated with atomic adds only, so any thread can
+  record into it without a lock. Readers may see a sample in count before
+  it shows in its bucket, which is fine for monitoring.
+*/
+
+class LatencyHistogram
+{
+  public:
+    LatencyHistogram();
+
+    void add(ULLONG us);
+    ULLONG percentile(double fraction) const; // upper bound of the bucket, in us
+
+    const static int NUM_BUCKETS = 32;
+    static ULLONG bucketLimit(int bucket);    // upper bound of a bucket, in us
+
+    ULLONG count;
+    ULLONG sumUs;
+    ULLONG maxUs;
+    ULLONG buckets[NUM_BUCKETS];
+};
+
+struct OpcodeStats
+{
+  OpcodeStats() : requests(0), errors(0), cancelled(0), bytesOut(0) {}
+
+  ULLONG requests;
+  ULLONG errors;      // handler returned failure
+  ULLONG cancelled;
+  ULLONG bytesOut;
+  LatencyHistogram queueWait;  // read off the socket -> handler starts
+  LatencyHistogram processing; // handler
+  LatencyHistogram send;       // handed to the send queue -> written to the socket
+};
+
+/*
+  Times a VDR lock from where it is declared to the end of its scope.
+  Declare it right after taking the lock: waiting for the lock is then
+  not counted, and it is destroyed just before the lock is released.
+*/
+
+class LockHoldTimer
+{
+  public:
+    LockHoldTimer(int tlock);
+    ~LockHoldTimer();
+
+  private:
+    int lock;
+    ULLONG start;
+};
+
+/*
+  Per connection counters. Created by Stats::registerClient and owned by
+  Stats, the client calls unregisterClient when it goes away.
+*/
+
+struct ClientStats
+{
+  ULONG id;
+  time_t connectedAt;
+  ULLONG bytesIn;
+  ULLONG bytesOut;
+  ULLONG requests;
+  ULLONG streamBytes;  // live TV payload sent
+  ULLONG readSyscalls;  // select() + read() to get requests in
+  ULLONG writeSyscalls; // select() + sendmsg() to get replies and stream data out
+  ULLONG ringDrops;    // live TV bytes overwritten in the receiver ringbuffer
+  ULONG ringFill;      // current receiver ringbuffer content
+  ULONG ringSize;      // 0 when not streaming live TV
+};
+
+class Stats
+{
+  public:
+    Stats();
+    ~Stats();
+    static Stats* getInstance();
+
+    static ULLONG nowUs(); // monotonic clock
+
+    // Opcodes above MAX_OPCODE (e.g. 666 shutdown) are counted together
+    const static ULONG MAX_OPCODE = 63;
+    const static ULONG NO_OPCODE = 0xFFFFFFFF; // packet is not a RR response
+    OpcodeStats* getOpcodeStats(ULONG opcode);
+
+    void requestProcessed(ULONG opcode, ULLONG queueWaitUs, ULLONG processingUs, bool ok);
+    void requestCancelled(ULONG opcode);
+    void responseSent(ULONG opcode, ULONG bytes, ULLONG sendUs);
+    void recPlayerRead(ULONG bytes, ULLONG us);
+
+    // Caches and object pools report hits and misses here
+    const static int CACHE_RESPONSE_POOL = 0;
+    const static int CACHE_REQUEST_POOL = 1;
+    const static int CACHE_I18N = 2;
+    const static int CACHE_CHARSETCONV = 3;
+    const static int CACHE_EPGINDEX = 4;
+    const static int NUM_CACHES = 5;
+    static const char* cacheNames[NUM_CACHES];
+    void cacheHit(int cache) { add(&cacheHits[cache], 1); }
+    void cacheMiss(int cache) { add(&cacheMisses[cache], 1); }
+    ULLONG cacheHits[NUM_CACHES];
+    ULLONG cacheMisses[NUM_CACHES];
+
+    // How long request handlers hold VDR's global list locks
+    const static int LOCK_RECORDINGS = 0;
+    const static int LOCK_CHANNELS = 1;
+    const static int LOCK_SCHEDULES = 2;
+    const static int LOCK_TIMERS = 3;
+    const static int NUM_LOCKS = 4;
+    static const char* lockNames[NUM_LOCKS];
+    void lockHeld(int lock, ULLONG us) { lockHolds[lock].add(us); }
+    LatencyHistogram lockHolds[NUM_LOCKS];
+
+    ClientStats* registerClient();
+    void unregisterClient(ClientStats* client);
+
+    std::string dump(bool json);
+
+    static void add(ULLONG* counter, ULLONG amount) { __sync_fetch_and_add(counter, amount); }
+    static void set(ULONG* gauge, ULONG value) { __sync_lock_test_and_set(gauge, value); }
+
+    // Totals for clients that have disconnected, so rates survive reconnects.
+    // Changed with clientsLock held, read them through getClients()
+    ULLONG closedBytesIn;
+    ULLONG closedBytesOut;
+    ULLONG closedStreamBytes;
+    ULLONG closedRingDrops;
+    ULLONG closedRequests;
+    ULLONG closedReadSyscalls;
+    ULLONG closedWriteSyscalls;
+    LatencyHistogram recPlayerReads;
+    ULLONG recPlayerBytes;
+    time_t startTime;
+
+    // Copies of the live client counters for reporting, and if closed is
+    // given the closed* totals from the same moment, so a client that goes
+    // meanwhile is counted exactly once
+    void getClients(std::list<ClientStats>& result, ClientStats* closed = NULL);
+
+  private:
+    static Stats* instance;
+
+    OpcodeStats opcodes[MAX_OPCODE + 2]; // last one is "other"
+
+    pthread_mutex_t clientsLock;
+    std::list<ClientStats*> clients;
+    ULONG nextClientID;
+};
+
+#endif
+
+/*
+
+Documentation
+-------------
+
+Like Log, this class is instantiated once by MVPServer and is then
+available to everything through Stats::getInstance(). The SVDRP command
+STAT dumps it, STAT JSON does the same as JSON.
+
+*/
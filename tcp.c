@@ -29,6 +29,13 @@ TCP::TCP(int tsocket)
   readTimeoutEnabled = 1;
   pthread_mutex_init(&sendLock, NULL);
 
+  recvBuffer = (UCHAR*)malloc(RECV_BUFFER_SIZE);
+  recvStart = 0;
+  recvEnd = 0;
+  readSyscalls = 0;
+  writeSyscalls = 0;
+  clientStats = NULL;
+
   if (tsocket)
   {
     sock = tsocket;
@@ -39,6 +46,7 @@ TCP::TCP(int tsocket)
 TCP::~TCP()
 {
   if (connected) cleanup();
+  free(recvBuffer);
 }
 
 void TCP::cleanup()
@@ -165,14 +173,25 @@ int TCP::getDataLength()
   return dataLength;
 }
 
-int TCP::readData(UCHAR* buffer, int totalBytes)
+void TCP::countReadSyscall()
 {
-  if (!connected) return 0;
+  ++readSyscalls;
+  if (clientStats) Stats::add(&clientStats->readSyscalls, 1);
+}
+
+void TCP::countWriteSyscall()
+{
+  ++writeSyscalls;
+  if (clientStats) Stats::add(&clientStats->writeSyscalls, 1);
+}
+
+int TCP::fillBuffer()
+{
+  // Only called when the buffer is empty. Waits for data then reads
+  // as much as is available in one go.
 
-  int bytesRead = 0;
-  int thisRead;
-  int readTries = 0;
   int success;
+  int thisRead;
   fd_set readSet;
   struct timeval timeout;
   struct timeval* passToSelect;
@@ -180,21 +199,34 @@ int TCP::readData(UCHAR* buffer, int totalBytes)
   if (readTimeoutEnabled) passToSelect = &timeout;
   else passToSelect = NULL;
 
+  recvStart = 0;
+  recvEnd = 0;
+
   while(1)
   {
     FD_ZERO(&readSet);
     FD_SET(sock, &readSet);
     timeout.tv_sec = 20;
     timeout.tv_usec = 0;
+    countReadSyscall();
     success = select(sock + 1, &readSet, NULL, NULL, passToSelect);
     if (success < 1)
     {
+      if ((success == -1) && (errno == EINTR)) continue;
 //      cleanup();
       log->log("TCP", Log::DEBUG, "Select finished with %i", success);
       return 0;  // error, or timeout
     }
 
-    thisRead = read(sock, &buffer[bytesRead], totalBytes - bytesRead);
+    countReadSyscall();
+    thisRead = read(sock, recvBuffer, RECV_BUFFER_SIZE);
+    if (thisRead == -1)
+    {
+      if ((errno == EINTR) || (errno == EAGAIN)) continue;
+      log->log("TCP", Log::DEBUG, "Read error %i", errno);
+      cleanup();
+      return 0;
+    }
     if (!thisRead)
     {
       // if read returns 0 then connection is closed
@@ -203,26 +235,59 @@ int TCP::readData(UCHAR* buffer, int totalBytes)
       cleanup();
       return 0;
     }
-    bytesRead += thisRead;
+
+    recvEnd = thisRead;
+    return 1;
+  }
+}
+
+int TCP::readData(UCHAR* buffer, int totalBytes)
+{
+  if (!connected && (recvStart == recvEnd)) return 0;
+
+  int bytesRead = 0;
+  int available;
+  int readTries = 0;
+
+  while(1)
+  {
+    available = recvEnd - recvStart;
+    if (available)
+    {
+      if (available > (totalBytes - bytesRead)) available = totalBytes - bytesRead;
+      memcpy(&buffer[bytesRead], &recvBuffer[recvStart], available);
+      recvStart += available;
+      bytesRead += available;
+    }
 
 //    log->log("TCP", Log::DEBUG, "Bytes read now: %u", bytesRead);
     if (bytesRead == totalBytes)
     {
       return 1;
     }
-    else
+
+    if (!connected) return 0;
+
+    if (++readTries == 100)
     {
-      if (++readTries == 100)
-      {
-        cleanup();
-        log->log("TCP", Log::DEBUG, "too many reads");
-        return 0;
-      }
+      cleanup();
+      log->log("TCP", Log::DEBUG, "too many reads");
+      return 0;
     }
+
+    if (!fillBuffer()) return 0;
   }
 }
 
 int TCP::sendPacket(UCHAR* buf, size_t count)
+{
+  struct iovec iov;
+  iov.iov_base = buf;
+  iov.iov_len = count;
+  return sendPacketV(&iov, 1, 0);
+}
+
+int TCP::sendPacketV(struct iovec* iov, int iovcnt, int more)
 {
   pthread_mutex_lock(&sendLock);
   
@@ -232,12 +297,29 @@ int TCP::sendPacket(UCHAR* buf, size_t count)
     return 0;
   }
 
-  unsigned int bytesWritten = 0;
   int thisWrite;
   int writeTries = 0;
   int success;
+  int flags = MSG_NOSIGNAL;
   fd_set writeSet;
   struct timeval timeout;
+  struct msghdr msg;
+
+#ifdef MSG_MORE
+  if (more) flags |= MSG_MORE;
+#endif
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+
+  // Skip empty buffers at the front so a zero length packet sends nothing
+  while (msg.msg_iovlen && !msg.msg_iov->iov_len) { msg.msg_iov++; msg.msg_iovlen--; }
+  if (!msg.msg_iovlen)
+  {
+    pthread_mutex_unlock(&sendLock);
+    return 1;
+  }
 
   while(1)
   {
@@ -245,17 +327,28 @@ int TCP::sendPacket(UCHAR* buf, size_t count)
     FD_SET(sock, &writeSet);
     timeout.tv_sec = 10;
     timeout.tv_usec = 0;
+    countWriteSyscall();
     success = select(sock + 1, NULL, &writeSet, NULL, &timeout);
     if (success < 1)
     {
+      if ((success == -1) && (errno == EINTR)) continue;
       cleanup();
       log->log("TCP", Log::DEBUG, "TCP: error or timeout");
       pthread_mutex_unlock(&sendLock);
       return 0;  // error, or timeout
     }
 
-    thisWrite = write(sock, &buf[bytesWritten], count - bytesWritten);
+    countWriteSyscall();
+    thisWrite = sendmsg(sock, &msg, flags);
 //  log->log("TCP", Log::DEBUG, "written %i", thisWrite);
+    if (thisWrite == -1)
+    {
+      if ((errno == EINTR) || (errno == EAGAIN)) continue;
+      cleanup();
+      log->log("TCP", Log::DEBUG, "Write error %i", errno);
+      pthread_mutex_unlock(&sendLock);
+      return 0;
+    }
     if (!thisWrite)
     {
       // if write returns 0 then connection is closed ?
@@ -266,10 +359,22 @@ int TCP::sendPacket(UCHAR* buf, size_t count)
       pthread_mutex_unlock(&sendLock);      
       return 0;
     }
-    bytesWritten += thisWrite;
 
-//    log->log("TCP", Log::DEBUG, "Bytes written now: %u", bytesWritten);
-    if (bytesWritten == count)
+    // Step over whatever was written
+    size_t written = thisWrite;
+    while (msg.msg_iovlen && (written >= msg.msg_iov->iov_len))
+    {
+      written -= msg.msg_iov->iov_len;
+      msg.msg_iov++;
+      msg.msg_iovlen--;
+    }
+    if (msg.msg_iovlen)
+    {
+      msg.msg_iov->iov_base = (UCHAR*)msg.msg_iov->iov_base + written;
+      msg.msg_iov->iov_len -= written;
+    }
+
+    if (!msg.msg_iovlen)
     {
       pthread_mutex_unlock(&sendLock);
       return 1;
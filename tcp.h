@@ -32,6 +32,7 @@
 #include <netinet/tcp.h>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
@@ -39,6 +40,7 @@
 #include <pthread.h>
 
 #include "log.h"
+#include "stats.h"
 
 
 typedef unsigned char UCHAR;
@@ -59,12 +61,19 @@ class TCP
 
     int connectTo(char *host, unsigned short port);
     int sendPacket(UCHAR*, size_t size);
+    // Gather write of iovcnt buffers as one packet. The iov array is used as
+    // scratch space and is modified. If more is set the kernel is told more
+    // data follows straight away (MSG_MORE) so small packets get coalesced.
+    int sendPacketV(struct iovec* iov, int iovcnt, int more);
 //    UCHAR* receivePacket();
     int readData(UCHAR* buffer, int totalBytes);
     
     // Get methods
     int isConnected();
     int getDataLength();
+    unsigned long getReadSyscalls() { return readSyscalls; }
+    unsigned long getWriteSyscalls() { return writeSyscalls; }
+    void setClientStats(ClientStats* tclientStats) { clientStats = tclientStats; } // syscalls are counted there too
 
     static void dump(unsigned char* data, USHORT size);
     static UCHAR dcc(UCHAR c);
@@ -76,7 +85,22 @@ class TCP
     int readTimeoutEnabled;
     int dataLength;
     pthread_mutex_t sendLock;
-    
+
+    // Inbound buffer. readData is served from here and only goes to the
+    // socket when it is empty, then takes everything that is available,
+    // so pipelined requests cost no extra syscalls.
+    const static int RECV_BUFFER_SIZE = 65536;
+    UCHAR* recvBuffer;
+    int recvStart;
+    int recvEnd;
+    unsigned long readSyscalls; // select() + read() calls made by readData
+    unsigned long writeSyscalls; // select() + sendmsg() calls made by sendPacketV
+    ClientStats* clientStats;
+
+    void countReadSyscall();
+    void countWriteSyscall();
+
+    int fillBuffer();
     void cleanup();
 };
 
@@ -49,7 +49,12 @@ int Thread::threadStart()
   pthread_mutex_init(&threadCondMutex, NULL);
 
   threadActive = 1;
-  if (pthread_create(&pthread, NULL, (void*(*)(void*))threadInternalStart, (void *)this) == -1) return 0;
+  // pthread_create returns an error number, not -1
+  if (pthread_create(&pthread, NULL, (void*(*)(void*))threadInternalStart, (void *)this) != 0)
+  {
+    threadActive = 0;
+    return 0;
+  }
   return 1;
 }
 
@@ -96,6 +101,11 @@ void Thread::threadWaitForSignal()
   pthread_cond_wait(&threadCond, &threadCondMutex);
 }
 
+void Thread::threadWaitForSignalTimed(struct timespec* ts)
+{
+  pthread_cond_timedwait(&threadCond, &threadCondMutex, ts);
+}
+
 void Thread::threadDetach()
 {
   pthread_detach(pthread);
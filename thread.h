@@ -23,6 +23,7 @@
 
 #include <pthread.h>
 #include <signal.h>
+#include <time.h>
 
 class Thread
 {
@@ -42,6 +43,7 @@ class Thread
     // Methods to use from inside the thread
     void threadCheckExit();      // terminates thread if threadStop() has been called
     void threadWaitForSignal();  // pauses thread until threadSignal() is called
+    void threadWaitForSignalTimed(struct timespec*); // same, or until the absolute CLOCK_REALTIME time given
     void threadDetach();         // Detaches the thread
     void threadLock();           // locks the mutex used for internal cond/signal stuff
     void threadUnlock();         // unlocks.
@@ -0,0 +1,193 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+#include "trace.h"
+#include "log.h"
+#include "stats.h"
+
+static const char magic[8] = { 'V', 'O', 'M', 'P', 'T', 'R', 'C', '1' };
+static const ULONG recordHeaderLength = 1 + 8 + 4 + 4 + 4;
+
+static void putULONG(UCHAR* p, ULONG v)
+{
+  v = htonl(v);
+  memcpy(p, &v, 4);
+}
+
+static void putULLONG(UCHAR* p, ULLONG v)
+{
+  putULONG(p, (ULONG)(v >> 32));
+  putULONG(p + 4, (ULONG)v);
+}
+
+static ULONG getULONG(const UCHAR* p)
+{
+  ULONG v;
+  memcpy(&v, p, 4);
+  return ntohl(v);
+}
+
+static ULLONG getULLONG(const UCHAR* p)
+{
+  return ((ULLONG)getULONG(p) << 32) | getULONG(p + 4);
+}
+
+RequestTrace::RequestTrace()
+{
+  file = NULL;
+  startUs = 0;
+  pthread_mutex_init(&lock, NULL);
+}
+
+RequestTrace::~RequestTrace()
+{
+  close();
+  pthread_mutex_destroy(&lock);
+}
+
+int RequestTrace::open(const char* dir, ULONG clientID)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  struct tm tm;
+  localtime_r(&tv.tv_sec, &tm);
+
+  char fileName[PATH_MAX];
+  snprintf(fileName, sizeof(fileName), "%s/vomp-%04i%02i%02i-%02i%02i%02i-%lu.trace", dir,
+           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, (unsigned long)clientID);
+
+  FILE* f = fopen(fileName, "w");
+  if (!f)
+  {
+    Log::getInstance()->log("Trace", Log::ERR, "Could not open %s: %s", fileName, strerror(errno));
+    return 0;
+  }
+
+  UCHAR header[sizeof(magic) + 4 + 8];
+  memcpy(header, magic, sizeof(magic));
+  putULONG(header + sizeof(magic), VERSION);
+  putULLONG(header + sizeof(magic) + 4, (ULLONG)tv.tv_sec * 1000000 + tv.tv_usec);
+  if (fwrite(header, sizeof(header), 1, f) != 1)
+  {
+    fclose(f);
+    return 0;
+  }
+
+  pthread_mutex_lock(&lock);
+  file = f;
+  startUs = Stats::nowUs();
+  pthread_mutex_unlock(&lock);
+
+  Log::getInstance()->log("Trace", Log::DEBUG, "Tracing to %s", fileName);
+  return 1;
+}
+
+void RequestTrace::close()
+{
+  pthread_mutex_lock(&lock);
+  if (file)
+  {
+    fclose(file);
+    file = NULL;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void RequestTrace::request(ULONG requestID, ULONG opcode, const UCHAR* data, ULONG length)
+{
+  if (!file) return;
+  writeRecord(TYPE_REQUEST, requestID, opcode, length, data);
+}
+
+void RequestTrace::response(ULONG requestID, ULONG opcode, ULONG length)
+{
+  if (!file) return;
+  writeRecord(TYPE_RESPONSE, requestID, opcode, length, NULL);
+}
+
+void RequestTrace::writeRecord(UCHAR type, ULONG requestID, ULONG opcode, ULONG length, const UCHAR* data)
+{
+  UCHAR header[recordHeaderLength];
+  header[0] = type;
+  putULONG(header + 9, requestID);
+  putULONG(header + 13, opcode);
+  putULONG(header + 17, length);
+
+  pthread_mutex_lock(&lock);
+  if (file)
+  {
+    putULLONG(header + 1, Stats::nowUs() - startUs);
+    bool ok = (fwrite(header, sizeof(header), 1, file) == 1);
+    if (ok && data && length) ok = (fwrite(data, length, 1, file) == 1);
+    if (!ok)
+    {
+      // Disk full or similar, stop rather than leave a torn file growing
+      Log::getInstance()->log("Trace", Log::ERR, "Trace write failed, tracing stopped");
+      fclose(file);
+      file = NULL;
+    }
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+int RequestTrace::load(const char* fileName, std::vector<TraceRecord>& records)
+{
+  FILE* f = fopen(fileName, "r");
+  if (!f) return 0;
+
+  UCHAR header[sizeof(magic) + 4 + 8];
+  if ((fread(header, sizeof(header), 1, f) != 1) || memcmp(header, magic, sizeof(magic))
+      || (getULONG(header + sizeof(magic)) != VERSION))
+  {
+    fclose(f);
+    return 0;
+  }
+
+  UCHAR recordHeader[recordHeaderLength];
+  while (fread(recordHeader, sizeof(recordHeader), 1, f) == 1)
+  {
+    TraceRecord r;
+    r.type = recordHeader[0];
+    r.timeUs = getULLONG(recordHeader + 1);
+    r.requestID = getULONG(recordHeader + 9);
+    r.opcode = getULONG(recordHeader + 13);
+    r.length = getULONG(recordHeader + 17);
+    if (r.type == TYPE_REQUEST)
+    {
+      if (r.length > 200000) break; // as vompclient, anything bigger is corrupt
+      r.data.resize(r.length);
+      if (r.length && (fread(&r.data[0], r.length, 1, f) != 1)) break; // torn last record
+    }
+    else if (r.type != TYPE_RESPONSE)
+    {
+      break;
+    }
+    records.push_back(r);
+  }
+  fclose(f);
+  return 1;
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Binary capture of one client connection for replay with vompreplay.
+
+  Enabled with "Trace directory" in vomp.conf. Every connection then writes
+  <dir>/vomp-<date>-<time>-<client>.trace holding each request as received
+  (time, request ID, opcode and the full payload) and the size of each RR
+  reply as it is queued. Stream, picture and keepalive traffic is not
+  recorded; the requests that cause it are.
+
+  All fields are big endian, like the protocol:
+
+    file header  "VOMPTRC1", ULONG version, ULLONG wall clock start (us)
+    record       UCHAR type, ULLONG time since start (us),
+                 ULONG requestID, ULONG opcode, ULONG length,
+                 then length bytes of payload for TYPE_REQUEST only
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <vector>
+
+#include "defines.h"
+
+struct TraceRecord
+{
+  UCHAR type;
+  ULLONG timeUs;
+  ULONG requestID;
+  ULONG opcode;
+  ULONG length;
+  std::vector<UCHAR> data; // requests only
+};
+
+class RequestTrace
+{
+  public:
+    RequestTrace();
+    ~RequestTrace();
+
+    int open(const char* dir, ULONG clientID);
+    void close();
+    bool isOpen() { return file != NULL; }
+
+    // Both are no-ops unless open. Safe to call from any thread.
+    void request(ULONG requestID, ULONG opcode, const UCHAR* data, ULONG length);
+    void response(ULONG requestID, ULONG opcode, ULONG length);
+
+    // Reads a whole trace file, returns 1 on success
+    static int load(const char* fileName, std::vector<TraceRecord>& records);
+
+    const static ULONG VERSION = 1;
+    const static UCHAR TYPE_REQUEST = 1;
+    const static UCHAR TYPE_RESPONSE = 2;
+
+  private:
+    void writeRecord(UCHAR type, ULONG requestID, ULONG opcode, ULONG length, const UCHAR* data);
+
+    FILE* file;
+    ULLONG startUs;
+    pthread_mutex_t lock;
+};
+
+#endif
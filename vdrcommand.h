@@ -79,6 +79,13 @@ const static ULONG VDR_LOADTVMEDIARECTHUMB  =42;
 const static ULONG VDR_GETEVENTSCRAPEREVENTTYPE = 43;
 const static ULONG VDR_LOADTVMEDIAEVENTTHUMB  =44;
 const static ULONG VDR_LOADCHANNELLOGO = 45;
+const static ULONG VDR_CANCELREQUESTS = 46;
+const static ULONG VDR_CONFIGLOADBATCH = 47;
+const static ULONG VDR_CONFIGSAVEBATCH = 48;
+const static ULONG VDR_GETEPGGRID = 49;
+const static ULONG VDR_GETEPGGRIDHEADERS = 50;
+const static ULONG VDR_GETEVENTDESCRIPTIONS = 51;
+const static ULONG VDR_GETEPGGRIDSYNC = 52;
 
 const static ULONG VDR_SHUTDOWN            = 666;
 
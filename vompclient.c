@@ -66,16 +66,33 @@ VompClient::VompClient(Config* cfgBase, char* tconfigDir, char* tlogoDir,
   mediaprovider=new ServerMediaFile(cfgBase,media);
   netLogFile = NULL;
   charcoding=1; //latin1 is default
-  charconvsys=NULL;
-  charconvutf8=NULL;
-  setCharset(charcoding);
+  clientStats = Stats::getInstance()->registerClient();
+
+  pthread_mutex_init(&dispatchLock, NULL);
+  pthread_cond_init(&parallelIdleCond, NULL);
+  parallelInFlight = 0;
+  barriersPending = 0;
+  nextParallel = 0;
   
   rrproc.init();
+  for (int i = 0; i < NUM_PARALLEL_RRPROC; i++)
+  {
+    parallelRRProc[i] = new VompClientRRProc(*this, true);
+    parallelRRProc[i]->init();
+  }
 }
 
 VompClient::~VompClient()
 {
   log->log("Client", Log::DEBUG, "Vomp client destructor");
+
+  // Stop the sender and drop what is queued first. Queued replies go back
+  // to the response pools of the RR workers, so those must still exist.
+  // Nothing can write to the socket after this, anything sent from here
+  // on is released straight away
+  sendQueue.shutdown();
+
+  for (int i = 0; i < NUM_PARALLEL_RRPROC; i++) delete parallelRRProc[i];
 #ifndef VOMPSTANDALONE  
   if (lp)
   {
@@ -99,15 +116,14 @@ VompClient::~VompClient()
   delete media;
   delete mediaprovider;
 
-  if (charconvsys) delete charconvsys;
-  if (charconvutf8) delete charconvutf8;
-
   
   if (netLogFile)
   {
     fclose(netLogFile);
     netLogFile = NULL;
   }
+
+  Stats::getInstance()->unregisterClient(clientStats);
 }
 
 cPlugin *VompClient::scrapQuery()
@@ -122,23 +138,89 @@ cPlugin *VompClient::scrapQuery()
 
 void VompClient::setCharset(int charset)
 {
-   charcoding=charset;
-   cCharSetConv *oldcharconvsys=charconvsys;
-   cCharSetConv *oldcharconvutf8=charconvutf8;
-   switch (charcoding) {
-   case 2: //UTF-8
-   charconvsys=new cCharSetConv(NULL,"UTF-8");
-   charconvutf8=new cCharSetConv("UTF-8","UTF-8");
-   break;
-   case 1:
-   default://latin1
-   charconvsys=new cCharSetConv(NULL,"ISO-8859-1");
-   charconvutf8=new cCharSetConv("UTF-8","ISO-8859-1");
-   break;
-   };
-   if (oldcharconvsys) delete oldcharconvsys;
-   if (oldcharconvutf8) delete oldcharconvutf8;
+  // The rrprocs pick this up before their next request
+  charcoding=charset;
+}
+
+void VompClient::dispatchRequest(RequestPacket* req)
+{
+  if (req->opcode == VDR_CANCELREQUESTS)
+  {
+    // Handled here straight away, queueing it would defeat the point
+    cancelRequests(req);
+    return;
+  }
+
+  int opClass = VompClientRRProc::classifyOpcode(req->opcode);
+  VompClientRRProc* worker = &rrproc;
+
+  pthread_mutex_lock(&dispatchLock);
+  if (opClass == VompClientRRProc::OPCLASS_BARRIER)
+  {
+    barriersPending++;
+  }
+  else if ((opClass == VompClientRRProc::OPCLASS_INDEPENDENT) && !barriersPending)
+  {
+    worker = parallelRRProc[nextParallel];
+    nextParallel = (nextParallel + 1) % NUM_PARALLEL_RRPROC;
+    parallelInFlight++;
+  }
+  // else serial, or independent but queued behind a barrier
+  pthread_mutex_unlock(&dispatchLock);
+
+  worker->recvRequest(req);
+}
+
+void VompClient::cancelRequests(RequestPacket* req)
+{
+  int cancelled = 0;
+
+  if (req->dataLength >= (sizeof(ULONG) * 2))
+  {
+    ULONG mode = ntohl(*(ULONG*)&req->data[0]);
+    ULONG requestID = ntohl(*(ULONG*)&req->data[4]);
+
+    cancelled = rrproc.cancelQueued(mode, requestID);
+    for (int i = 0; i < NUM_PARALLEL_RRPROC; i++)
+      cancelled += parallelRRProc[i]->cancelQueued(mode, requestID);
+
+    log->log("Client", Log::DEBUG, "Cancel mode %lu id %lu, %i requests dropped", mode, requestID, cancelled);
+  }
+
+  ResponsePacket* resp = new ResponsePacket();
+  if (resp->init(req->requestID))
+  {
+    resp->addULONG(cancelled);
+    resp->finalise();
+    sendQueue.sendResponse(resp, VDR_CANCELREQUESTS);
+  }
+  else
+  {
+    delete resp;
+  }
+
+  req->release();
+}
+
+void VompClient::waitForParallelIdle()
+{
+  pthread_mutex_lock(&dispatchLock);
+  while (parallelInFlight) pthread_cond_wait(&parallelIdleCond, &dispatchLock);
+  pthread_mutex_unlock(&dispatchLock);
+}
 
+void VompClient::parallelRequestDone()
+{
+  pthread_mutex_lock(&dispatchLock);
+  if (!--parallelInFlight) pthread_cond_broadcast(&parallelIdleCond);
+  pthread_mutex_unlock(&dispatchLock);
+}
+
+void VompClient::barrierDone()
+{
+  pthread_mutex_lock(&dispatchLock);
+  barriersPending--;
+  pthread_mutex_unlock(&dispatchLock);
 }
 
 void VompClient::incClients()
@@ -256,19 +338,29 @@ void VompClient::run2()
 //  tcp.setSoKeepTime(3);
   tcp.setNonBlocking();
 
-  pict->init(&tcp);
+  char* traceDir = baseConfig->getValueString("General", "Trace directory");
+  if (traceDir)
+  {
+    if (trace.open(traceDir, clientStats->id)) sendQueue.setTrace(&trace);
+    delete[] traceDir;
+  }
+
+  tcp.setClientStats(clientStats);
+  sendQueue.init(&tcp, clientStats);
+  pict->init(&sendQueue);
   ULONG channelID;
   ULONG requestID;
   ULONG opcode;
   ULONG extraDataLength;
-  UCHAR* data;
+  ULONG rrHeader[3];
+  ULONG numRequests = 0;
   
   ULONG kaTimeStamp;
   ULONG logStringLen;
 
   while(1)
   {
-    log->log("Client", Log::DEBUG, "Waiting");
+    LOG("Client", Log::DEBUG, "Waiting");
     
     if (!tcp.readData((UCHAR*)&channelID, sizeof(ULONG)))
     {
@@ -285,65 +377,60 @@ void VompClient::run2()
     channelID = ntohl(channelID);
     if (channelID == 1)
     {
-      if (!tcp.readData((UCHAR*)&requestID, sizeof(ULONG))) break;
-      requestID = ntohl(requestID);
-
-      if (!tcp.readData((UCHAR*)&opcode, sizeof(ULONG))) break;
-      opcode = ntohl(opcode);
-
-      if (!tcp.readData((UCHAR*)&extraDataLength, sizeof(ULONG))) break;
-      extraDataLength = ntohl(extraDataLength);
+      // requestID, opcode, extraDataLength
+      if (!tcp.readData((UCHAR*)rrHeader, sizeof(rrHeader))) break;
+      requestID = ntohl(rrHeader[0]);
+      opcode = ntohl(rrHeader[1]);
+      extraDataLength = ntohl(rrHeader[2]);
       if (extraDataLength > 200000) // a random sanity limit
       {
         log->log("Client", Log::ERR, "ExtraDataLength > 200000!");
         break;
       }
 
-      if (extraDataLength)
+      RequestPacket* req = requestPool.get(requestID, opcode, extraDataLength);
+      if (!req)
       {
-        data = (UCHAR*)malloc(extraDataLength);
-        if (!data)
-        {
-          log->log("Client", Log::ERR, "Extra data buffer malloc error");
-          break;
-        }
-        
-        if (!tcp.readData(data, extraDataLength))
-        {
-          log->log("Client", Log::ERR, "Could not read extradata");
-          free(data);
-          break;
-        }      
+        log->log("Client", Log::ERR, "Request packet alloc error");
+        break;
       }
-      else
+
+      if (extraDataLength && !tcp.readData(req->data, extraDataLength))
       {
-        data = NULL;
+        log->log("Client", Log::ERR, "Could not read extradata");
+        req->release();
+        break;
       }
 
-      log->log("Client", Log::DEBUG, "Received chan=%lu, ser=%lu, op=%lu, edl=%lu", channelID, requestID, opcode, extraDataLength);
+      LOG("Client", Log::DEBUG, "Received chan=%lu, ser=%lu, op=%lu, edl=%lu", channelID, requestID, opcode, extraDataLength);
 
       if (!loggedIn && (opcode != 1))
       {
         log->log("Client", Log::ERR, "Not logged in and opcode != 1");
-        if (data) free(data);
+        req->release();
         break;
       }
 
-      RequestPacket* req = new RequestPacket(requestID, opcode, data, extraDataLength);
-      rrproc.recvRequest(req);
+      ++numRequests;
+      trace.request(requestID, opcode, req->data, extraDataLength);
+      req->receivedUs = Stats::nowUs();
+      Stats::add(&clientStats->requests, 1);
+      Stats::add(&clientStats->bytesIn, (sizeof(ULONG) * 4) + extraDataLength);
+      dispatchRequest(req);
     }
     else if (channelID == 3)
     {
       if (!tcp.readData((UCHAR*)&kaTimeStamp, sizeof(ULONG))) break;
       kaTimeStamp = ntohl(kaTimeStamp);
+      Stats::add(&clientStats->bytesIn, sizeof(ULONG) * 2);
 
-      log->log("Client", Log::DEBUG, "Received chan=%lu kats=%lu", channelID, kaTimeStamp);    
+      LOG("Client", Log::DEBUG, "Received chan=%lu kats=%lu", channelID, kaTimeStamp);    
 
       ULONG* p;
       UCHAR buffer[8];
       p = (ULONG*)&buffer[0]; *p = htonl(3); // KA CHANNEL
       p = (ULONG*)&buffer[4]; *p = htonl(kaTimeStamp);
-      if (!tcp.sendPacket(buffer, 8))
+      if (!sendQueue.sendPacket(SendQueue::LANE_CONTROL, buffer, 8))
       {
         log->log("Client", Log::ERR, "Could not send back KA reply");
         break;
@@ -359,6 +446,7 @@ void VompClient::run2()
       UCHAR buffer[logStringLen + 1];
       if (!tcp.readData((UCHAR*)&buffer, logStringLen)) break;
       buffer[logStringLen] = '\0';
+      Stats::add(&clientStats->bytesIn, (sizeof(ULONG) * 2) + logStringLen);
 
 //      log->log("Client", Log::INFO, "Client said: '%s'", buffer);
       if (netLogFile)
@@ -368,7 +456,10 @@ void VompClient::run2()
           fclose(netLogFile);
           netLogFile = NULL;
         }
-        fflush(NULL);
+        else
+        {
+          fflush(netLogFile);
+        }
       }
     }    
     else
@@ -377,6 +468,11 @@ void VompClient::run2()
       break;
     }
   }
+
+  unsigned long readSyscalls = tcp.getReadSyscalls();
+  log->log("Client", Log::DEBUG, "Read %lu requests with %lu read syscalls (%.2f per request), %lu write syscalls",
+           (unsigned long)numRequests, readSyscalls, numRequests ? (double)readSyscalls / numRequests : 0.0,
+           tcp.getWriteSyscalls());
 }
 
 ULLONG VompClient::ntohll(ULLONG a)
@@ -53,6 +53,9 @@ class cPlugin;
 
 #include "defines.h"
 #include "tcp.h"
+#include "sendqueue.h"
+#include "stats.h"
+#include "trace.h"
 #include "config.h"
 #include "media.h"
 #include "i18n.h"
@@ -87,7 +90,25 @@ class VompClient
     static ULLONG ntohll(ULLONG a);
     static ULLONG htonll(ULLONG a);
     
+    ClientStats* clientStats;
+    RequestTrace trace; // before sendQueue, which records into it
+    SendQueue sendQueue; // declared before rrproc so that it outlives it
+    RequestPacketPool requestPool; // likewise
     VompClientRRProc rrproc;
+
+    // Request dispatch to rrproc and the parallel workers, see vompclientrrproc.h
+    const static int NUM_PARALLEL_RRPROC = 2;
+    VompClientRRProc* parallelRRProc[NUM_PARALLEL_RRPROC];
+    pthread_mutex_t dispatchLock;
+    pthread_cond_t parallelIdleCond;
+    int parallelInFlight; // independent requests queued or running on parallel workers
+    int barriersPending;  // barrier requests queued or running on rrproc
+    int nextParallel;
+    void dispatchRequest(RequestPacket* req);
+    void cancelRequests(RequestPacket* req);
+    void waitForParallelIdle();
+    void parallelRequestDone();
+    void barrierDone();
     pthread_t runThread;
     int initted;
     Log* log;
@@ -122,9 +143,7 @@ class VompClient
     ServerMediaFile *mediaprovider;
     
     void setCharset(int charset);
-    int charcoding; // 1= latin1 2= UTF-8
-    cCharSetConv *charconvutf8;
-    cCharSetConv *charconvsys;
+    int charcoding; // 1= latin1 2= UTF-8, each rrproc keeps its own converters
     
     
 };
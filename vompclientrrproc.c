@@ -19,6 +19,7 @@
 */
 
 #include <stdlib.h>
+#include <algorithm>
 
 #ifndef VOMPSTANDALONE
 #include <vdr/recording.h>
@@ -30,6 +31,7 @@
 #include <vdr/remote.h>
 #include "recplayer.h"
 #include "mvpreceiver.h"
+#include "epgindex.h"
 #include "services/scraper2vdr.h"
 #endif
 
@@ -42,11 +44,12 @@
 #include "i18n.h"
 #include "vdrcommand.h"
 #include "picturereader.h"
+#include "stats.h"
 
 bool ResumeIDLock;
 
 ULONG VompClientRRProc::VOMP_PROTOCOL_VERSION_MIN = 0x00000301;
-ULONG VompClientRRProc::VOMP_PROTOCOL_VERSION_MAX = 0x00000500;
+ULONG VompClientRRProc::VOMP_PROTOCOL_VERSION_MAX = 0x00000505;
 // format is aabbccdd
 // cc is release protocol version, increase with every release, that changes protocol
 // dd is development protocol version, set to zero at every release, 
@@ -92,6 +95,108 @@ ULONG VompClientRRProc::VOMP_PROTOCOL_VERSION_MAX = 0x00000500;
 
 // TODO: Use VDRs recording->ChangeName(option)) for move recording ?
 
+void RequestPacket::release()
+{
+  if (pool)
+  {
+    pool->put(this);
+    return;
+  }
+  if (data) free(data);
+  delete this;
+}
+
+RequestPacketPool::RequestPacketPool()
+{
+  pthread_mutex_init(&poolLock, NULL);
+}
+
+RequestPacketPool::~RequestPacketPool()
+{
+  for (ULONG i = 0; i < freePackets.size(); i++)
+  {
+    free(freePackets[i]->smallBuffer);
+    delete freePackets[i];
+  }
+  pthread_mutex_destroy(&poolLock);
+}
+
+RequestPacket* RequestPacketPool::get(ULONG requestID, ULONG opcode, ULONG dataLength)
+{
+  RequestPacket* packet = NULL;
+
+  pthread_mutex_lock(&poolLock);
+  if (!freePackets.empty())
+  {
+    packet = freePackets.back();
+    freePackets.pop_back();
+  }
+  pthread_mutex_unlock(&poolLock);
+
+  Stats* stats = Stats::getInstance();
+  if (stats)
+  {
+    if (packet) stats->cacheHit(Stats::CACHE_REQUEST_POOL);
+    else stats->cacheMiss(Stats::CACHE_REQUEST_POOL);
+  }
+
+  if (!packet)
+  {
+    packet = new RequestPacket(0, 0, NULL, 0);
+    packet->pool = this;
+    packet->smallBuffer = (UCHAR*)malloc(smallDataSize + 1);
+    if (!packet->smallBuffer)
+    {
+      delete packet;
+      return NULL;
+    }
+  }
+
+  packet->requestID = requestID;
+  packet->opcode = opcode;
+  packet->dataLength = dataLength;
+
+  if (!dataLength)
+  {
+    packet->data = NULL;
+  }
+  else
+  {
+    if (dataLength <= smallDataSize) packet->data = packet->smallBuffer;
+    else packet->data = (UCHAR*)malloc(dataLength + 1);
+
+    if (!packet->data)
+    {
+      put(packet);
+      return NULL;
+    }
+    packet->data[dataLength] = '\0';
+  }
+
+  return packet;
+}
+
+void RequestPacketPool::put(RequestPacket* packet)
+{
+  if (packet->data && (packet->data != packet->smallBuffer)) free(packet->data);
+  packet->data = NULL;
+  packet->dataLength = 0;
+
+  pthread_mutex_lock(&poolLock);
+  if (freePackets.size() < maxPooled)
+  {
+    freePackets.push_back(packet);
+    packet = NULL;
+  }
+  pthread_mutex_unlock(&poolLock);
+
+  if (packet)
+  {
+    free(packet->smallBuffer);
+    delete packet;
+  }
+}
+
 ULONG VompClientRRProc::getProtocolVersionMin()
 {
   return VOMP_PROTOCOL_VERSION_MIN;
@@ -102,26 +207,106 @@ ULONG VompClientRRProc::getProtocolVersionMax()
   return VOMP_PROTOCOL_VERSION_MAX;
 }
 
-VompClientRRProc::VompClientRRProc(VompClient& x)
+VompClientRRProc::VompClientRRProc(VompClient& x, bool tparallelWorker)
  : x(x)
 {
   log = Log::getInstance();
   req = NULL;
   resp = NULL;
+  parallelWorker = tparallelWorker;
+  failed = false;
+  charcoding = 0;
+  charconvutf8 = NULL;
+  charconvsys = NULL;
 }
 
 VompClientRRProc::~VompClientRRProc()
 {
   threadStop();
+  if (charconvsys) delete charconvsys;
+  if (charconvutf8) delete charconvutf8;
 }
 
 bool VompClientRRProc::init()
 {
   int a = threadStart();
-  sleep(1);
+  if (!parallelWorker) sleep(1);
   return a;
 }
 
+int VompClientRRProc::classifyOpcode(ULONG opcode)
+{
+  switch(opcode)
+  {
+    case VDR_GETRECORDINGLIST:
+    case VDR_GETCHANNELLIST:
+    case VDR_GETCHANNELSCHEDULE:
+    case VDR_GETEPGGRID:
+    case VDR_GETEPGGRIDHEADERS:
+    case VDR_GETEVENTDESCRIPTIONS:
+    case VDR_GETEPGGRIDSYNC:
+    case VDR_CONFIGLOAD:
+    case VDR_CONFIGLOADBATCH:
+    case VDR_GETTIMERS:
+    case VDR_GETRECINFO:
+    case VDR_GETRECINFO2:
+    case VDR_GETMARKS:
+    case VDR_GETCHANNELPIDS:
+    case VDR_LOADTVMEDIA:
+    case VDR_LOADTVMEDIARECTHUMB:
+    case VDR_LOADTVMEDIAEVENTTHUMB:
+    case VDR_LOADCHANNELLOGO:
+      return OPCLASS_INDEPENDENT;
+
+    case VDR_STREAMCHANNEL:
+    case VDR_GETBLOCK:
+    case VDR_STOPSTREAMING:
+    case VDR_STREAMRECORDING:
+    case VDR_RESCANRECORDING:
+    case VDR_POSFROMFRAME:
+    case VDR_FRAMEFROMPOS:
+    case VDR_GETNEXTIFRAME:
+    case VDR_GETMEDIALIST:
+    case VDR_OPENMEDIA:
+    case VDR_GETMEDIABLOCK:
+    case VDR_GETLANGUAGELIST:
+    case VDR_GETLANGUAGECONTENT:
+    case VDR_GETMEDIAINFO:
+    case VDR_CLOSECHANNEL:
+    // These look up and call the scraper plugin through VompClient::scrapQuery(),
+    // which isn't locked, and the plugin's Service() may not be reentrant
+    case VDR_GETRECSCRAPEREVENTTYPE:
+    case VDR_GETEVENTSCRAPEREVENTTYPE:
+    case VDR_GETSCRAPERMOVIEINFO:
+    case VDR_GETSCRAPERSERIESINFO:
+      return OPCLASS_SERIAL;
+
+    default:
+      return OPCLASS_BARRIER;
+  }
+}
+
+void VompClientRRProc::updateCharset()
+{
+  // x.charcoding only changes in a barrier, when no parallel worker is busy
+  if (charcoding == x.charcoding) return;
+  charcoding = x.charcoding;
+
+  if (charconvsys) delete charconvsys;
+  if (charconvutf8) delete charconvutf8;
+  switch (charcoding) {
+  case 2: //UTF-8
+  charconvsys=new CharsetConv(NULL,"UTF-8");
+  charconvutf8=new CharsetConv("UTF-8","UTF-8");
+  break;
+  case 1:
+  default://latin1
+  charconvsys=new CharsetConv(NULL,"ISO-8859-1");
+  charconvutf8=new CharsetConv("UTF-8","ISO-8859-1");
+  break;
+  };
+}
+
 bool VompClientRRProc::recvRequest(RequestPacket* newRequest)
 {
   /*
@@ -133,11 +318,20 @@ bool VompClientRRProc::recvRequest(RequestPacket* newRequest)
      Marten
   */
 
-  log->log("RRProc", Log::DEBUG, "recvReq");
+  LOG("RRProc", Log::DEBUG, "recvReq");
   threadLock();
-  req_queue.push(newRequest);
+  if (failed)
+  {
+    threadUnlock();
+    log->log("RRProc", Log::ERR, "recvReq on failed worker, dropping request");
+    ULONG opcode = newRequest->opcode;
+    newRequest->release();
+    requestFinished(opcode);
+    return false;
+  }
+  req_queue.push_back(newRequest);
   threadSignalNoLock();
-  log->log("RRProc", Log::DEBUG, "recvReq set req and signalled");     
+  LOG("RRProc", Log::DEBUG, "recvReq set req and signalled");     
   threadUnlock();
 
   return true;
@@ -165,13 +359,14 @@ TODO: Work out why this happens.
     {
       //log->log("RRProc", Log::DEBUG, "thread while");
       req = req_queue.front();
-      req_queue.pop();
+      req_queue.pop_front();
       
       threadUnlock(); // allow recvRequest to be queuing packets while we are working on this one
       
-      if (!processPacket())
+      if (!runPacket())
       {
         log->log("RRProc", Log::ERR, "processPacket exited with fail");     
+        failQueued();
         return;
       }
       
@@ -183,30 +378,42 @@ TODO: Work out why this happens.
     
   while(1)  
   {
-    log->log("RRProc", Log::DEBUG, "threadMethod waiting");     
+    if (!threadIsActive())
+    {
+      // threadStop's signal can arrive while we are busy and get lost
+      threadUnlock();
+      failQueued();
+      return;
+    }
+
+    LOG("RRProc", Log::DEBUG, "threadMethod waiting");     
     threadWaitForSignal();  // unlocks, waits, relocks
     if (req_queue.size() == 0)
     {
+      if (threadIsActive()) continue; // spurious wakeup
+
       log->log("RRProc", Log::INFO, "threadMethod err 2 or quit");     
       threadUnlock();
+      failQueued();
       return;
     }
     
     // signalled with something in queue
     
-    log->log("RRProc", Log::DEBUG, "thread woken with req, queue size: %i", req_queue.size());
+    LOG("RRProc", Log::DEBUG, "thread woken with req, queue size: %i", req_queue.size());
 
     while (req_queue.size()) 
     {
       //log->log("RRProc", Log::DEBUG, "thread while");
       req = req_queue.front();
-      req_queue.pop();
+      req_queue.pop_front();
       
       threadUnlock(); // allow recvRequest to be queuing packets while we are working on this one
       
-      if (!processPacket())
+      if (!runPacket())
       {
         log->log("RRProc", Log::ERR, "processPacket exited with fail");     
+        failQueued();
         return;
       }
       
@@ -217,16 +424,122 @@ TODO: Work out why this happens.
   }  
 }
 
+bool VompClientRRProc::runPacket()
+{
+  ULONG opcode = req->opcode;
+  ULLONG receivedUs = req->receivedUs;
+
+  if (!parallelWorker && (classifyOpcode(opcode) == OPCLASS_BARRIER))
+    x.waitForParallelIdle();
+
+  ULLONG startUs = Stats::nowUs();
+  bool result = processPacket();
+  Stats::getInstance()->requestProcessed(opcode, startUs - receivedUs, Stats::nowUs() - startUs, result);
+
+  requestFinished(opcode);
+  return result;
+}
+
+void VompClientRRProc::requestFinished(ULONG opcode)
+{
+  if (parallelWorker) x.parallelRequestDone();
+  else if (classifyOpcode(opcode) == OPCLASS_BARRIER) x.barrierDone();
+}
+
+int VompClientRRProc::cancelQueued(ULONG mode, ULONG requestID)
+{
+  // Only queued requests can be cancelled, one that is already being
+  // processed will still be answered
+  std::vector<RequestPacket*> cancelled;
+
+  threadLock();
+  RequestPacketQueue::iterator i = req_queue.begin();
+  while (i != req_queue.end())
+  {
+    RequestPacket* queued = *i;
+    bool match;
+    if (mode == CANCEL_REQUEST) match = (queued->requestID == requestID);
+    else match = (queued->opcode == VDR_GETBLOCK) && (queued->requestID < requestID);
+
+    if (match)
+    {
+      cancelled.push_back(queued);
+      i = req_queue.erase(i);
+    }
+    else
+    {
+      ++i;
+    }
+  }
+  threadUnlock();
+
+  for (ULONG c = 0; c < cancelled.size(); c++)
+  {
+    ULONG opcode = cancelled[c]->opcode;
+    log->log("RRProc", Log::DEBUG, "Cancelled queued request %lu op %lu", cancelled[c]->requestID, opcode);
+    cancelled[c]->release();
+    Stats::getInstance()->requestCancelled(opcode);
+    requestFinished(opcode);
+  }
+  return cancelled.size();
+}
+
+void VompClientRRProc::failQueued()
+{
+  // This worker is finished. Drop what is queued, and anything that arrives
+  // later, so the dispatch counters don't wait for it forever.
+  threadLock();
+  failed = true;
+  while (req_queue.size())
+  {
+    RequestPacket* dropped = req_queue.front();
+    req_queue.pop_front();
+    ULONG opcode = dropped->opcode;
+    dropped->release();
+    requestFinished(opcode);
+  }
+  threadUnlock();
+}
+
+ULONG VompClientRRProc::responseSizeHint()
+{
+  // Start big replies at roughly the right size instead of growing them
+  switch(req->opcode)
+  {
+    case VDR_GETBLOCK:
+      if (req->dataLength >= (sizeof(ULLONG) + sizeof(ULONG)))
+      {
+        // RecPlayer refuses more than this, so don't allocate for it
+        ULONG amount = ntohl(*(ULONG*)&req->data[sizeof(ULLONG)]);
+        if (amount <= 1000000) return amount + 16;
+      }
+      break;
+    case VDR_GETRECORDINGLIST:
+    case VDR_GETCHANNELLIST:
+    case VDR_GETCHANNELSCHEDULE:
+      return 65536;
+    case VDR_GETEPGGRID:
+      return 262144;
+    case VDR_GETEPGGRIDHEADERS:
+    case VDR_GETEVENTDESCRIPTIONS:
+    case VDR_GETEPGGRIDSYNC:
+      return 65536;
+  }
+  return 0;
+}
+
 bool VompClientRRProc::processPacket()
 {
-  resp = new ResponsePacket();
-  if (!resp->init(req->requestID))
+  updateCharset();
+
+  resp = respPool.get();
+  if (!resp->init(req->requestID, responseSizeHint()))
   {
     log->log("RRProc", Log::ERR, "response packet init fail");     
-    delete resp; 
+    resp->release();
+    resp = NULL;
     
-    if (req->data) free(req->data);
-    delete req;
+    req->release();
     req = NULL;
 
     return false;
@@ -267,6 +580,18 @@ bool VompClientRRProc::processPacket()
     case 10:
       result = processGetChannelSchedule();
       break;
+    case VDR_GETEPGGRID:
+      result = processGetEpgGrid(false);
+      break;
+    case VDR_GETEPGGRIDHEADERS:
+      result = processGetEpgGrid(true);
+      break;
+    case VDR_GETEVENTDESCRIPTIONS:
+      result = processGetEventDescriptions();
+      break;
+    case VDR_GETEPGGRIDSYNC:
+      result = processGetEpgGridSync();
+      break;
 #endif     
     case 11:
       result = processConfigSave();
@@ -274,6 +599,12 @@ bool VompClientRRProc::processPacket()
     case 12:
       result = processConfigLoad();
       break;
+    case VDR_CONFIGLOADBATCH:
+      result = processConfigLoadBatch();
+      break;
+    case VDR_CONFIGSAVEBATCH:
+      result = processConfigSaveBatch();
+      break;
 #ifndef VOMPSTANDALONE        
     case 13:
       result = processReScanRecording();         // FIXME obselete
@@ -365,11 +696,11 @@ bool VompClientRRProc::processPacket()
       break;
   }
 
-  delete resp;
+  // Handlers that bailed out without sending leave resp with us
+  if (resp) resp->release();
   resp = NULL;
   
-  if (req->data) free(req->data);
-  delete req;
+  req->release();
   req = NULL;
   
   if (result) return true;
@@ -408,8 +739,8 @@ int VompClientRRProc::processLogin()
   }
   
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
   log->log("RRProc", Log::DEBUG, "written login reply len %lu", resp->getLen());
+  sendResponse();
     
   x.loggedIn = true;
   x.netLog(); // safe to run here since the client won't start net logging for a while yet
@@ -432,7 +763,7 @@ int VompClientRRProc::processSetCharset()
     resp->addULONG(0);
   }
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
@@ -472,7 +803,7 @@ int VompClientRRProc::processConfigSave()
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   return 1;
 }
@@ -506,18 +837,108 @@ int VompClientRRProc::processConfigLoad()
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   return 1;
 }
 
+bool VompClientRRProc::splitRequestStrings(std::vector<const char*>& strings)
+{
+  // The data is a run of null terminated strings
+  if (!req->dataLength || (req->data[req->dataLength - 1] != '\0')) return false;
+
+  const char* start = (const char*)req->data;
+  for (UINT k = 0; k < req->dataLength; k++)
+  {
+    if (req->data[k] == '\0')
+    {
+      strings.push_back(start);
+      start = (const char*)&req->data[k+1];
+    }
+  }
+  return true;
+}
+
+int VompClientRRProc::processConfigLoadBatch()
+{
+  // section, then the keys wanted. No keys loads the whole section
+  std::vector<const char*> strings;
+  if (!splitRequestStrings(strings)) return 0;
+
+  Config::KeyValues values;
+  if (strings.size() == 1)
+  {
+    x.config.getSectionValues(strings[0], values);
+  }
+  else
+  {
+    for (UINT i = 1; i < strings.size(); i++)
+    {
+      char* value = x.config.getValueString(strings[0], strings[i]);
+      if (!value) continue;
+      values.push_back(std::make_pair(std::string(strings[i]), std::string(value)));
+      delete[] value;
+    }
+  }
+
+  // Keys that are not set are left out
+  resp->addULONG(values.size());
+  for (UINT i = 0; i < values.size(); i++)
+  {
+    resp->addString(values[i].first.c_str());
+    resp->addString(values[i].second.c_str());//client coding, do not touch
+  }
+
+  resp->finalise();
+  sendResponse();
+  log->log("RRProc", Log::DEBUG, "Written config batch load, section %s: %lu of %lu keys",
+           strings[0], (ULONG)values.size(), (ULONG)(strings.size() - 1));
+
+  return 1;
+}
+
+int VompClientRRProc::processConfigSaveBatch()
+{
+  // section, then key and value pairs
+  std::vector<const char*> strings;
+  if (!splitRequestStrings(strings)) return 0;
+  if ((strings.size() < 3) || !(strings.size() % 2)) return 0;
+
+  Config::KeyValues values;
+  for (UINT i = 1; i < strings.size(); i += 2)
+    values.push_back(std::make_pair(std::string(strings[i]), std::string(strings[i+1])));
+
+  log->log("RRProc", Log::DEBUG, "Config batch save: %s, %lu keys", strings[0], (ULONG)values.size());
+  if (x.config.setValueStrings(strings[0], values))
+  {
+    resp->addULONG(1);
+  }
+  else
+  {
+    resp->addULONG(0);
+  }
+
+  resp->finalise();
+  sendResponse();
+
+  return 1;
+}
+
 
 //helper for sending from a serialize buffer
 //insert the used len into the first 4 Bytes of the buffer
 void VompClientRRProc::sendPacket(SerializeBuffer *b) {
   resp->copyin(b->getStart(),b->getCurrent()-b->getStart());
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
+}
+
+// Hand the finalised response over to the client's send queue.
+// The queue owns (and deletes) it from here on.
+void VompClientRRProc::sendResponse()
+{
+  x.sendQueue.sendResponse(resp, req->opcode);
+  resp = NULL;
 }
 
 /**
@@ -616,7 +1037,7 @@ int VompClientRRProc::processGetMediaBlock()
     log->log("Client", Log::ERR, "getMediaBlock unable to deserialize");
     return 0;
   }
-  log->log("Client", Log::DEBUG, "getMediaBlock pos = %llu length = %lu,chan=%lu", position, amount,channel);
+  LOG("Client", Log::DEBUG, "getMediaBlock pos = %llu length = %lu,chan=%lu", position, amount,channel);
 
   UCHAR sendBuffer[amount ];
   ULONG amountReceived = 0; 
@@ -624,7 +1045,7 @@ int VompClientRRProc::processGetMediaBlock()
   int rt=x.media->getMediaBlock(channel,position,amount,&amountReceived,&rbuf);
   if (!amountReceived || rt != 0)
   {
-    log->log("Client", Log::DEBUG, "written 4(0) as getblock got 0");
+    LOG("Client", Log::DEBUG, "written 4(0) as getblock got 0");
   }
   else
   {
@@ -638,8 +1059,8 @@ int VompClientRRProc::processGetMediaBlock()
     }
   }
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
-  log->log("Client", Log::DEBUG, "written ok %lu", amountReceived);
+  sendResponse();
+  LOG("Client", Log::DEBUG, "written ok %lu", amountReceived);
   return 1;
 }
 /**
@@ -708,40 +1129,35 @@ int VompClientRRProc::processCloseMediaChannel()
 
 int VompClientRRProc::processGetLanguageList()
 {
-  x.i18n.findLanguages();
-  const I18n::lang_code_list& languages = x.i18n.getLanguageList();
-  std::string result;
-  I18n::lang_code_list::const_iterator iter;
-  for (iter = languages.begin(); iter != languages.end(); ++iter)
-  {
-    resp->addString(iter->first.c_str()); // Source code is acsii
-    resp->addString(x.charconvutf8->Convert(iter->second.c_str())); //translate string can be any utf-8 character
-  }
+  I18n::Payload payload = x.i18n.getLanguageListPayload(charcoding, charconvutf8);
+  resp->copyin((const UCHAR*)payload->data(), payload->length());
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
 int VompClientRRProc::processGetLanguageContent()
 {
   if (req->dataLength <= 0) return 0;
-  std::string code, result;
+  std::string code;
   code.assign((char*)req->data, req->dataLength - 1);
-  x.i18n.findLanguages();
-  I18n::trans_table texts = x.i18n.getLanguageContent(code);
-  I18n::trans_table::const_iterator iter;
-  for (iter = texts.begin(); iter != texts.end(); ++iter)
-  {
-    resp->addString(iter->first.c_str());// source code is acsii since it is english
-    resp->addString(x.charconvutf8->Convert(iter->second.c_str())); // translate text can be any unicode string, it is stored as UTF-8
-  }
+  I18n::Payload payload = x.i18n.getLanguageContentPayload(code, charcoding, charconvutf8);
+  resp->copyin((const UCHAR*)payload->data(), payload->length());
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
 #ifndef VOMPSTANDALONE
 
+struct RecordingSnapshot
+{
+  ULONG start;
+  bool isNew;
+  std::string name;
+  std::string fileName;
+};
+
 int VompClientRRProc::processGetRecordingsList()
 {
   int FreeMB;
@@ -756,28 +1172,44 @@ int VompClientRRProc::processGetRecordingsList()
   resp->addULONG(FreeMB);
   resp->addULONG(Percent);
 
+  // Copy out under the lock, convert and serialize after it
+  std::vector<RecordingSnapshot> recordings;
+  {
 #if VDRVERSNUM >= 20301
-  LOCK_RECORDINGS_READ;
-  const cRecordings* tRecordings = Recordings;
+    LOCK_RECORDINGS_READ;
+    const cRecordings* tRecordings = Recordings;
 #else
-  cThreadLock RecordingsLock(&Recordings);
-  const cRecordings* tRecordings = &Recordings;
+    cThreadLock RecordingsLock(&Recordings);
+    const cRecordings* tRecordings = &Recordings;
 #endif
+    LockHoldTimer lockTimer(Stats::LOCK_RECORDINGS);
 
-  for (const cRecording *recording = tRecordings->First(); recording; recording = tRecordings->Next(recording))
-  {
+    recordings.resize(tRecordings->Count());
+    UINT r = 0;
+    for (const cRecording *recording = tRecordings->First(); recording && (r < recordings.size()); recording = tRecordings->Next(recording), r++)
+    {
 #if VDRVERSNUM < 10721
-    resp->addULONG(recording->start);
+      recordings[r].start = recording->start;
 #else
-    resp->addULONG(recording->Start());
+      recordings[r].start = recording->Start();
 #endif
-    resp->addUCHAR(recording->IsNew() ? 1 : 0);
-    resp->addString(x.charconvsys->Convert(recording->Name())); //coding of recording name is system dependent
-    resp->addString(recording->FileName());//file name are not  visible by user do not touch
+      recordings[r].isNew = recording->IsNew();
+      recordings[r].name = recording->Name();
+      recordings[r].fileName = recording->FileName();
+    }
+    recordings.resize(r);
+  }
+
+  for (UINT r = 0; r < recordings.size(); r++)
+  {
+    resp->addULONG(recordings[r].start);
+    resp->addUCHAR(recordings[r].isNew ? 1 : 0);
+    resp->addString(charconvsys->convertStable(recordings[r].name.c_str())); //coding of recording name is system dependent
+    resp->addString(recordings[r].fileName.c_str());//file name are not  visible by user do not touch
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   log->log("RRProc", Log::DEBUG, "Written recordings list");
 
@@ -835,7 +1267,7 @@ int VompClientRRProc::processDeleteRecording()
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   return 1;
 }
@@ -847,7 +1279,7 @@ int VompClientRRProc::processDeleteRecResume()
 #if VDRVERSNUM < 20301
   resp->addULONG(5);  // Not supported
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 #else
 
@@ -879,7 +1311,7 @@ int VompClientRRProc::processDeleteRecResume()
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   return 1;
 
@@ -996,7 +1428,7 @@ int VompClientRRProc::processMoveRecording()
 
           resp->addULONG(5);          
           resp->finalise();
-          x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+          sendResponse();
           return 1;
         }
       }
@@ -1008,7 +1440,7 @@ int VompClientRRProc::processMoveRecording()
 
         resp->addULONG(5);          
         resp->finalise();
-        x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+        sendResponse();
         return 1;
       }
 
@@ -1045,7 +1477,7 @@ int VompClientRRProc::processMoveRecording()
       }
 
       resp->finalise();
-      x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+      sendResponse();
 
       delete[] dateDirName;
       delete[] titleDirName;
@@ -1056,19 +1488,27 @@ int VompClientRRProc::processMoveRecording()
     {
       resp->addULONG(3);          
       resp->finalise();
-      x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+      sendResponse();
     }
   }
   else
   {
     resp->addULONG(4);          
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
   }
 
   return 1;
 }
 
+struct ChannelSnapshot
+{
+  ULONG number;
+  ULONG type;
+  ULONG vtype;
+  std::string name;
+};
+
 int VompClientRRProc::processGetChannelsList()
 {
   ULONG type;
@@ -1077,44 +1517,60 @@ int VompClientRRProc::processGetChannelsList()
   int allChans = 1;
   if (chanConfig) allChans = strcasecmp(chanConfig, "FTA only");
 
+  // Copy out under the lock, convert and serialize after it
+  std::vector<ChannelSnapshot> channels;
+  {
 #if VDRVERSNUM >= 20301
-  LOCK_CHANNELS_READ;
-  const cChannels* tChannels = Channels;
+    LOCK_CHANNELS_READ;
+    const cChannels* tChannels = Channels;
+    LockHoldTimer lockTimer(Stats::LOCK_CHANNELS);
 #else
-  const cChannels* tChannels = &Channels;
+    const cChannels* tChannels = &Channels;
 #endif
 
-  for (const cChannel *channel = tChannels->First(); channel; channel = tChannels->Next(channel))
-  {
+    channels.reserve(tChannels->Count());
+    for (const cChannel *channel = tChannels->First(); channel; channel = tChannels->Next(channel))
+    {
 #if VDRVERSNUM < 10300
-    if (!channel->GroupSep() && (!channel->Ca() || allChans))
+      if (!channel->GroupSep() && (!channel->Ca() || allChans))
 #else
-    if (!channel->GroupSep() && (!channel->Ca(0) || allChans))
+      if (!channel->GroupSep() && (!channel->Ca(0) || allChans))
 #endif
-    {
-      log->log("RRProc", Log::DEBUG, "name: '%s'", channel->Name());
-
-      if (channel->Vpid()) type = 1;
+      {
+        if (channel->Vpid()) type = 1;
 #if VDRVERSNUM < 10300
-      else type = 2;
+        else type = 2;
 #else
-      else if (channel->Apid(0)) type = 2;
-      else continue;
+        else if (channel->Apid(0)) type = 2;
+        else continue;
 #endif
 
-      resp->addULONG(channel->Number());
-      resp->addULONG(type);      
-      resp->addString(x.charconvsys->Convert(channel->Name()));
+        channels.push_back(ChannelSnapshot());
+        ChannelSnapshot& snapshot = channels.back();
+        snapshot.number = channel->Number();
+        snapshot.type = type;
+        snapshot.name = channel->Name();
 #if VDRVERSNUM < 10703
-      resp->addULONG(2);
+        snapshot.vtype = 2;
 #else
-      resp->addULONG(channel->Vtype());
-#endif      
+        snapshot.vtype = channel->Vtype();
+#endif
+      }
     }
   }
 
+  for (UINT c = 0; c < channels.size(); c++)
+  {
+    log->log("RRProc", Log::DEBUG, "name: '%s'", channels[c].name.c_str());
+
+    resp->addULONG(channels[c].number);
+    resp->addULONG(channels[c].type);
+    resp->addString(charconvsys->convertStable(channels[c].name.c_str()));
+    resp->addULONG(channels[c].vtype);
+  }
+
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   log->log("RRProc", Log::DEBUG, "Written channels list");
 
@@ -1137,7 +1593,7 @@ int VompClientRRProc::processGetChannelPids()
   {
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
@@ -1219,19 +1675,19 @@ int VompClientRRProc::processGetChannelPids()
   for (ULONG i = 0; i < numApids; i++)
   {
     resp->addULONG(channel->Apid(i));
-    resp->addString(x.charconvsys->Convert(channel->Alang(i)));
+    resp->addString(charconvsys->convert(channel->Alang(i)));
   }
   resp->addULONG(numDpids);
   for (ULONG i = 0; i < numDpids; i++)
   {
     resp->addULONG(channel->Dpid(i));
-    resp->addString(x.charconvsys->Convert(channel->Dlang(i)));
+    resp->addString(charconvsys->convert(channel->Dlang(i)));
   }
   resp->addULONG(numSpids);
   for (ULONG i = 0; i < numSpids; i++)
   {
     resp->addULONG(channel->Spid(i));
-    resp->addString(x.charconvsys->Convert(channel->Slang(i)));
+    resp->addString(charconvsys->convert(channel->Slang(i)));
   }
 #endif
   resp->addULONG(channel->Tpid());
@@ -1289,7 +1745,7 @@ int VompClientRRProc::processGetChannelPids()
 
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   log->log("RRProc", Log::DEBUG, "Written channels pids");
 
@@ -1319,7 +1775,7 @@ int VompClientRRProc::processStartStreamingChannel()
   {
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
@@ -1351,23 +1807,23 @@ int VompClientRRProc::processStartStreamingChannel()
   {
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
-  if (!x.lp->init(&x.tcp, req->requestID))
+  if (!x.lp->init(&x.sendQueue, req->requestID, x.clientStats))
   {
     delete x.lp;
     x.lp = NULL;
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
   resp->addULONG(1);
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
@@ -1390,7 +1846,7 @@ int VompClientRRProc::processStopStreaming()
 
   resp->addULONG(1);
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
@@ -1414,28 +1870,113 @@ int VompClientRRProc::processGetBlock()
   data += sizeof(ULLONG);
   ULONG amount = ntohl(*(ULONG*)data);
 
-  log->log("RRProc", Log::DEBUG, "getblock pos = %llu length = %lu", position, amount);
-
-  UCHAR sendBuffer[amount];
-  ULONG amountReceived = x.recplayer->getBlock(&sendBuffer[0], position, amount);
+  // Getblocks for the following ranges that are queued right behind this
+  // one are read from disk together with it, then answered one by one
+  std::vector<RequestPacket*> following;
+  ULONG totalAmount = amount;
+  ULLONG takenUs = Stats::nowUs();
+  if (!parallelWorker) totalAmount = takeContiguousGetBlocks(position, amount, following);
 
-  if (!amountReceived)
+  UCHAR* readBuffer = (UCHAR*)malloc(totalAmount);
+  ULONG amountReceived = 0;
+  if (readBuffer)
   {
-    resp->addULONG(0);
-    log->log("RRProc", Log::DEBUG, "written 4(0) as getblock got 0");
+    ULLONG readStartUs = Stats::nowUs();
+    amountReceived = x.recplayer->getBlock(readBuffer, position, totalAmount);
+    Stats::getInstance()->recPlayerRead(amountReceived, Stats::nowUs() - readStartUs);
+
+    if (!amountReceived && following.size())
+    {
+      // The combined read may have been refused (past the end etc.),
+      // fall back to what was actually asked for here, no more than the buffer holds
+      ULONG ownAmount = (amount < totalAmount) ? amount : totalAmount;
+      amountReceived = x.recplayer->getBlock(readBuffer, position, ownAmount);
+      if (amountReceived > ownAmount) amountReceived = ownAmount;
+    }
   }
   else
   {
-    resp->copyin(sendBuffer, amountReceived);
-    log->log("RRProc", Log::DEBUG, "written %lu", amountReceived);
+    log->log("RRProc", Log::ERR, "getblock buffer malloc error");
   }
 
+  ULONG thisAmount = (amountReceived < amount) ? amountReceived : amount;
+  if (!thisAmount) resp->addULONG(0);
+  else resp->copyin(readBuffer, thisAmount);
+
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
-  log->log("RRProc", Log::DEBUG, "Finished getblock, have sent %lu", resp->getLen());
+  LOG("RRProc", Log::DEBUG, "getblock pos = %llu length = %lu, got %lu", position, amount, thisAmount);
+  sendResponse();
+
+  // Answer the coalesced ones from the rest of the buffer
+  ULONG offset = amount;
+  for (ULONG i = 0; i < following.size(); i++)
+  {
+    RequestPacket* next = following[i];
+    ULONG nextAmount = ntohl(*(ULONG*)&next->data[sizeof(ULLONG)]);
+    ULONG available = (amountReceived > offset) ? amountReceived - offset : 0;
+    if (available > nextAmount) available = nextAmount;
+
+    bool sent = false;
+    ResponsePacket* nextResp = respPool.get();
+    if (nextResp->init(next->requestID, available + 16))
+    {
+      if (available) nextResp->copyin(readBuffer + offset, available);
+      else nextResp->addULONG(0);
+      nextResp->finalise();
+      x.sendQueue.sendResponse(nextResp, VDR_GETBLOCK);
+      sent = true;
+    }
+    else
+    {
+      log->log("RRProc", Log::ERR, "response packet init fail");
+      nextResp->release();
+    }
+
+    // Counted as if it had been taken off the queue and processed on its own,
+    // from when it was taken with this one until its reply was queued
+    Stats::getInstance()->requestProcessed(VDR_GETBLOCK, takenUs - next->receivedUs, Stats::nowUs() - takenUs, sent);
+
+    LOG("RRProc", Log::DEBUG, "Coalesced getblock %lu, sent %lu", next->requestID, available);
+    offset += nextAmount;
+    next->release();
+    requestFinished(VDR_GETBLOCK);
+  }
+
+  if (readBuffer) free(readBuffer);
   return 1;
 }
 
+ULONG VompClientRRProc::takeContiguousGetBlocks(ULLONG position, ULONG amount, std::vector<RequestPacket*>& following)
+{
+  // Too big to be read anyway, RecPlayer will refuse it on its own
+  if (amount > maxCoalescedBytes) return amount;
+
+  ULLONG nextPosition = position + amount;
+  ULONG totalAmount = amount;
+
+  threadLock();
+  while (req_queue.size() && (following.size() < maxCoalescedGetBlocks))
+  {
+    RequestPacket* next = req_queue.front();
+    if ((next->opcode != VDR_GETBLOCK) || (next->dataLength < (sizeof(ULLONG) + sizeof(ULONG)))) break;
+
+    ULLONG nextPos = x.ntohll(*(ULLONG*)next->data);
+    ULONG nextAmount = ntohl(*(ULONG*)&next->data[sizeof(ULLONG)]);
+    if (nextPos != nextPosition) break;
+    if (nextAmount > (maxCoalescedBytes - totalAmount)) break; // client values, don't let the sum wrap
+
+    req_queue.pop_front();
+    following.push_back(next);
+    totalAmount += nextAmount;
+    nextPosition += nextAmount;
+  }
+  threadUnlock();
+
+  if (following.size())
+    log->log("RRProc", Log::DEBUG, "getblock coalesced %lu following requests, %lu bytes total", (ULONG)following.size(), totalAmount);
+
+  return totalAmount;
+}
 int VompClientRRProc::processStartStreamingRecording()
 {
   // data is a pointer to the fileName string
@@ -1466,7 +2007,7 @@ int VompClientRRProc::processStartStreamingRecording()
 #endif
 
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     
     log->log("RRProc", Log::DEBUG, "written totalLength");
   }
@@ -1477,7 +2018,7 @@ int VompClientRRProc::processStartStreamingRecording()
     resp->addULONG(0);
     resp->addUCHAR(false);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     log->log("RRProc", Log::DEBUG, "start streaming recording failed");
   }
 
@@ -1501,7 +2042,7 @@ int VompClientRRProc::processPositionFromFrameNumber()
 
   resp->addULLONG(retval);
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   log->log("RRProc", Log::DEBUG, "Wrote posFromFrameNum reply to client");
   return 1;
@@ -1524,7 +2065,7 @@ int VompClientRRProc::processFrameNumberFromPosition()
 
   resp->addULONG(retval);
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   log->log("RRProc", Log::DEBUG, "Wrote frameNumFromPos reply to client");
   return 1;
@@ -1567,12 +2108,22 @@ int VompClientRRProc::processGetIFrame()
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   log->log("RRProc", Log::DEBUG, "Wrote GNIF reply to client %llu %lu %lu", rfilePosition, rframeNumber, rframeLength);
   return 1;
 }
 
+struct EventSnapshot
+{
+  ULONG id;
+  ULONG time;
+  ULONG duration;
+  std::string title;
+  std::string subTitle;
+  std::string description;
+};
+
 int VompClientRRProc::processGetChannelSchedule()
 {
   ULONG* data = (ULONG*)req->data;
@@ -1585,19 +2136,31 @@ int VompClientRRProc::processGetChannelSchedule()
 
   log->log("RRProc", Log::DEBUG, "get schedule called for channel %lu", channelNumber);
 
+  // Copy the events out under the locks, convert and serialize after them
+  tChannelID channelID;
+  bool haveChannel = false;
+  {
 #if VDRVERSNUM >= 20301
-  LOCK_CHANNELS_READ;
-  const cChannels* tChannels = Channels;
+    LOCK_CHANNELS_READ;
+    const cChannels* tChannels = Channels;
+    LockHoldTimer lockTimer(Stats::LOCK_CHANNELS);
 #else
-  cChannels* tChannels = &Channels;
+    cChannels* tChannels = &Channels;
 #endif
 
-  const cChannel* channel = tChannels->GetByNumber(channelNumber);
-  if (!channel)
+    const cChannel* channel = tChannels->GetByNumber(channelNumber);
+    if (channel)
+    {
+      channelID = channel->GetChannelID();
+      haveChannel = true;
+    }
+  }
+
+  if (!haveChannel)
   {
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
   
     log->log("RRProc", Log::DEBUG, "written 0 because channel = NULL");
     return 1;
@@ -1605,156 +2168,571 @@ int VompClientRRProc::processGetChannelSchedule()
 
   log->log("RRProc", Log::DEBUG, "Got channel");
 
+  const char* noData = NULL;
+  std::vector<EventSnapshot> events;
+  {
 #if VDRVERSNUM < 10300
-  cMutexLock MutexLock;
-  const cSchedules *tSchedules = cSIProcessor::Schedules(MutexLock);
+    cMutexLock MutexLock;
+    const cSchedules *tSchedules = cSIProcessor::Schedules(MutexLock);
 #elif VDRVERSNUM < 20301
-  cSchedulesLock MutexLock;
-  const cSchedules *tSchedules = cSchedules::Schedules(MutexLock);
+    cSchedulesLock MutexLock;
+    const cSchedules *tSchedules = cSchedules::Schedules(MutexLock);
 #else
-  LOCK_SCHEDULES_READ;
-  const cSchedules *tSchedules = Schedules;
+    LOCK_SCHEDULES_READ;
+    const cSchedules *tSchedules = Schedules;
+#endif
+    LockHoldTimer lockTimer(Stats::LOCK_SCHEDULES);
+
+    const cSchedule *Schedule = NULL;
+    if (!tSchedules) noData = "written 0 because Schedule!s! = NULL";
+    else if (!(Schedule = tSchedules->GetSchedule(channelID))) noData = "written 0 because Schedule = NULL";
+
+    if (Schedule)
+    {
+      ULONG thisEventID;
+      ULONG thisEventTime;
+      ULONG thisEventDuration;
+      const char* thisEventTitle;
+      const char* thisEventSubTitle;
+      const char* thisEventDescription;
+
+#if VDRVERSNUM < 10300
+
+      const cEventInfo *event;
+      for (int eventNumber = 0; eventNumber < Schedule->NumEvents(); eventNumber++)
+      {
+        event = Schedule->GetEventNumber(eventNumber);
+
+        thisEventID = event->GetEventID();
+        thisEventTime = event->GetTime();
+        thisEventDuration = event->GetDuration();
+        thisEventTitle = event->GetTitle();
+        thisEventSubTitle = event->GetSubtitle();
+        thisEventDescription = event->GetExtendedDescription();
+
+#elif VDRVERSNUM < 20301
+
+      for (const cEvent* event = Schedule->Events()->First(); event; event = Schedule->Events()->Next(event))
+      {
+        thisEventID = event->EventID();
+        thisEventTime = event->StartTime();
+        thisEventDuration = event->Duration();
+        thisEventTitle = event->Title();
+        thisEventSubTitle = NULL;
+        thisEventDescription = event->Description();
+
+#else
+
+      // Only the events in the window, found through the shared index
+      std::vector<const cEvent*> windowEvents;
+      EpgIndex::getInstance()->getEvents(Schedule, startTime, duration, windowEvents);
+      events.reserve(windowEvents.size());
+      for (UINT eventNumber = 0; eventNumber < windowEvents.size(); eventNumber++)
+      {
+        const cEvent* event = windowEvents[eventNumber];
+        thisEventID = event->EventID();
+        thisEventTime = event->StartTime();
+        thisEventDuration = event->Duration();
+        thisEventTitle = event->Title();
+        thisEventSubTitle = NULL;
+        thisEventDescription = event->Description();
+
 #endif
 
-  if (!tSchedules)
+        //in the past filter
+        if ((thisEventTime + thisEventDuration) < (ULONG)time(NULL)) continue;
+
+        //start time filter
+        if ((thisEventTime + thisEventDuration) <= startTime) continue;
+
+        //duration filter
+        if (thisEventTime >= (startTime + duration)) continue;
+
+        events.push_back(EventSnapshot());
+        EventSnapshot& snapshot = events.back();
+        snapshot.id = thisEventID;
+        snapshot.time = thisEventTime;
+        snapshot.duration = thisEventDuration;
+        if (thisEventTitle) snapshot.title = thisEventTitle;
+        if (thisEventSubTitle) snapshot.subTitle = thisEventSubTitle;
+        if (thisEventDescription) snapshot.description = thisEventDescription;
+      }
+    }
+  }
+
+  if (noData)
   {
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     
-    log->log("RRProc", Log::DEBUG, "written 0 because Schedule!s! = NULL");
+    log->log("RRProc", Log::DEBUG, "%s", noData);
     return 1;
   }
 
-  log->log("RRProc", Log::DEBUG, "Got schedule!s! object");
+  log->log("RRProc", Log::DEBUG, "Got all event data");
 
-  const cSchedule *Schedule = tSchedules->GetSchedule(channel->GetChannelID());
-  if (!Schedule)
+  for (UINT e = 0; e < events.size(); e++)
+  {
+    resp->addULONG(events[e].id);
+    resp->addULONG(events[e].time);
+    resp->addULONG(events[e].duration);
+
+    resp->addString(charconvsys->convertStable(events[e].title.c_str()));
+    resp->addString(charconvsys->convertStable(events[e].subTitle.c_str()));
+    resp->addString(charconvsys->convertStable(events[e].description.c_str()));
+  }
+
+  if (events.empty())
   {
     resp->addULONG(0);
-    resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
-    
-    log->log("RRProc", Log::DEBUG, "written 0 because Schedule = NULL");
-    return 1;
+    log->log("RRProc", Log::DEBUG, "Written 0 because no data");
   }
+  
+  resp->finalise();
+  sendResponse();
+    
+  log->log("RRProc", Log::DEBUG, "written schedules packet");
 
-  log->log("RRProc", Log::DEBUG, "Got schedule object");
+  return 1;
+}
 
-  const char* empty = "";
-  bool atLeastOneEvent = false;
+/*
+  VDR_GETEPGGRID: the schedules of many channels in one go, for the EPG
+  grid. Request: ULONG window start, ULONG duration, ULONG number of
+  channels and that many channel numbers, or 0 and then ULONG first and
+  last channel number of a range. Reply: ULONG number of channels, then
+  for each ULONG channel number, ULONG version, ULONG number of events
+  and the events as VDR_GETCHANNELSCHEDULE sends them. Unknown channels
+  have no events.
+
+  VDR_GETEPGGRIDHEADERS takes the same request and sends only the event
+  headers: ULONG event ID, start, duration, flags (EPG_FLAG_*) and the
+  title. The descriptions can then be fetched with
+  VDR_GETEVENTDESCRIPTIONS for the events that are looked at.
+
+  VDR_GETEPGGRIDSYNC refreshes a grid the client already has. Request:
+  ULONG window start, ULONG duration, ULONG 1 for headers only, ULONG
+  start and ULONG duration of the window the client's versions were got
+  for, ULONG number of channels, then for each ULONG channel number and
+  the ULONG version the client has of it, 0 for none. Reply: ULONG
+  number of channels, then for each ULONG channel number, ULONG version
+  and ULONG status (EpgIndex::SYNC_*). Unchanged channels end there.
+  Otherwise ULONG number of events and the events follow: the whole
+  window, or for SYNC_CHANGES only the events that are new or changed,
+  followed by ULONG number and the IDs of events to drop.
+
+  The version of a channel goes up whenever one of its events changes.
+  It is 0 for channels without a schedule. A version only says what the
+  client has of the window it was got for: an event that has not changed
+  but is in a moved window would not be sent, so if the two windows
+  differ every channel with a schedule is sent whole. Events that are
+  over are not reported as dropped, the client drops those itself.
+
+  The locks are taken once for the lot. With many events and more than
+  one CPU the events are serialized by a few threads, each doing a run of
+  channels into its own buffer.
+*/
 
-  ULONG thisEventID;
-  ULONG thisEventTime;
-  ULONG thisEventDuration;
-  const char* thisEventTitle;
-  const char* thisEventSubTitle;
-  const char* thisEventDescription;
+struct GridChannel
+{
+  ULONG number;
+  ULONG version;
+  int status; // EpgIndex::SYNC_*, -1 for the non-sync replies
+  std::vector<const cEvent*> events;
+  std::vector<ULONG> removed;
+};
+
+static void appendULONG(std::string& out, ULONG ul)
+{
+  ULONG n = htonl(ul);
+  out.append((const char*)&n, sizeof(ULONG));
+}
 
-#if VDRVERSNUM < 10300
+static void appendString(std::string& out, const char* text)
+{
+  out.append(text, strlen(text) + 1);
+}
 
-  const cEventInfo *event;
-  for (int eventNumber = 0; eventNumber < Schedule->NumEvents(); eventNumber++)
+static void serializeGridChannels(std::vector<GridChannel>& channels, UINT first, UINT last, bool headersOnly, CharsetConv* conv, std::string& out)
+{
+  for (UINT c = first; c < last; c++)
   {
-    event = Schedule->GetEventNumber(eventNumber);
+    appendULONG(out, channels[c].number);
+    appendULONG(out, channels[c].version);
+    if (channels[c].status >= 0)
+    {
+      appendULONG(out, channels[c].status);
+      if (channels[c].status == EpgIndex::SYNC_UNCHANGED) continue;
+    }
 
-    thisEventID = event->GetEventID();
-    thisEventTime = event->GetTime();
-    thisEventDuration = event->GetDuration();
-    thisEventTitle = event->GetTitle();
-    thisEventSubTitle = event->GetSubtitle();
-    thisEventDescription = event->GetExtendedDescription();
+    appendULONG(out, channels[c].events.size());
+    for (UINT e = 0; e < channels[c].events.size(); e++)
+    {
+      const cEvent* event = channels[c].events[e];
+      appendULONG(out, event->EventID());
+      appendULONG(out, event->StartTime());
+      appendULONG(out, event->Duration());
+      if (headersOnly)
+      {
+        ULONG flags = 0;
+        if (event->Description() && *event->Description()) flags |= VompClientRRProc::EPG_FLAG_DESCRIPTION;
+        if (event->ShortText() && *event->ShortText()) flags |= VompClientRRProc::EPG_FLAG_SHORTTEXT;
+        appendULONG(out, flags);
+        appendString(out, conv->convertStable(event->Title() ? event->Title() : ""));
+      }
+      else
+      {
+        appendString(out, conv->convertStable(event->Title() ? event->Title() : ""));
+        appendString(out, ""); // subtitle, as VDR_GETCHANNELSCHEDULE
+        appendString(out, conv->convertStable(event->Description() ? event->Description() : ""));
+      }
+    }
 
-#else
+    if (channels[c].status == EpgIndex::SYNC_CHANGES)
+    {
+      appendULONG(out, channels[c].removed.size());
+      for (UINT r = 0; r < channels[c].removed.size(); r++) appendULONG(out, channels[c].removed[r]);
+    }
+  }
+}
+
+class GridFiller : public Thread
+{
+  public:
+    GridFiller(std::vector<GridChannel>& tchannels, UINT tfirst, UINT tlast, bool theadersOnly, int charcoding)
+    : channels(tchannels), first(tfirst), last(tlast), headersOnly(theadersOnly),
+      conv(NULL, (charcoding == 2) ? "UTF-8" : "ISO-8859-1") {}
+
+    bool start() { return threadStart(); }
+    void join() { threadStop(); }
+    std::string out;
+
+  private:
+    void threadMethod() { serializeGridChannels(channels, first, last, headersOnly, &conv, out); }
+
+    std::vector<GridChannel>& channels;
+    UINT first, last;
+    bool headersOnly;
+    CharsetConv conv;
+};
+
+// Adds the channels to resp, returns how many threads did it
+static UINT writeGrid(ResponsePacket* resp, std::vector<GridChannel>& channels, UINT totalEvents, bool headersOnly,
+                      CharsetConv* conv, int charcoding)
+{
+  // This thread does the first run of channels, fillers the others
+  UINT parts = 1;
+  if (totalEvents >= VompClientRRProc::GRID_PARALLEL_EVENTS)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 1) parts = std::min((UINT)cpus, std::min(VompClientRRProc::GRID_MAX_FILLERS + 1, (UINT)channels.size()));
+  }
 
-  for (const cEvent* event = Schedule->Events()->First(); event; event = Schedule->Events()->Next(event))
+  std::vector<GridFiller*> fillers;
+  UINT perPart = (channels.size() + parts - 1) / parts;
+  UINT tailFirst = channels.size(); // channels no filler could be started for
+  for (UINT p = 1; p < parts; p++)
   {
-    thisEventID = event->EventID();
-    thisEventTime = event->StartTime();
-    thisEventDuration = event->Duration();
-    thisEventTitle = event->Title();
-    thisEventSubTitle = NULL;
-    thisEventDescription = event->Description();
+    UINT first = p * perPart;
+    UINT last = std::min(first + perPart, (UINT)channels.size());
+    if (first >= last) break;
+    GridFiller* filler = new GridFiller(channels, first, last, headersOnly, charcoding);
+    if (!filler->start())
+    {
+      delete filler;
+      tailFirst = first;
+      break;
+    }
+    fillers.push_back(filler);
+  }
 
+  std::string own;
+  serializeGridChannels(channels, 0, std::min(perPart, (UINT)channels.size()), headersOnly, conv, own);
+
+  resp->addULONG(channels.size());
+  resp->copyin((const UCHAR*)own.data(), own.length());
+  for (UINT f = 0; f < fillers.size(); f++)
+  {
+    fillers[f]->join();
+    resp->copyin((const UCHAR*)fillers[f]->out.data(), fillers[f]->out.length());
+    delete fillers[f];
+  }
+  if (tailFirst < channels.size())
+  {
+    std::string tail;
+    serializeGridChannels(channels, tailFirst, channels.size(), headersOnly, conv, tail);
+    resp->copyin((const UCHAR*)tail.data(), tail.length());
+  }
+
+  return fillers.size() + 1;
+}
+
+int VompClientRRProc::processGetEpgGrid(bool headersOnly)
+{
+  if (req->dataLength < 3 * sizeof(ULONG)) return 0;
+
+  ULONG* data = (ULONG*)req->data;
+  ULONG startTime = ntohl(data[0]);
+  ULONG duration = ntohl(data[1]);
+  ULONG numChannels = ntohl(data[2]);
+
+  std::vector<GridChannel> channels;
+  if (numChannels)
+  {
+    if ((numChannels > MAX_GRID_CHANNELS) || (req->dataLength != (3 + numChannels) * sizeof(ULONG))) return 0;
+    channels.resize(numChannels);
+    for (ULONG i = 0; i < numChannels; i++) channels[i].number = ntohl(data[3 + i]);
+  }
+  else
+  {
+    if (req->dataLength != 5 * sizeof(ULONG)) return 0;
+    ULONG firstChannel = ntohl(data[3]);
+    ULONG lastChannel = ntohl(data[4]);
+    if ((lastChannel < firstChannel) || (lastChannel - firstChannel >= MAX_GRID_CHANNELS)) return 0;
+    channels.resize(lastChannel - firstChannel + 1);
+    for (ULONG i = 0; i < channels.size(); i++) channels[i].number = firstChannel + i;
+  }
+
+#if VDRVERSNUM >= 20301
+  LOCK_CHANNELS_READ;
+  const cChannels* tChannels = Channels;
+  LOCK_SCHEDULES_READ;
+  const cSchedules* tSchedules = Schedules;
+  LockHoldTimer channelsTimer(Stats::LOCK_CHANNELS);
+  LockHoldTimer schedulesTimer(Stats::LOCK_SCHEDULES);
+#else
+  cChannels* tChannels = &Channels;
+  cSchedulesLock MutexLock;
+  const cSchedules* tSchedules = cSchedules::Schedules(MutexLock);
 #endif
 
-    //in the past filter
-    if ((thisEventTime + thisEventDuration) < (ULONG)time(NULL)) continue;
+  UINT totalEvents = 0;
+  for (UINT c = 0; c < channels.size(); c++)
+  {
+    channels[c].version = 0;
+    channels[c].status = -1;
+    const cChannel* channel = tChannels->GetByNumber(channels[c].number);
+    if (!channel || !tSchedules) continue;
+    const cSchedule* schedule = tSchedules->GetSchedule(channel->GetChannelID());
+    if (!schedule) continue;
+    channels[c].version = EpgIndex::getInstance()->getEvents(schedule, startTime, duration, channels[c].events);
+    totalEvents += channels[c].events.size();
+  }
+
+  UINT parts = writeGrid(resp, channels, totalEvents, headersOnly, charconvsys, charcoding);
 
-    //start time filter
-    if ((thisEventTime + thisEventDuration) <= startTime) continue;
+  LOG("RRProc", Log::DEBUG, "Grid%s of %lu channels, %u events, %u parts", headersOnly ? " headers" : "", (ULONG)channels.size(), totalEvents, parts);
 
-    //duration filter
-    if (thisEventTime >= (startTime + duration)) continue;
+  resp->finalise();
+  sendResponse();
+  return 1;
+}
 
-    if (!thisEventTitle) thisEventTitle = empty;
-    if (!thisEventSubTitle) thisEventSubTitle = empty;
-    if (!thisEventDescription) thisEventDescription = empty;
+int VompClientRRProc::processGetEpgGridSync()
+{
+  if (req->dataLength < 6 * sizeof(ULONG)) return 0;
 
-    resp->addULONG(thisEventID);
-    resp->addULONG(thisEventTime);
-    resp->addULONG(thisEventDuration);
+  ULONG* data = (ULONG*)req->data;
+  ULONG startTime = ntohl(data[0]);
+  ULONG duration = ntohl(data[1]);
+  bool headersOnly = ntohl(data[2]) != 0;
+  ULONG syncStartTime = ntohl(data[3]);
+  ULONG syncDuration = ntohl(data[4]);
+  ULONG numChannels = ntohl(data[5]);
+  if ((numChannels > MAX_GRID_CHANNELS) || (req->dataLength != (6 + 2 * numChannels) * sizeof(ULONG))) return 0;
 
-    resp->addString(x.charconvsys->Convert(thisEventTitle));
-    resp->addString(x.charconvsys->Convert(thisEventSubTitle));
-    resp->addString(x.charconvsys->Convert(thisEventDescription));
+  // Versions got for another window can't be used for this one
+  bool sameWindow = (syncStartTime == startTime) && (syncDuration == duration);
 
-    atLeastOneEvent = true;
+  std::vector<GridChannel> channels(numChannels);
+  std::vector<ULONG> since(numChannels);
+  for (ULONG i = 0; i < numChannels; i++)
+  {
+    channels[i].number = ntohl(data[6 + 2 * i]);
+    since[i] = ntohl(data[7 + 2 * i]);
   }
 
-  log->log("RRProc", Log::DEBUG, "Got all event data");
+#if VDRVERSNUM >= 20301
+  LOCK_CHANNELS_READ;
+  const cChannels* tChannels = Channels;
+  LOCK_SCHEDULES_READ;
+  const cSchedules* tSchedules = Schedules;
+  LockHoldTimer channelsTimer(Stats::LOCK_CHANNELS);
+  LockHoldTimer schedulesTimer(Stats::LOCK_SCHEDULES);
+#else
+  cChannels* tChannels = &Channels;
+  cSchedulesLock MutexLock;
+  const cSchedules* tSchedules = cSchedules::Schedules(MutexLock);
+#endif
 
-  if (!atLeastOneEvent)
+  UINT totalEvents = 0;
+  UINT unchanged = 0;
+  for (UINT c = 0; c < channels.size(); c++)
   {
-    resp->addULONG(0);
-    log->log("RRProc", Log::DEBUG, "Written 0 because no data");
+    channels[c].version = 0;
+    channels[c].status = EpgIndex::SYNC_FULL;
+    const cChannel* channel = tChannels->GetByNumber(channels[c].number);
+    const cSchedule* schedule = NULL;
+    if (channel && tSchedules) schedule = tSchedules->GetSchedule(channel->GetChannelID());
+    if (!schedule)
+    {
+      // Nothing, which the client may already know
+      if (!since[c]) channels[c].status = EpgIndex::SYNC_UNCHANGED;
+    }
+    else
+    {
+      channels[c].status = EpgIndex::getInstance()->getChanges(schedule, startTime, duration, sameWindow ? since[c] : 0,
+                             channels[c].version, channels[c].events, channels[c].removed);
+    }
+    if (channels[c].status == EpgIndex::SYNC_UNCHANGED) unchanged++;
+    totalEvents += channels[c].events.size();
   }
-  
-  resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
-    
-  log->log("RRProc", Log::DEBUG, "written schedules packet");
 
+  UINT parts = writeGrid(resp, channels, totalEvents, headersOnly, charconvsys, charcoding);
+
+  LOG("RRProc", Log::DEBUG, "Grid sync of %lu channels%s, %u unchanged, %u events, %u parts", (ULONG)channels.size(),
+      sameWindow ? "" : " (new window)", unchanged, totalEvents, parts);
+
+  resp->finalise();
+  sendResponse();
   return 1;
 }
 
-int VompClientRRProc::processGetTimers()
+/*
+  VDR_GETEVENTDESCRIPTIONS. Request: ULONG number of events, then for
+  each ULONG channel number and ULONG event ID. Reply: ULONG number of
+  events, then for each the channel number, the event ID, the short text
+  and the description. Texts are empty if there are none or the event is
+  not known.
+*/
+
+int VompClientRRProc::processGetEventDescriptions()
 {
+  if (req->dataLength < sizeof(ULONG)) return 0;
+
+  ULONG* data = (ULONG*)req->data;
+  ULONG numEvents = ntohl(data[0]);
+  if ((numEvents > MAX_DESCRIPTION_EVENTS) || (req->dataLength != (1 + 2 * numEvents) * sizeof(ULONG))) return 0;
+
 #if VDRVERSNUM >= 20301
-  LOCK_TIMERS_READ;
-  const cTimers* tTimers = Timers;
+  LOCK_CHANNELS_READ;
+  const cChannels* tChannels = Channels;
+  LOCK_SCHEDULES_READ;
+  const cSchedules* tSchedules = Schedules;
+  LockHoldTimer channelsTimer(Stats::LOCK_CHANNELS);
+  LockHoldTimer schedulesTimer(Stats::LOCK_SCHEDULES);
 #else
-  const cTimers* tTimers = &Timers;
+  cChannels* tChannels = &Channels;
+  cSchedulesLock MutexLock;
+  const cSchedules* tSchedules = cSchedules::Schedules(MutexLock);
 #endif
 
-  const cTimer *timer;
-  int numTimers = tTimers->Count();
+  resp->addULONG(numEvents);
+
+  // Requests usually come grouped by channel
+  ULONG lastChannelNumber = 0;
+  const cSchedule* schedule = NULL;
+  for (ULONG i = 0; i < numEvents; i++)
+  {
+    ULONG channelNumber = ntohl(data[1 + 2 * i]);
+    ULONG eventID = ntohl(data[2 + 2 * i]);
+
+    if (!i || (channelNumber != lastChannelNumber))
+    {
+      lastChannelNumber = channelNumber;
+      schedule = NULL;
+      const cChannel* channel = tChannels->GetByNumber(channelNumber);
+      if (channel && tSchedules) schedule = tSchedules->GetSchedule(channel->GetChannelID());
+    }
+
+    const cEvent* event = schedule ? schedule->GetEvent(eventID) : NULL;
+    const char* shortText = event ? event->ShortText() : NULL;
+    const char* description = event ? event->Description() : NULL;
+
+    resp->addULONG(channelNumber);
+    resp->addULONG(eventID);
+    resp->addString(shortText ? charconvsys->convertStable(shortText) : "");
+    resp->addString(description ? charconvsys->convertStable(description) : "");
+  }
+
+  LOG("RRProc", Log::DEBUG, "Written %lu event descriptions", numEvents);
+
+  resp->finalise();
+  sendResponse();
+  return 1;
+}
 
-  resp->addULONG(numTimers);
+struct TimerSnapshot
+{
+  ULONG active;
+  ULONG recording;
+  ULONG pending;
+  ULONG priority;
+  ULONG lifetime;
+  ULONG channelNumber;
+  ULONG startTime;
+  ULONG stopTime;
+  ULONG day;
+  ULONG weekDays;
+  std::string file;
+};
 
-  for (int i = 0; i < numTimers; i++)
+int VompClientRRProc::processGetTimers()
+{
+  // Copy out under the lock, serialize after it
+  std::vector<TimerSnapshot> timers;
   {
-    timer = tTimers->Get(i);
+#if VDRVERSNUM >= 20301
+    LOCK_TIMERS_READ;
+    const cTimers* tTimers = Timers;
+    LockHoldTimer lockTimer(Stats::LOCK_TIMERS);
+#else
+    const cTimers* tTimers = &Timers;
+#endif
 
+    timers.resize(tTimers->Count());
+    UINT t = 0;
+    for (const cTimer *timer = tTimers->First(); timer && (t < timers.size()); timer = tTimers->Next(timer), t++)
+    {
 #if VDRVERSNUM < 10300
-    resp->addULONG(timer->Active());
+      timers[t].active = timer->Active();
 #else
-    resp->addULONG(timer->HasFlags(tfActive));
+      timers[t].active = timer->HasFlags(tfActive);
 #endif
-    resp->addULONG(timer->Recording());
-    resp->addULONG(timer->Pending());
-    resp->addULONG(timer->Priority());
-    resp->addULONG(timer->Lifetime());
-    resp->addULONG(timer->Channel()->Number());
-    resp->addULONG(timer->StartTime());
-    resp->addULONG(timer->StopTime());
-    resp->addULONG(timer->Day());
-    resp->addULONG(timer->WeekDays());
-    resp->addString(timer->File()); //Filename is system specific and not visible by user
+      timers[t].recording = timer->Recording();
+      timers[t].pending = timer->Pending();
+      timers[t].priority = timer->Priority();
+      timers[t].lifetime = timer->Lifetime();
+      timers[t].channelNumber = timer->Channel()->Number();
+      timers[t].startTime = timer->StartTime();
+      timers[t].stopTime = timer->StopTime();
+      timers[t].day = timer->Day();
+      timers[t].weekDays = timer->WeekDays();
+      timers[t].file = timer->File();
+    }
+    timers.resize(t);
+  }
+
+  resp->addULONG(timers.size());
+
+  for (UINT t = 0; t < timers.size(); t++)
+  {
+    resp->addULONG(timers[t].active);
+    resp->addULONG(timers[t].recording);
+    resp->addULONG(timers[t].pending);
+    resp->addULONG(timers[t].priority);
+    resp->addULONG(timers[t].lifetime);
+    resp->addULONG(timers[t].channelNumber);
+    resp->addULONG(timers[t].startTime);
+    resp->addULONG(timers[t].stopTime);
+    resp->addULONG(timers[t].day);
+    resp->addULONG(timers[t].weekDays);
+    resp->addString(timers[t].file.c_str()); //Filename is system specific and not visible by user
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   log->log("RRProc", Log::DEBUG, "Written timers list");
 
@@ -1803,7 +2781,7 @@ int VompClientRRProc::processSetTimer()
   {
     resp->addULONG(2);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     delete timer;
     return 1;
   }
@@ -1820,7 +2798,7 @@ int VompClientRRProc::processSetTimer()
   {
     resp->addULONG(1);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     delete timer;
     return 1;
   }
@@ -1835,7 +2813,7 @@ int VompClientRRProc::processSetTimer()
 
   resp->addULONG(0);
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
@@ -1873,7 +2851,7 @@ int VompClientRRProc::processDeleteTimer()
   {
     resp->addULONG(4);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
@@ -1884,7 +2862,7 @@ int VompClientRRProc::processDeleteTimer()
     log->log("RRProc", Log::ERR, "Unable to delete timer - timers being edited at VDR");
     resp->addULONG(1);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 #endif
@@ -1894,7 +2872,7 @@ int VompClientRRProc::processDeleteTimer()
     log->log("RRProc", Log::ERR, "Unable to delete timer - timer is running");
     resp->addULONG(3);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
@@ -1903,7 +2881,7 @@ int VompClientRRProc::processDeleteTimer()
 
   resp->addULONG(10);
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
@@ -1934,7 +2912,7 @@ int VompClientRRProc::processGetRecInfo()
     log->log("RRProc", Log::ERR, "GetRecInfo found no recording");
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
@@ -2029,7 +3007,7 @@ int VompClientRRProc::processGetRecInfo()
   log->log("RRProc", Log::DEBUG, "GRI: S: %s", summary);
   if (summary)
   {
-    resp->addString(x.charconvsys->Convert(summary));
+    resp->addString(charconvsys->convertStable(summary));
     if (newsummary) delete [] summary;
   }
   else
@@ -2069,7 +3047,7 @@ int VompClientRRProc::processGetRecInfo()
 
       if (component->language)
       {
-        resp->addString(x.charconvsys->Convert(component->language));
+        resp->addString(charconvsys->convert(component->language));
       }
       else
       {
@@ -2077,7 +3055,7 @@ int VompClientRRProc::processGetRecInfo()
       }
       if (component->description)
       {
-        resp->addString(x.charconvsys->Convert(component->description));
+        resp->addString(charconvsys->convert(component->description));
       }
       else
       {
@@ -2097,17 +3075,17 @@ int VompClientRRProc::processGetRecInfo()
   title = (char*)Info->Title();
   if (title) 
   {
-    resp->addString(x.charconvsys->Convert(title));
+    resp->addString(charconvsys->convertStable(title));
   }
   else
   {
-      resp->addString(x.charconvsys->Convert(recording->Name()));
+      resp->addString(charconvsys->convertStable(recording->Name()));
   }
   
   // Done. send it
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   log->log("RRProc", Log::DEBUG, "Written getrecinfo");
 
@@ -2143,7 +3121,7 @@ int VompClientRRProc::processGetRecInfo2()
     log->log("RRProc", Log::ERR, "GetRecInfo found no recording");
     resp->addULONG(0);
     resp->finalise();
-    x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+    sendResponse();
     return 1;
   }
 
@@ -2244,7 +3222,7 @@ int VompClientRRProc::processGetRecInfo2()
   log->log("RRProc", Log::DEBUG, "GRI: S: %s", summary);
   if (summary)
   {
-    resp->addString(x.charconvsys->Convert(summary));
+    resp->addString(charconvsys->convertStable(summary));
     if (newsummary) delete [] summary;
   }
   else
@@ -2284,7 +3262,7 @@ int VompClientRRProc::processGetRecInfo2()
 
       if (component->language)
       {
-        resp->addString(x.charconvsys->Convert(component->language));
+        resp->addString(charconvsys->convert(component->language));
       }
       else
       {
@@ -2292,7 +3270,7 @@ int VompClientRRProc::processGetRecInfo2()
       }
       if (component->description)
       {
-        resp->addString(x.charconvsys->Convert(component->description));
+        resp->addString(charconvsys->convert(component->description));
       }
       else
       {
@@ -2312,17 +3290,17 @@ int VompClientRRProc::processGetRecInfo2()
   title = (char*)Info->Title();
   if (title)
   {
-    resp->addString(x.charconvsys->Convert(title));
+    resp->addString(charconvsys->convertStable(title));
   }
   else
   {
-      resp->addString(x.charconvsys->Convert(recording->Name()));
+      resp->addString(charconvsys->convertStable(recording->Name()));
   }
 
   // New stuff
   if (Info->ChannelName())
   {
-    resp->addString(x.charconvsys->Convert(Info->ChannelName()));
+    resp->addString(charconvsys->convertStable(Info->ChannelName()));
   }
   else
   {
@@ -2337,7 +3315,7 @@ int VompClientRRProc::processGetRecInfo2()
   // Done. send it
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   log->log("RRProc", Log::DEBUG, "Written getrecinfo");
 
@@ -2359,7 +3337,7 @@ int VompClientRRProc::processReScanRecording()
   resp->addULLONG(x.recplayer->getLengthBytes());
   resp->addULONG(x.recplayer->getLengthFrames());
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   log->log("RRProc", Log::DEBUG, "Rescan recording, wrote new length to client");
   return 1;
 }
@@ -2410,7 +3388,7 @@ int VompClientRRProc::processGetMarks()
   }
 
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   
   log->log("RRProc", Log::DEBUG, "Written Marks list");
 
@@ -2424,7 +3402,7 @@ int VompClientRRProc::processVDRShutdown()
   cRemote::Put(kPower);
   VompClient::incClients();
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
   return 1;
 }
 
@@ -2458,7 +3436,7 @@ int VompClientRRProc::processGetRecScraperEventType()
      resp->addLONG(call.episodeId);
   }
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   return 1;
 }
@@ -2519,12 +3497,12 @@ int VompClientRRProc::processGetEventScraperEventType()
   }
     
   resp->finalise();
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   return 1;
 }
 
-#define ADDSTRING_TO_PAKET(y) if ((y)!=0)  resp->addString(x.charconvutf8->Convert(y)); else resp->addString(""); 
+#define ADDSTRING_TO_PAKET(y) if ((y)!=0)  resp->addString(charconvutf8->convert(y)); else resp->addString(""); 
 
 int VompClientRRProc::processGetScraperMovieInfo()
 {
@@ -2570,7 +3548,7 @@ int VompClientRRProc::processGetScraperMovieInfo()
    }
   resp->finalise();
   
-  x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+  sendResponse();
 
   
   return 1;
@@ -2641,7 +3619,7 @@ int VompClientRRProc::processGetScraperSeriesInfo()
    
    resp->finalise();
 
-   x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+   sendResponse();
    
    return 1;
 }
@@ -2662,7 +3640,7 @@ int VompClientRRProc::processLoadTvMedia()
    
    resp->finalise();
 
-   x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+   sendResponse();
    
    return 1;
 }
@@ -2684,7 +3662,7 @@ int VompClientRRProc::processLoadTvMediaRecThumb()
    
    resp->finalise();
 
-   x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+   sendResponse();
    
    return 1;
 }
@@ -2717,7 +3695,7 @@ int VompClientRRProc::processLoadTvMediaEventThumb()
    
    resp->finalise();
 
-   x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+   sendResponse();
    
    return 1;
 }
@@ -2750,7 +3728,7 @@ int VompClientRRProc::processLoadChannelLogo()
    
    resp->finalise();
 
-   x.tcp.sendPacket(resp->getPtr(), resp->getLen());
+   sendResponse();
    
    return 1;
 }
@@ -23,8 +23,11 @@
 
 #include "thread.h"
 #include "responsepacket.h"
-#include <queue>
+#include <deque>
+#include <vector>
+#include <pthread.h>
 #include "serialize.h"
+#include "charsetconv.h"
 
 extern bool ResumeIDLock;
 
@@ -33,24 +36,80 @@ using namespace std;
 class VompClient;
 class Log;
 
+class RequestPacketPool;
+
 class RequestPacket
 {
+  friend class RequestPacketPool;
+
   public:
     RequestPacket(ULONG requestID, ULONG opcode, UCHAR* data, ULONG dataLength)
-     : requestID(requestID), opcode(opcode), data(data), dataLength(dataLength) {}
+     : requestID(requestID), opcode(opcode), data(data), dataLength(dataLength),
+       receivedUs(0), pool(NULL), smallBuffer(NULL) {}
     
     ULONG requestID;
     ULONG opcode;
-    UCHAR* data;
+    UCHAR* data;       // malloc'd, or owned by the pool. NULL if dataLength is 0
     ULONG dataLength;
+    ULLONG receivedUs; // Stats::nowUs() when it came off the socket
+
+    // Frees the packet and its data, or hands them back to the pool
+    void release();
+
+  private:
+    RequestPacketPool* pool;
+    UCHAR* smallBuffer; // pool packets only, reused for small payloads
 };
 
-typedef queue<RequestPacket*> RequestPacketQueue;
+/*
+  Per connection pool of RequestPackets. Each pooled packet keeps a buffer
+  big enough for the usual small request payloads, so in steady state the
+  inbound path does no malloc at all. Payloads above smallDataSize get a
+  buffer of their own which is freed on release. Payloads are always NUL
+  terminated one byte past dataLength.
+*/
+
+class RequestPacketPool
+{
+  public:
+    RequestPacketPool();
+    ~RequestPacketPool();
+
+    // Returns NULL on allocation failure
+    RequestPacket* get(ULONG requestID, ULONG opcode, ULONG dataLength);
+    void put(RequestPacket* packet);
+
+  private:
+    pthread_mutex_t poolLock;
+    std::vector<RequestPacket*> freePackets;
+
+    const static ULONG maxPooled = 16;
+    const static ULONG smallDataSize = 4096;
+};
+
+typedef deque<RequestPacket*> RequestPacketQueue;
+
+/*
+  Each client has one serial VompClientRRProc and a couple of parallel ones
+  (see VompClient::dispatchRequest). Opcodes are classified as:
+
+    OPCLASS_INDEPENDENT  reads VDR state only, may run on a parallel worker
+                         concurrently with anything else except a barrier
+    OPCLASS_SERIAL       uses per client playback/media state or the scraper
+                         plugin, runs in order on the serial worker
+    OPCLASS_BARRIER      changes state the others may read (login, charset,
+                         config, timers, recordings). Runs on the serial
+                         worker once no parallel requests are in flight;
+                         independent requests that arrive meanwhile queue
+                         behind it on the serial worker.
+
+  Unknown opcodes are barriers.
+*/
 
 class VompClientRRProc : public Thread
 {
   public:
-    VompClientRRProc(VompClient& x);
+    VompClientRRProc(VompClient& x, bool parallelWorker = false);
     ~VompClientRRProc();
     static ULONG getProtocolVersionMin();
     static ULONG getProtocolVersionMax();
@@ -58,9 +117,33 @@ class VompClientRRProc : public Thread
     bool init();
     bool recvRequest(RequestPacket*);
 
+    // VDR_CANCELREQUESTS. Drops matching requests still in the queue, they
+    // get no reply. Returns the number dropped.
+    const static ULONG CANCEL_REQUEST = 1;         // the one with this requestID
+    const static ULONG CANCEL_GETBLOCKS_BEFORE = 2; // getblocks with a lower requestID
+    int cancelQueued(ULONG mode, ULONG requestID);
+
+    const static ULONG MAX_GRID_CHANNELS = 1000;
+    const static UINT GRID_PARALLEL_EVENTS = 2000; // fewer are serialized by one thread
+    const static UINT GRID_MAX_FILLERS = 3;        // extra threads
+
+    // Event flags in VDR_GETEPGGRIDHEADERS replies
+    const static ULONG EPG_FLAG_DESCRIPTION = 1; // there is a description to fetch
+    const static ULONG EPG_FLAG_SHORTTEXT   = 2; // there is a short text
+
+    const static int OPCLASS_INDEPENDENT = 0;
+    const static int OPCLASS_SERIAL      = 1;
+    const static int OPCLASS_BARRIER     = 2;
+    static int classifyOpcode(ULONG opcode);
+
   private:
+    bool runPacket();
     bool processPacket();
+    void requestFinished(ULONG opcode);
+    void failQueued();
+    void updateCharset();
     void sendPacket(SerializeBuffer *b);
+    void sendResponse();
   
 #ifndef VOMPSTANDALONE
     int processGetRecordingsList();
@@ -70,9 +153,16 @@ class VompClientRRProc : public Thread
     int processGetChannelsList();
     int processStartStreamingChannel();
     int processGetBlock();
+    ULONG takeContiguousGetBlocks(ULLONG position, ULONG amount, std::vector<RequestPacket*>& following);
+    const static ULONG maxCoalescedGetBlocks = 8;
+    const static ULONG maxCoalescedBytes = 1000000; // RecPlayer::getBlock limit
     int processStopStreaming();
     int processStartStreamingRecording();
     int processGetChannelSchedule();
+    int processGetEpgGrid(bool headersOnly);
+    int processGetEpgGridSync();
+    int processGetEventDescriptions();
+    const static ULONG MAX_DESCRIPTION_EVENTS = 1000;
     int processGetTimers();
     int processSetTimer();
     int processPositionFromFrameNumber();
@@ -98,6 +188,8 @@ class VompClientRRProc : public Thread
     int processLogin();
     int processConfigSave();
     int processConfigLoad();
+    int processConfigSaveBatch();
+    int processConfigLoadBatch();
     int processGetMediaList();
     int processOpenMedia();
     int processGetMediaBlock();
@@ -113,6 +205,16 @@ class VompClientRRProc : public Thread
     RequestPacket* req;
     RequestPacketQueue req_queue;
     ResponsePacket* resp;
+    ResponsePacketPool respPool;
+    bool parallelWorker;
+    bool failed;
+
+    // Per worker converters, they are not thread safe
+    int charcoding;
+    CharsetConv* charconvutf8;
+    CharsetConv* charconvsys;
+    ULONG responseSizeHint();
+    bool splitRequestStrings(std::vector<const char*>& strings);
     static ULONG VOMP_PROTOCOL_VERSION_MIN;
     static ULONG VOMP_PROTOCOL_VERSION_MAX;
     
@@ -0,0 +1,885 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Load generator for vompserver. Not part of the plugin, build with
+  "make loadgen" and run ./vompload -h for the options.
+
+  Each simulated client is a thread with its own connection doing what a
+  client does when it is used: log in, fetch the recordings and channel
+  lists, page through schedules, load channel logos and then play a
+  recording with a steady stream of VDR_GETBLOCKs. With -M the lists and
+  playback use the media opcodes instead, which is what a standalone
+  server can serve.
+
+  Requests are sent one at a time per client, like the real client does,
+  so the per opcode latencies are end to end times as a client sees them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <vector>
+#include <string>
+
+#include "defines.h"
+#include "thread.h"
+#include "stats.h"
+#include "vdrcommand.h"
+#include "media.h"
+#include "mediaproviderids.h"
+
+// ---- Options -----------------------------------------------------------------
+
+static const char* optHost = "127.0.0.1";
+static int optPort = 3024;
+static int optClients = 10;
+static int optDuration = 30;        // seconds
+static int optScheduleChannels = 10;
+static int optLogos = 5;
+static ULONG optBlockSize = 100000;
+static int optBlocksPerPlay = 300;
+static int optBlockIntervalMs = 0;  // 0 = as fast as the server answers
+static int optTimeout = 10;         // seconds per request
+static bool optMedia = false;
+static int optMetricsPort = 0;      // server's metrics endpoint, 0 = don't read it
+static int optHangupEvery = 0;      // sessions, 0 = never hang up with replies in flight
+
+// ---- Results -----------------------------------------------------------------
+
+/*
+  Shared by all client threads, updated with atomic adds only.
+  Slot MAX_OPCODE + 1 counts everything above MAX_OPCODE.
+*/
+
+struct OpcodeResult
+{
+  OpcodeResult() : requests(0), errors(0), bytes(0) {}
+
+  ULLONG requests;
+  ULLONG errors;
+  ULLONG bytes;
+  LatencyHistogram latency;
+};
+
+static OpcodeResult results[Stats::MAX_OPCODE + 2];
+static ULLONG connectFailures = 0;
+static ULLONG disconnects = 0;
+static ULLONG hangups = 0;
+
+static OpcodeResult* resultFor(ULONG opcode)
+{
+  if (opcode > Stats::MAX_OPCODE) opcode = Stats::MAX_OPCODE + 1;
+  return &results[opcode];
+}
+
+static const char* opcodeName(ULONG opcode)
+{
+  switch(opcode)
+  {
+    case VDR_LOGIN:              return "login";
+    case VDR_GETRECORDINGLIST:   return "recordings list";
+    case VDR_GETCHANNELLIST:     return "channel list";
+    case VDR_STOPSTREAMING:      return "stop streaming";
+    case VDR_STREAMRECORDING:    return "stream recording";
+    case VDR_GETBLOCK:           return "getblock";
+    case VDR_GETCHANNELSCHEDULE: return "schedule";
+    case VDR_GETMEDIALIST:       return "media list";
+    case VDR_OPENMEDIA:          return "open media";
+    case VDR_GETMEDIABLOCK:      return "media block";
+    case VDR_CLOSECHANNEL:       return "close media";
+    case VDR_LOADCHANNELLOGO:    return "channel logo";
+    default:                     return "";
+  }
+}
+
+// ---- Connection --------------------------------------------------------------
+
+class LoadConnection
+{
+  public:
+    LoadConnection() : sock(-1), nextRequestID(1) {}
+    ~LoadConnection() { disconnect(); }
+
+    bool connectTo(const char* host, int port);
+    void disconnect();
+    bool isConnected() { return sock != -1; }
+
+    // Sends a packet on a channel the server doesn't know, which makes it
+    // drop the connection without closing the socket first, then waits
+    // and closes without having read anything
+    void hangup(int waitMs);
+
+    /*
+      Sends a request and waits for its reply, which ends up in reply.
+      With waitForPicture set it also waits for the channel 5 packet that
+      carries the picture. Records the latency and errors for the opcode.
+    */
+    bool request(ULONG opcode, const UCHAR* data, ULONG dataLength, bool waitForPicture = false);
+
+    // Sends a request without waiting for the reply
+    bool post(ULONG opcode, const UCHAR* data, ULONG dataLength);
+
+    std::vector<UCHAR> reply;
+
+  private:
+    bool readAll(void* buffer, ULONG length);
+    bool skip(ULONG length);
+    bool writeAll(const void* buffer, ULONG length);
+    bool fail(OpcodeResult* result);
+
+    int sock;
+    ULONG nextRequestID;
+};
+
+bool LoadConnection::connectTo(const char* host, int port)
+{
+  struct addrinfo hints;
+  struct addrinfo* addresses;
+  char portString[16];
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(portString, sizeof(portString), "%i", port);
+  if (getaddrinfo(host, portString, &hints, &addresses)) return false;
+
+  for (struct addrinfo* a = addresses; a; a = a->ai_next)
+  {
+    sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (sock == -1) continue;
+    if (!connect(sock, a->ai_addr, a->ai_addrlen)) break;
+    close(sock);
+    sock = -1;
+  }
+  freeaddrinfo(addresses);
+  if (sock == -1) return false;
+
+  struct timeval tv;
+  tv.tv_sec = optTimeout;
+  tv.tv_usec = 0;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  int value = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  return true;
+}
+
+void LoadConnection::disconnect()
+{
+  if (sock == -1) return;
+  close(sock);
+  sock = -1;
+}
+
+void LoadConnection::hangup(int waitMs)
+{
+  if (sock == -1) return;
+  ULONG badChannel = htonl(99);
+  writeAll(&badChannel, sizeof(badChannel));
+  usleep(waitMs * 1000);
+  disconnect();
+}
+
+bool LoadConnection::readAll(void* buffer, ULONG length)
+{
+  UCHAR* p = (UCHAR*)buffer;
+  while (length)
+  {
+    ssize_t got = recv(sock, p, length, 0);
+    if (got <= 0)
+    {
+      if ((got == -1) && (errno == EINTR)) continue;
+      return false; // closed, error or timed out
+    }
+    p += got;
+    length -= got;
+  }
+  return true;
+}
+
+bool LoadConnection::skip(ULONG length)
+{
+  UCHAR discard[16384];
+  while (length)
+  {
+    ULONG thisRead = (length > sizeof(discard)) ? sizeof(discard) : length;
+    if (!readAll(discard, thisRead)) return false;
+    length -= thisRead;
+  }
+  return true;
+}
+
+bool LoadConnection::writeAll(const void* buffer, ULONG length)
+{
+  const UCHAR* p = (const UCHAR*)buffer;
+  while (length)
+  {
+    ssize_t sent = send(sock, p, length, MSG_NOSIGNAL);
+    if (sent <= 0)
+    {
+      if ((sent == -1) && (errno == EINTR)) continue;
+      return false;
+    }
+    p += sent;
+    length -= sent;
+  }
+  return true;
+}
+
+bool LoadConnection::fail(OpcodeResult* result)
+{
+  // The server sends nothing at all for a request it fails, so a
+  // timeout leaves the stream in an unknown state. Start again.
+  Stats::add(&result->errors, 1);
+  Stats::add(&disconnects, 1);
+  disconnect();
+  return false;
+}
+
+bool LoadConnection::post(ULONG opcode, const UCHAR* data, ULONG dataLength)
+{
+  if (sock == -1) return false;
+
+  ULONG header[4];
+  header[0] = htonl(1); // RR channel
+  header[1] = htonl(nextRequestID++);
+  header[2] = htonl(opcode);
+  header[3] = htonl(dataLength);
+  if (!writeAll(header, sizeof(header))) return false;
+  return !dataLength || writeAll(data, dataLength);
+}
+
+bool LoadConnection::request(ULONG opcode, const UCHAR* data, ULONG dataLength, bool waitForPicture)
+{
+  OpcodeResult* result = resultFor(opcode);
+  if (sock == -1) return false;
+
+  ULONG requestID = nextRequestID++;
+  ULONG header[4];
+  header[0] = htonl(1); // RR channel
+  header[1] = htonl(requestID);
+  header[2] = htonl(opcode);
+  header[3] = htonl(dataLength);
+
+  ULLONG start = Stats::nowUs();
+
+  if (!writeAll(header, sizeof(header))) return fail(result);
+  if (dataLength && !writeAll(data, dataLength)) return fail(result);
+
+  bool gotReply = false;
+  bool gotPicture = !waitForPicture;
+  ULLONG bytes = 0;
+
+  while (!gotReply || !gotPicture)
+  {
+    ULONG channelID;
+    if (!readAll(&channelID, sizeof(ULONG))) return fail(result);
+    channelID = ntohl(channelID);
+
+    if (channelID == 1) // RR: requestID, length
+    {
+      ULONG rrHeader[2];
+      if (!readAll(rrHeader, sizeof(rrHeader))) return fail(result);
+      ULONG replyID = ntohl(rrHeader[0]);
+      ULONG length = ntohl(rrHeader[1]);
+      bytes += 12 + length;
+
+      if (replyID != requestID)
+      {
+        if (!skip(length)) return fail(result);
+        continue;
+      }
+
+      reply.resize(length);
+      if (length && !readAll(&reply[0], length)) return fail(result);
+      gotReply = true;
+    }
+    else if ((channelID == 2) || (channelID == 5)) // stream or picture: streamID, flag, length
+    {
+      ULONG streamHeader[3];
+      if (!readAll(streamHeader, sizeof(streamHeader))) return fail(result);
+      ULONG length = ntohl(streamHeader[2]);
+      bytes += 16 + length;
+      if (!skip(length)) return fail(result);
+      if ((channelID == 5) && (ntohl(streamHeader[0]) == requestID)) gotPicture = true;
+    }
+    else if (channelID == 3) // KA reply
+    {
+      if (!skip(sizeof(ULONG))) return fail(result);
+    }
+    else
+    {
+      fprintf(stderr, "Unknown channel %lu from server\n", (unsigned long)channelID);
+      return fail(result);
+    }
+  }
+
+  result->latency.add(Stats::nowUs() - start);
+  Stats::add(&result->requests, 1);
+  Stats::add(&result->bytes, bytes);
+  return true;
+}
+
+// ---- Reply parsing -----------------------------------------------------------
+
+class ReplyReader
+{
+  public:
+    ReplyReader(const std::vector<UCHAR>& r) : data(r.empty() ? NULL : &r[0]), length(r.size()), pos(0), ok(true) {}
+
+    ULONG getULONG()
+    {
+      if (pos + 4 > length) { ok = false; return 0; }
+      ULONG v;
+      memcpy(&v, data + pos, 4);
+      pos += 4;
+      return ntohl(v);
+    }
+
+    ULLONG getULLONG()
+    {
+      ULLONG high = getULONG();
+      return (high << 32) | getULONG();
+    }
+
+    UCHAR getUCHAR()
+    {
+      if (pos + 1 > length) { ok = false; return 0; }
+      return data[pos++];
+    }
+
+    std::string getString()
+    {
+      const UCHAR* end = (const UCHAR*)memchr(data + pos, 0, length - pos);
+      if (!end) { ok = false; pos = length; return std::string(); }
+      std::string s((const char*)data + pos, end - (data + pos));
+      pos = end - data + 1;
+      return s;
+    }
+
+    bool more() { return ok && (pos < length); }
+
+    const UCHAR* data;
+    ULONG length;
+    ULONG pos;
+    bool ok;
+};
+
+// ---- Client ------------------------------------------------------------------
+
+class LoadClient : public Thread
+{
+  public:
+    LoadClient(int tindex) : index(tindex), seed(tindex * 7919 + time(NULL)), sessions(0) {}
+    virtual ~LoadClient() {}
+
+    void start() { threadStart(); }
+    void stop() { threadStop(); }
+
+  private:
+    void threadMethod();
+
+    bool login();
+    bool vdrSession();
+    void hangup();
+    bool mediaSession();
+    bool playRecording(const std::string& fileName);
+    bool findMedia(MediaURI* dir, int depth, std::vector<MediaURI*>& found);
+    bool playMedia(MediaURI* uri);
+    void pace();
+
+    int index;
+    unsigned int seed;
+    int sessions;
+    LoadConnection conn;
+    std::vector<std::string> recordings;
+    std::vector<ULONG> channels;
+};
+
+void LoadClient::threadMethod()
+{
+  while (threadIsActive())
+  {
+    if (!conn.isConnected())
+    {
+      if (!conn.connectTo(optHost, optPort))
+      {
+        Stats::add(&connectFailures, 1);
+        sleep(1);
+        continue;
+      }
+      if (!login())
+      {
+        sleep(1);
+        continue;
+      }
+    }
+
+    if (optMedia) mediaSession();
+    else vdrSession();
+
+    if (optHangupEvery && conn.isConnected() && !(++sessions % optHangupEvery)) hangup();
+  }
+  conn.disconnect();
+}
+
+bool LoadClient::login()
+{
+  // A made up MAC per client, so each gets its own config file
+  UCHAR mac[6] = { 0x02, 0x00, 0x00, 0x00, (UCHAR)(index >> 8), (UCHAR)index };
+  if (!conn.request(VDR_LOGIN, mac, sizeof(mac))) return false;
+  if (conn.reply.size() < 16)
+  {
+    Stats::add(&resultFor(VDR_LOGIN)->errors, 1);
+    conn.disconnect();
+    return false;
+  }
+  return true;
+}
+
+/*
+  Ends the session with replies in flight: a burst of requests with big
+  replies goes out and then garbage. The server tears the client down
+  while its workers may still be answering and, as nothing is read, the
+  sender is stuck on a full socket with replies queued behind it.
+*/
+
+void LoadClient::hangup()
+{
+  ULONG gridRequest[5];
+  gridRequest[0] = htonl(time(NULL));
+  gridRequest[1] = htonl(24 * 60 * 60);
+  gridRequest[2] = htonl(0);
+  gridRequest[3] = htonl(1);
+  gridRequest[4] = htonl(channels.empty() ? 1 : channels.back());
+
+  for (int i = 0; i < 8; i++)
+  {
+    if (!conn.post(VDR_GETRECORDINGLIST, NULL, 0)) break;
+    if (!conn.post(VDR_GETCHANNELLIST, NULL, 0)) break;
+    if (!conn.post(VDR_GETEPGGRID, (UCHAR*)gridRequest, sizeof(gridRequest))) break;
+  }
+  conn.hangup(1000);
+  Stats::add(&hangups, 1);
+}
+
+void LoadClient::pace()
+{
+  if (optBlockIntervalMs) usleep(optBlockIntervalMs * 1000);
+}
+
+bool LoadClient::vdrSession()
+{
+  // Lists
+
+  if (!conn.request(VDR_GETRECORDINGLIST, NULL, 0)) return false;
+  recordings.clear();
+  ReplyReader rr(conn.reply);
+  rr.getULONG(); rr.getULONG(); rr.getULONG(); // total, free, percent
+  while (rr.more())
+  {
+    rr.getULONG(); // start
+    rr.getUCHAR(); // new
+    rr.getString(); // name
+    std::string fileName = rr.getString();
+    if (rr.ok) recordings.push_back(fileName);
+  }
+
+  if (!conn.request(VDR_GETCHANNELLIST, NULL, 0)) return false;
+  channels.clear();
+  ReplyReader cr(conn.reply);
+  while (cr.more())
+  {
+    ULONG number = cr.getULONG();
+    cr.getULONG(); // type
+    cr.getString(); // name
+    cr.getULONG(); // vtype
+    if (cr.ok) channels.push_back(number);
+  }
+
+  // EPG, three hours from now for the first few channels
+
+  ULONG now = time(NULL);
+  for (int i = 0; (i < optScheduleChannels) && (i < (int)channels.size()) && threadIsActive(); i++)
+  {
+    ULONG scheduleRequest[3];
+    scheduleRequest[0] = htonl(channels[i]);
+    scheduleRequest[1] = htonl(now);
+    scheduleRequest[2] = htonl(3 * 60 * 60);
+    if (!conn.request(VDR_GETCHANNELSCHEDULE, (UCHAR*)scheduleRequest, sizeof(scheduleRequest))) return false;
+  }
+
+  // Pictures
+
+  for (int i = 0; (i < optLogos) && !channels.empty() && threadIsActive(); i++)
+  {
+    ULONG logoRequest = htonl(channels[rand_r(&seed) % channels.size()]);
+    if (!conn.request(VDR_LOADCHANNELLOGO, (UCHAR*)&logoRequest, sizeof(logoRequest), true)) return false;
+  }
+
+  // Playback
+
+  if (!recordings.empty() && threadIsActive())
+    return playRecording(recordings[rand_r(&seed) % recordings.size()]);
+
+  return true;
+}
+
+bool LoadClient::playRecording(const std::string& fileName)
+{
+  if (!conn.request(VDR_STREAMRECORDING, (const UCHAR*)fileName.c_str(), fileName.size() + 1)) return false;
+
+  ReplyReader sr(conn.reply);
+  ULLONG lengthBytes = sr.getULLONG();
+  if (!sr.ok || !lengthBytes) return true; // recording went away
+
+  ULLONG position = 0;
+  for (int i = 0; (i < optBlocksPerPlay) && threadIsActive(); i++)
+  {
+    if (position >= lengthBytes) position = 0;
+
+    UCHAR blockRequest[12];
+    ULONG high = htonl((ULONG)(position >> 32));
+    ULONG low = htonl((ULONG)position);
+    ULONG amount = htonl(optBlockSize);
+    memcpy(&blockRequest[0], &high, 4);
+    memcpy(&blockRequest[4], &low, 4);
+    memcpy(&blockRequest[8], &amount, 4);
+
+    if (!conn.request(VDR_GETBLOCK, blockRequest, sizeof(blockRequest))) return false;
+    if (conn.reply.size() <= 4) break; // 4 byte reply means nothing read
+    position += conn.reply.size();
+    pace();
+  }
+
+  return conn.request(VDR_STOPSTREAMING, NULL, 0);
+}
+
+bool LoadClient::mediaSession()
+{
+  MediaURI root(0, NULL, NULL);
+  std::vector<MediaURI*> found;
+  bool ok = findMedia(&root, 0, found);
+
+  if (ok && !found.empty() && threadIsActive())
+    ok = playMedia(found[rand_r(&seed) % found.size()]);
+
+  for (UINT i = 0; i < found.size(); i++) delete found[i];
+
+  // Nothing to play, don't spin on the list requests
+  if (ok && found.empty()) sleep(1);
+  return ok;
+}
+
+bool LoadClient::findMedia(MediaURI* dir, int depth, std::vector<MediaURI*>& found)
+{
+  SerializeBuffer request(1024, false, true);
+  VDR_GetMediaListRequest listRequest(dir);
+  if (listRequest.serialize(&request) != 0) return false;
+  if (!conn.request(VDR_GETMEDIALIST, request.getStart(), request.getCurrent() - request.getStart())) return false;
+
+  if (conn.reply.empty()) return true;
+  SerializeBuffer replyBuffer(&conn.reply[0], conn.reply.size());
+  ULONG flags = 0;
+  MediaList list(NULL);
+  VDR_GetMediaListResponse listResponse(&flags, &list);
+  if (listResponse.deserialize(&replyBuffer) != 0)
+  {
+    Stats::add(&resultFor(VDR_GETMEDIALIST)->errors, 1);
+    return true;
+  }
+
+  for (UINT i = 0; (i < list.size()) && threadIsActive(); i++)
+  {
+    Media* m = list[i];
+    if (m->getMediaType() & (MEDIA_TYPE_VIDEO | MEDIA_TYPE_AUDIO))
+    {
+      found.push_back(list.getURI(m));
+    }
+    else if ((m->getMediaType() == MEDIA_TYPE_DIR) && (depth < 2) && (found.size() < 50))
+    {
+      MediaURI* sub = list.getURI(m);
+      bool ok = findMedia(sub, depth + 1, found);
+      delete sub;
+      if (!ok) return false;
+    }
+  }
+  return true;
+}
+
+bool LoadClient::playMedia(MediaURI* uri)
+{
+  ULONG channel = 1;
+  ULONG xsize = 720;
+  ULONG ysize = 576;
+
+  SerializeBuffer openBuffer(1024, false, true);
+  VDR_OpenMediumRequest openRequest(&channel, uri, &xsize, &ysize);
+  if (openRequest.serialize(&openBuffer) != 0) return false;
+  if (!conn.request(VDR_OPENMEDIA, openBuffer.getStart(), openBuffer.getCurrent() - openBuffer.getStart())) return false;
+
+  ULONG flags = 1;
+  ULLONG size = 0;
+  if (!conn.reply.empty())
+  {
+    SerializeBuffer replyBuffer(&conn.reply[0], conn.reply.size());
+    VDR_OpenMediumResponse openResponse(&flags, &size);
+    if (openResponse.deserialize(&replyBuffer) != 0) flags = 1;
+  }
+  if (flags)
+  {
+    Stats::add(&resultFor(VDR_OPENMEDIA)->errors, 1);
+    return true;
+  }
+
+  ULLONG position = 0;
+  for (int i = 0; (i < optBlocksPerPlay) && threadIsActive(); i++)
+  {
+    if (size && (position >= size)) position = 0;
+
+    ULONG amount = optBlockSize;
+    SerializeBuffer blockBuffer(64, false, true);
+    VDR_GetMediaBlockRequest blockRequest(&channel, &position, &amount);
+    if (blockRequest.serialize(&blockBuffer) != 0) return false;
+    if (!conn.request(VDR_GETMEDIABLOCK, blockBuffer.getStart(), blockBuffer.getCurrent() - blockBuffer.getStart())) return false;
+    if (conn.reply.empty()) break;
+    position += conn.reply.size();
+    pace();
+  }
+
+  SerializeBuffer closeBuffer(64, false, true);
+  VDR_CloseMediaChannelRequest closeRequest(&channel);
+  if (closeRequest.serialize(&closeBuffer) != 0) return false;
+  return conn.request(VDR_CLOSECHANNEL, closeBuffer.getStart(), closeBuffer.getCurrent() - closeBuffer.getStart());
+}
+
+// ---- Server counters ---------------------------------------------------------
+
+/*
+  Totals the server exports on its metrics endpoint, read before and
+  after the run so the report can show what the load cost the server.
+  The endpoint only listens on loopback, so this works when vompload runs
+  on the server's machine.
+*/
+
+struct ServerCounters
+{
+  ULLONG requests;
+  ULLONG readSyscalls;
+  ULLONG writeSyscalls;
+};
+
+static bool readServerCounters(ServerCounters& counters)
+{
+  struct addrinfo hints;
+  struct addrinfo* addresses;
+  char portString[16];
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(portString, sizeof(portString), "%i", optMetricsPort);
+  if (getaddrinfo(optHost, portString, &hints, &addresses)) return false;
+
+  int sock = -1;
+  for (struct addrinfo* a = addresses; a; a = a->ai_next)
+  {
+    sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (sock == -1) continue;
+    if (!connect(sock, a->ai_addr, a->ai_addrlen)) break;
+    close(sock);
+    sock = -1;
+  }
+  freeaddrinfo(addresses);
+  if (sock == -1) return false;
+
+  struct timeval tv;
+  tv.tv_sec = optTimeout;
+  tv.tv_usec = 0;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  const char* request = "GET /metrics HTTP/1.0\r\n\r\n";
+  if (send(sock, request, strlen(request), MSG_NOSIGNAL) != (ssize_t)strlen(request))
+  {
+    close(sock);
+    return false;
+  }
+
+  std::string response;
+  char buffer[4096];
+  ssize_t got;
+  while ((got = recv(sock, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, got);
+  close(sock);
+
+  const char* names[3] = { "vomp_received_requests_total ", "vomp_read_syscalls_total ", "vomp_write_syscalls_total " };
+  ULLONG* values[3] = { &counters.requests, &counters.readSyscalls, &counters.writeSyscalls };
+  for (int n = 0; n < 3; n++)
+  {
+    size_t at = response.find(std::string("\n") + names[n]);
+    if (at == std::string::npos) return false;
+    *values[n] = strtoull(response.c_str() + at + 1 + strlen(names[n]), NULL, 10);
+  }
+  return true;
+}
+
+// ---- Report ------------------------------------------------------------------
+
+static void report(double seconds, const ServerCounters* before, const ServerCounters* after)
+{
+  ULLONG totalRequests = 0;
+  ULLONG totalErrors = 0;
+  ULLONG totalBytes = 0;
+
+  printf("\n%-6s %-16s %10s %8s %10s %10s %10s %10s %10s\n",
+         "opcode", "", "requests", "errors", "req/s", "MB/s", "p50 ms", "p99 ms", "max ms");
+
+  for (ULONG op = 0; op <= (Stats::MAX_OPCODE + 1); op++)
+  {
+    OpcodeResult& r = results[op];
+    if (!r.requests && !r.errors) continue;
+
+    char opString[16];
+    if (op > Stats::MAX_OPCODE) snprintf(opString, sizeof(opString), "other");
+    else snprintf(opString, sizeof(opString), "%lu", (unsigned long)op);
+
+    printf("%-6s %-16s %10llu %8llu %10.1f %10.2f %10.2f %10.2f %10.2f\n",
+           opString, opcodeName(op), (unsigned long long)r.requests, (unsigned long long)r.errors,
+           r.requests / seconds, r.bytes / seconds / 1000000.0,
+           r.latency.percentile(0.5) / 1000.0, r.latency.percentile(0.99) / 1000.0, r.latency.maxUs / 1000.0);
+
+    totalRequests += r.requests;
+    totalErrors += r.errors;
+    totalBytes += r.bytes;
+  }
+
+  printf("\n%i clients, %.1f s: %llu requests (%.1f/s), %llu errors, %.2f MB/s received, %llu reconnects, %llu failed connects\n",
+         optClients, seconds, (unsigned long long)totalRequests, totalRequests / seconds, (unsigned long long)totalErrors,
+         totalBytes / seconds / 1000000.0, (unsigned long long)disconnects, (unsigned long long)connectFailures);
+  if (optHangupEvery) printf("%llu hangups with replies in flight\n", (unsigned long long)hangups);
+
+  if (before && after)
+  {
+    ULLONG requests = after->requests - before->requests;
+    ULLONG reads = after->readSyscalls - before->readSyscalls;
+    ULLONG writes = after->writeSyscalls - before->writeSyscalls;
+    printf("Server: %llu requests, %llu read syscalls (%.2f per request), %llu write syscalls (%.2f per request)\n",
+           (unsigned long long)requests, (unsigned long long)reads, requests ? (double)reads / requests : 0.0,
+           (unsigned long long)writes, requests ? (double)writes / requests : 0.0);
+  }
+}
+
+// ---- main --------------------------------------------------------------------
+
+static void usage()
+{
+  printf("Usage: vompload [options]\n"
+         "  -H host     server address (%s)\n"
+         "  -p port     server TCP port (%i)\n"
+         "  -c clients  concurrent clients (%i)\n"
+         "  -d seconds  test duration (%i)\n"
+         "  -s n        schedules fetched per session (%i)\n"
+         "  -l n        channel logos loaded per session (%i)\n"
+         "  -b bytes    getblock size (%lu)\n"
+         "  -n n        getblocks per playback (%i)\n"
+         "  -i ms       pause between getblocks, 0 for flat out (%i)\n"
+         "  -t seconds  request timeout (%i)\n"
+         "  -M          use the media opcodes, for a standalone server\n"
+         "  -m port     read the server's syscall counters from its metrics port\n"
+         "  -k n        every n sessions hang up with replies in flight, 0 never\n",
+         optHost, optPort, optClients, optDuration, optScheduleChannels, optLogos,
+         (unsigned long)optBlockSize, optBlocksPerPlay, optBlockIntervalMs, optTimeout);
+}
+
+int main(int argc, char** argv)
+{
+  int c;
+  while ((c = getopt(argc, argv, "H:p:c:d:s:l:b:n:i:t:m:k:Mh")) != -1)
+  {
+    switch(c)
+    {
+      case 'H': optHost = optarg; break;
+      case 'p': optPort = atoi(optarg); break;
+      case 'c': optClients = atoi(optarg); break;
+      case 'd': optDuration = atoi(optarg); break;
+      case 's': optScheduleChannels = atoi(optarg); break;
+      case 'l': optLogos = atoi(optarg); break;
+      case 'b': optBlockSize = strtoul(optarg, NULL, 10); break;
+      case 'n': optBlocksPerPlay = atoi(optarg); break;
+      case 'i': optBlockIntervalMs = atoi(optarg); break;
+      case 't': optTimeout = atoi(optarg); break;
+      case 'M': optMedia = true; break;
+      case 'm': optMetricsPort = atoi(optarg); break;
+      case 'k': optHangupEvery = atoi(optarg); break;
+      default: usage(); return 1;
+    }
+  }
+
+  if ((optClients < 1) || (optDuration < 1) || (optTimeout < 1))
+  {
+    usage();
+    return 1;
+  }
+
+  printf("%i clients against %s:%i for %i s\n", optClients, optHost, optPort, optDuration);
+
+  ServerCounters before;
+  bool haveBefore = optMetricsPort && readServerCounters(before);
+  if (optMetricsPort && !haveBefore) fprintf(stderr, "Could not read the server's metrics on port %i\n", optMetricsPort);
+
+  std::vector<LoadClient*> clients;
+  for (int i = 0; i < optClients; i++)
+  {
+    LoadClient* client = new LoadClient(i);
+    client->start();
+    clients.push_back(client);
+  }
+
+  ULLONG start = Stats::nowUs();
+  ULLONG lastRequests = 0;
+  for (int s = 1; s <= optDuration; s++)
+  {
+    sleep(1);
+    ULLONG requests = 0;
+    for (ULONG op = 0; op <= (Stats::MAX_OPCODE + 1); op++) requests += results[op].requests;
+    printf("\r%3i s  %8llu req/s ", s, (unsigned long long)(requests - lastRequests));
+    fflush(stdout);
+    lastRequests = requests;
+  }
+
+  // Clients finish the request they are in, so wait for them before
+  // taking the time
+  for (UINT i = 0; i < clients.size(); i++) clients[i]->stop();
+  double seconds = (Stats::nowUs() - start) / 1000000.0;
+  for (UINT i = 0; i < clients.size(); i++) delete clients[i];
+
+  ServerCounters after;
+  bool haveAfter = haveBefore && readServerCounters(after);
+  report(seconds, haveBefore ? &before : NULL, haveAfter ? &after : NULL);
+  return 0;
+}
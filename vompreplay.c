@@ -0,0 +1,497 @@
+/*
+    Copyright 2026 The VOMP authors
+
+    This file is part of VOMP.
+
+    VOMP is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    VOMP is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VOMP; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Replays connection traces recorded with "Trace directory" (see trace.h)
+  against a server. Not part of the plugin, build with "make loadgen" and
+  run ./vompreplay -h for the options.
+
+  Each trace is replayed on its own connection, all of them starting
+  together; -c runs several copies of each. Requests go out with their
+  recorded spacing (scaled with -x), or with -a as fast as possible: then
+  each request waits for the reply to the one before if the trace has one,
+  so the server sees the same sequence every run. Either way a login
+  waits for its reply, the server drops anyone who sends requests before
+  being logged in, and recorded timing then continues from the reply.
+
+  Replies are matched to requests by ID and their sizes compared with the
+  recorded ones. Stream, picture and keepalive packets are read and dropped.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <vector>
+#include <map>
+#include <string>
+
+#include "defines.h"
+#include "thread.h"
+#include "stats.h"
+#include "trace.h"
+#include "vdrcommand.h"
+
+// ---- Options -----------------------------------------------------------------
+
+static const char* optHost = "127.0.0.1";
+static int optPort = 3024;
+static bool optAsap = false;
+static double optSpeed = 1.0;
+static int optCopies = 1;
+static int optTimeout = 10; // seconds to wait for a reply
+
+// ---- Results -----------------------------------------------------------------
+
+// Shared by all sessions, updated with atomic adds only
+struct OpcodeResult
+{
+  OpcodeResult() : requests(0), replies(0), missing(0), sizeMismatches(0), bytes(0) {}
+
+  ULLONG requests;
+  ULLONG replies;
+  ULLONG missing;        // recorded with a reply, none came
+  ULLONG sizeMismatches; // reply size differs from the recorded one
+  ULLONG bytes;
+  LatencyHistogram latency;
+};
+
+static OpcodeResult results[Stats::MAX_OPCODE + 2];
+static ULLONG unexpectedReplies = 0;
+static ULLONG connectFailures = 0;
+static ULLONG streamBytes = 0;
+
+static OpcodeResult* resultFor(ULONG opcode)
+{
+  if (opcode > Stats::MAX_OPCODE) opcode = Stats::MAX_OPCODE + 1;
+  return &results[opcode];
+}
+
+// ---- Session -----------------------------------------------------------------
+
+class ReplaySession : public Thread
+{
+  public:
+    ReplaySession(const std::vector<TraceRecord>* trecords) : records(trecords), sock(-1), done(false) {}
+    virtual ~ReplaySession() { if (sock != -1) close(sock); }
+
+    void start() { threadStart(); }
+    void wait() { threadStop(); }
+    bool isDone() { return done; }
+
+  private:
+    struct Pending
+    {
+      ULONG opcode;
+      ULLONG sentUs;
+      bool expectReply;
+      ULONG expectedLength;
+    };
+
+    void threadMethod();
+    bool connectToServer();
+    bool sendRequest(const TraceRecord& r);
+    bool receive(int timeoutMs);
+    void parse();
+    void gotReply(ULONG requestID, ULONG length);
+    void expire(ULLONG now, bool all);
+
+    const std::vector<TraceRecord>* records;
+    std::map<ULONG, const TraceRecord*> recordedReplies; // by requestID, for requests that had one
+    std::map<ULONG, Pending> pending;
+    std::vector<UCHAR> in;
+    int sock;
+    volatile bool done;
+};
+
+bool ReplaySession::connectToServer()
+{
+  struct addrinfo hints;
+  struct addrinfo* addresses;
+  char portString[16];
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(portString, sizeof(portString), "%i", optPort);
+  if (getaddrinfo(optHost, portString, &hints, &addresses)) return false;
+
+  for (struct addrinfo* a = addresses; a; a = a->ai_next)
+  {
+    sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (sock == -1) continue;
+    if (!connect(sock, a->ai_addr, a->ai_addrlen)) break;
+    close(sock);
+    sock = -1;
+  }
+  freeaddrinfo(addresses);
+  if (sock == -1) return false;
+
+  int value = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  return true;
+}
+
+bool ReplaySession::sendRequest(const TraceRecord& r)
+{
+  ULONG header[4];
+  header[0] = htonl(1); // RR channel
+  header[1] = htonl(r.requestID);
+  header[2] = htonl(r.opcode);
+  header[3] = htonl(r.length);
+
+  std::vector<UCHAR> packet(sizeof(header) + r.length);
+  memcpy(&packet[0], header, sizeof(header));
+  if (r.length) memcpy(&packet[sizeof(header)], &r.data[0], r.length);
+
+  // Blocking send, but keep reading meanwhile so a server busy sending to
+  // us can't deadlock against a full socket buffer
+  ULONG sent = 0;
+  while (sent < packet.size())
+  {
+    ssize_t n = send(sock, &packet[sent], packet.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0)
+    {
+      sent += n;
+      continue;
+    }
+    if ((n == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) return false;
+    if (!receive(10)) return false;
+  }
+
+  Pending p;
+  p.opcode = r.opcode;
+  p.sentUs = Stats::nowUs();
+  std::map<ULONG, const TraceRecord*>::iterator i = recordedReplies.find(r.requestID);
+  p.expectReply = (i != recordedReplies.end());
+  p.expectedLength = p.expectReply ? i->second->length : 0;
+  pending[r.requestID] = p;
+  Stats::add(&resultFor(r.opcode)->requests, 1);
+  return true;
+}
+
+// Waits up to timeoutMs for data and parses whatever complete packets arrived
+bool ReplaySession::receive(int timeoutMs)
+{
+  struct pollfd pfd;
+  pfd.fd = sock;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  int r = poll(&pfd, 1, timeoutMs);
+  if (r < 0) return errno == EINTR;
+  if (r == 0) return true;
+
+  UCHAR buffer[65536];
+  ssize_t n = recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+  if (n == 0) return false; // server closed
+  if (n < 0) return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+  in.insert(in.end(), buffer, buffer + n);
+  parse();
+  return true;
+}
+
+static ULONG peekULONG(const std::vector<UCHAR>& v, ULONG pos)
+{
+  ULONG x;
+  memcpy(&x, &v[pos], 4);
+  return ntohl(x);
+}
+
+void ReplaySession::parse()
+{
+  ULONG pos = 0;
+  while (in.size() - pos >= 8)
+  {
+    ULONG channelID = peekULONG(in, pos);
+    ULONG packetLength;
+    if (channelID == 1) // requestID, length
+    {
+      if (in.size() - pos < 12) break;
+      packetLength = 12 + peekULONG(in, pos + 8);
+      if (in.size() - pos < packetLength) break;
+      gotReply(peekULONG(in, pos + 4), packetLength - 12);
+    }
+    else if ((channelID == 2) || (channelID == 5)) // streamID, flag, length
+    {
+      if (in.size() - pos < 16) break;
+      packetLength = 16 + peekULONG(in, pos + 12);
+      if (in.size() - pos < packetLength) break;
+      Stats::add(&streamBytes, packetLength);
+    }
+    else if (channelID == 3) // KA reply
+    {
+      packetLength = 8;
+    }
+    else
+    {
+      fprintf(stderr, "Unknown channel %lu from server\n", (unsigned long)channelID);
+      in.clear();
+      return;
+    }
+    pos += packetLength;
+  }
+  in.erase(in.begin(), in.begin() + pos);
+}
+
+void ReplaySession::gotReply(ULONG requestID, ULONG length)
+{
+  std::map<ULONG, Pending>::iterator i = pending.find(requestID);
+  if (i == pending.end())
+  {
+    Stats::add(&unexpectedReplies, 1);
+    return;
+  }
+
+  OpcodeResult* result = resultFor(i->second.opcode);
+  result->latency.add(Stats::nowUs() - i->second.sentUs);
+  Stats::add(&result->replies, 1);
+  Stats::add(&result->bytes, 12 + length);
+  if (!i->second.expectReply) Stats::add(&unexpectedReplies, 1);
+  else if (length != i->second.expectedLength) Stats::add(&result->sizeMismatches, 1);
+  pending.erase(i);
+}
+
+// Gives up on replies older than the timeout, or on all of them at the end
+void ReplaySession::expire(ULLONG now, bool all)
+{
+  std::map<ULONG, Pending>::iterator i = pending.begin();
+  while (i != pending.end())
+  {
+    if (!i->second.expectReply)
+    {
+      // Nothing was recorded for it, so there is nothing to wait for
+      pending.erase(i++);
+    }
+    else if (all || ((now - i->second.sentUs) > ((ULLONG)optTimeout * 1000000)))
+    {
+      Stats::add(&resultFor(i->second.opcode)->missing, 1);
+      pending.erase(i++);
+    }
+    else
+    {
+      ++i;
+    }
+  }
+}
+
+void ReplaySession::threadMethod()
+{
+  for (UINT i = 0; i < records->size(); i++)
+  {
+    const TraceRecord& r = (*records)[i];
+    if (r.type == RequestTrace::TYPE_RESPONSE) recordedReplies[r.requestID] = &r;
+  }
+
+  if (!connectToServer())
+  {
+    Stats::add(&connectFailures, 1);
+    done = true;
+    return;
+  }
+
+  ULLONG start = Stats::nowUs();
+  bool ok = true;
+  ULONG lastRequestID = 0;
+  bool waitForLast = false;
+
+  for (UINT i = 0; ok && (i < records->size()) && threadIsActive(); i++)
+  {
+    const TraceRecord& r = (*records)[i];
+    if (r.type != RequestTrace::TYPE_REQUEST) continue;
+
+    if (optAsap)
+    {
+      // Wait for the previous reply, if it is going to come
+      ULLONG waitStart = Stats::nowUs();
+      while (ok && waitForLast && pending.count(lastRequestID) && threadIsActive())
+      {
+        if ((Stats::nowUs() - waitStart) > ((ULLONG)optTimeout * 1000000)) break;
+        ok = receive(100);
+      }
+    }
+    else
+    {
+      ULLONG due = start + (ULLONG)(r.timeUs / optSpeed);
+      ULLONG now;
+      while (ok && ((now = Stats::nowUs()) < due) && threadIsActive())
+      {
+        ULLONG wait = due - now;
+        ok = receive((wait > 100000) ? 100 : (int)((wait + 999) / 1000));
+      }
+    }
+
+    expire(Stats::nowUs(), false);
+    if (ok) ok = sendRequest(r);
+    lastRequestID = r.requestID;
+    waitForLast = recordedReplies.count(r.requestID) > 0;
+
+    if (ok && (r.opcode == VDR_LOGIN) && waitForLast)
+    {
+      ULLONG waitStart = Stats::nowUs();
+      while (ok && pending.count(r.requestID) && threadIsActive())
+      {
+        if ((Stats::nowUs() - waitStart) > ((ULLONG)optTimeout * 1000000)) break;
+        ok = receive(100);
+      }
+      // Recorded timing carries on from when the login was answered
+      ULLONG answeredUs = recordedReplies[r.requestID]->timeUs;
+      start = Stats::nowUs() - (ULLONG)(answeredUs / optSpeed);
+    }
+  }
+
+  // Collect the outstanding replies
+  ULLONG drainStart = Stats::nowUs();
+  while (ok && !pending.empty() && threadIsActive() && ((Stats::nowUs() - drainStart) < ((ULLONG)optTimeout * 1000000)))
+  {
+    expire(Stats::nowUs(), false);
+    if (!pending.empty()) ok = receive(100);
+  }
+  expire(Stats::nowUs(), true);
+
+  close(sock);
+  sock = -1;
+  done = true;
+}
+
+// ---- Report ------------------------------------------------------------------
+
+static void report(double seconds, double recordedSeconds, int sessions)
+{
+  ULLONG totalRequests = 0;
+  ULLONG totalReplies = 0;
+  ULLONG totalMissing = 0;
+  ULLONG totalMismatches = 0;
+  ULLONG totalBytes = 0;
+
+  printf("\n%-6s %10s %10s %8s %10s %10s %10s %10s\n",
+         "opcode", "requests", "replies", "missing", "size diff", "p50 ms", "p99 ms", "max ms");
+
+  for (ULONG op = 0; op <= (Stats::MAX_OPCODE + 1); op++)
+  {
+    OpcodeResult& r = results[op];
+    if (!r.requests) continue;
+
+    char opString[16];
+    if (op > Stats::MAX_OPCODE) snprintf(opString, sizeof(opString), "other");
+    else snprintf(opString, sizeof(opString), "%lu", (unsigned long)op);
+
+    printf("%-6s %10llu %10llu %8llu %10llu %10.2f %10.2f %10.2f\n",
+           opString, (unsigned long long)r.requests, (unsigned long long)r.replies,
+           (unsigned long long)r.missing, (unsigned long long)r.sizeMismatches,
+           r.latency.percentile(0.5) / 1000.0, r.latency.percentile(0.99) / 1000.0, r.latency.maxUs / 1000.0);
+
+    totalRequests += r.requests;
+    totalReplies += r.replies;
+    totalMissing += r.missing;
+    totalMismatches += r.sizeMismatches;
+    totalBytes += r.bytes;
+  }
+
+  printf("\n%i sessions, %.1f s (recorded %.1f s): %llu requests, %llu replies, %llu missing, %llu size differences, "
+         "%llu unexpected, %.2f MB replies, %.2f MB stream, %llu failed connects\n",
+         sessions, seconds, recordedSeconds, (unsigned long long)totalRequests, (unsigned long long)totalReplies,
+         (unsigned long long)totalMissing, (unsigned long long)totalMismatches, (unsigned long long)unexpectedReplies,
+         totalBytes / 1000000.0, streamBytes / 1000000.0, (unsigned long long)connectFailures);
+}
+
+// ---- main --------------------------------------------------------------------
+
+static void usage()
+{
+  printf("Usage: vompreplay [options] trace...\n"
+         "  -H host     server address (%s)\n"
+         "  -p port     server TCP port (%i)\n"
+         "  -a          as fast as possible, each request after the previous reply\n"
+         "  -x factor   speed up recorded timing by factor (%.1f)\n"
+         "  -c copies   concurrent copies of each trace (%i)\n"
+         "  -t seconds  reply timeout (%i)\n",
+         optHost, optPort, optSpeed, optCopies, optTimeout);
+}
+
+int main(int argc, char** argv)
+{
+  int c;
+  while ((c = getopt(argc, argv, "H:p:ax:c:t:h")) != -1)
+  {
+    switch(c)
+    {
+      case 'H': optHost = optarg; break;
+      case 'p': optPort = atoi(optarg); break;
+      case 'a': optAsap = true; break;
+      case 'x': optSpeed = atof(optarg); break;
+      case 'c': optCopies = atoi(optarg); break;
+      case 't': optTimeout = atoi(optarg); break;
+      default: usage(); return 1;
+    }
+  }
+
+  if ((optind >= argc) || (optCopies < 1) || (optSpeed <= 0) || (optTimeout < 1))
+  {
+    usage();
+    return 1;
+  }
+
+  int numTraces = argc - optind;
+  std::vector<std::vector<TraceRecord> > traces(numTraces);
+  double recordedSeconds = 0;
+  for (int i = 0; i < numTraces; i++)
+  {
+    if (!RequestTrace::load(argv[optind + i], traces[i]))
+    {
+      fprintf(stderr, "Can't read trace %s\n", argv[optind + i]);
+      return 1;
+    }
+    if (!traces[i].empty() && (traces[i].back().timeUs / 1000000.0 > recordedSeconds))
+      recordedSeconds = traces[i].back().timeUs / 1000000.0;
+  }
+
+  printf("%i traces x %i against %s:%i, %s\n", numTraces, optCopies, optHost, optPort,
+         optAsap ? "as fast as possible" : "recorded timing");
+
+  std::vector<ReplaySession*> sessions;
+  ULLONG start = Stats::nowUs();
+  for (int copy = 0; copy < optCopies; copy++)
+  {
+    for (int i = 0; i < numTraces; i++)
+    {
+      ReplaySession* session = new ReplaySession(&traces[i]);
+      session->start();
+      sessions.push_back(session);
+    }
+  }
+
+  for (UINT i = 0; i < sessions.size(); i++)
+  {
+    while (!sessions[i]->isDone()) usleep(100000);
+    sessions[i]->wait();
+  }
+  double seconds = (Stats::nowUs() - start) / 1000000.0;
+  for (UINT i = 0; i < sessions.size(); i++) delete sessions[i];
+
+  report(seconds, recordedSeconds, sessions.size());
+  return 0;
+}
@@ -194,12 +194,81 @@ bool cPluginVompserver::Service(const char *Id, void *Data)
 const char **cPluginVompserver::SVDRPHelpPages(void)
 {
   // Return help text for SVDRP commands this plugin implements
-  return NULL;
+  static const char *HelpPages[] = {
+    "STAT [ JSON ]\n"
+    "    Print per opcode request counts and latencies, RecPlayer read\n"
+    "    latencies and per client traffic and live ringbuffer state.\n"
+    "    With JSON the same is printed as one JSON object.",
+    "LOGL [ <level> | <module> <level> | <module> default ]\n"
+    "    Show the log levels, or set the default level or the level of one\n"
+    "    module (RRProc, RecPlayer, TCP, Client, ...). Levels are crazy,\n"
+    "    emerg, alert, crit, err, warn, notice, info, debug or 0-8.\n"
+    "    'default' returns a module to the default level.",
+    NULL
+  };
+  return HelpPages;
 }
 
 cString cPluginVompserver::SVDRPCommand(const char *Command, const char *Option, int &ReplyCode)
 {
   // Process SVDRP commands this plugin implements
+  if (strcasecmp(Command, "STAT") == 0)
+  {
+    Stats* stats = Stats::getInstance();
+    if (!stats)
+    {
+      ReplyCode = 550;
+      return "Statistics not available";
+    }
+    bool json = Option && (strcasecmp(Option, "JSON") == 0);
+    return cString(stats->dump(json).c_str());
+  }
+  if (strcasecmp(Command, "LOGL") == 0)
+  {
+    Log* log = Log::getInstance();
+    if (!log || !log->status())
+    {
+      ReplyCode = 550;
+      return "Logging not enabled";
+    }
+
+    if (Option && *Option)
+    {
+      char module[Log::MODULE_NAME_LENGTH] = "";
+      char levelName[16] = "";
+      char format[32];
+      snprintf(format, sizeof(format), "%%%ds %%%ds", (int)sizeof(module) - 1, (int)sizeof(levelName) - 1);
+      int fields = sscanf(Option, format, module, levelName);
+      int ok;
+      if (fields < 1)
+      {
+        ok = 0;
+      }
+      else if (fields == 1)
+      {
+        int level = Log::levelFromName(module);
+        ok = (level >= 0);
+        if (ok) log->setLevel(level);
+      }
+      else if (!strcasecmp(levelName, "default"))
+      {
+        ok = log->setModuleLevel(module, -1);
+      }
+      else
+      {
+        int level = Log::levelFromName(levelName);
+        ok = (level >= 0) && log->setModuleLevel(module, level);
+      }
+
+      if (!ok)
+      {
+        ReplyCode = 501;
+        return "Unknown log level or too many modules";
+      }
+      log->log("Main", Log::INFO, "Log levels set by SVDRP: %s", Option);
+    }
+    return cString(log->dumpLevels().c_str());
+  }
   return NULL;
 }
 